@@ -0,0 +1,47 @@
+#[=======================================================================[.rst:
+FindZlibNG
+----------
+
+Find the zlib-ng compression library, built in native mode
+
+Result variables
+^^^^^^^^^^^^^^^^
+
+This module will set the following variables if found:
+
+``ZLIBNG_INCLUDE_DIRS``
+  where to find zlib-ng.h, etc.
+``ZLIBNG_LIBRARIES``
+  the libraries to link against to use libz-ng.
+``ZLIBNG_FOUND``
+  TRUE if found
+
+#]=======================================================================]
+
+find_package(PkgConfig QUIET)
+if(PKG_CONFIG_FOUND)
+  pkg_check_modules(PC_ZlibNG QUIET zlib-ng)
+endif()
+
+find_path(ZlibNG_INCLUDE_DIR NAMES zlib-ng.h
+  HINTS
+    ${PC_ZlibNG_INCLUDE_DIRS}
+)
+mark_as_advanced(ZlibNG_INCLUDE_DIR)
+
+find_library(ZlibNG_LIBRARY NAMES z-ng
+  HINTS
+    ${PC_ZlibNG_LIBRARY_DIRS}
+)
+mark_as_advanced(ZlibNG_LIBRARY)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(ZlibNG
+  REQUIRED_VARS
+    ZlibNG_LIBRARY ZlibNG_INCLUDE_DIR
+)
+
+if(ZlibNG_FOUND)
+  set(ZLIBNG_INCLUDE_DIRS ${ZlibNG_INCLUDE_DIR})
+  set(ZLIBNG_LIBRARIES ${ZlibNG_LIBRARY})
+endif()
@@ -0,0 +1,47 @@
+#[=======================================================================[.rst:
+FindZstd
+--------
+
+Find the Zstandard compression library
+
+Result variables
+^^^^^^^^^^^^^^^^
+
+This module will set the following variables if found:
+
+``ZSTD_INCLUDE_DIRS``
+  where to find zstd.h, etc.
+``ZSTD_LIBRARIES``
+  the libraries to link against to use libzstd.
+``ZSTD_FOUND``
+  TRUE if found
+
+#]=======================================================================]
+
+find_package(PkgConfig QUIET)
+if(PKG_CONFIG_FOUND)
+  pkg_check_modules(PC_Zstd QUIET libzstd)
+endif()
+
+find_path(Zstd_INCLUDE_DIR NAMES zstd.h
+  HINTS
+    ${PC_Zstd_INCLUDE_DIRS}
+)
+mark_as_advanced(Zstd_INCLUDE_DIR)
+
+find_library(Zstd_LIBRARY NAMES zstd
+  HINTS
+    ${PC_Zstd_LIBRARY_DIRS}
+)
+mark_as_advanced(Zstd_LIBRARY)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Zstd
+  REQUIRED_VARS
+    Zstd_LIBRARY Zstd_INCLUDE_DIR
+)
+
+if(Zstd_FOUND)
+  set(ZSTD_INCLUDE_DIRS ${Zstd_INCLUDE_DIR})
+  set(ZSTD_LIBRARIES ${Zstd_LIBRARY})
+endif()
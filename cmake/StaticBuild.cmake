@@ -20,7 +20,13 @@ if(BUILD_STATIC)
 
   set(JPEG_LIBRARIES "-Wl,-Bstatic -ljpeg -Wl,-Bdynamic")
   set(ZLIB_LIBRARIES "-Wl,-Bstatic -lz -Wl,-Bdynamic")
+  if(ZLIBNG_FOUND)
+    set(ZLIBNG_LIBRARIES "-Wl,-Bstatic -lz-ng -Wl,-Bdynamic")
+  endif()
   set(PIXMAN_LIBRARIES "-Wl,-Bstatic -lpixman-1 -Wl,-Bdynamic")
+  if(ZSTD_FOUND)
+    set(ZSTD_LIBRARIES "-Wl,-Bstatic -lzstd -Wl,-Bdynamic")
+  endif()
 
   # FIXME: This code has not yet been tested
   if(UNIX AND NOT APPLE)
@@ -0,0 +1,125 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// ImplSelector - picks one of several implementations of the same thing
+//
+// The implementations are given as a table with the best one first.
+// Each entry must have a name member, and a supported member that is
+// either nullptr or a function that checks if the entry can be used on
+// this CPU. The first supported entry is used, unless a specific one
+// has been forced with set().
+//
+
+#ifndef __CORE_IMPLSELECTOR_H__
+#define __CORE_IMPLSELECTOR_H__
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include <atomic>
+
+#include <core/LogWriter.h>
+
+namespace core {
+
+  template<class Impl>
+  class ImplSelector {
+  public:
+    // Only stores the arguments, so that a static ImplSelector is
+    // ready before any other code runs
+    template<size_t N>
+    constexpr ImplSelector(const Impl (&impls_)[N], LogWriter* vlog_)
+      : impls(impls_), count(N), vlog(vlog_),
+        bestImpl(nullptr), forcedImpl(nullptr) {}
+
+    const Impl* get()
+    {
+      const Impl* impl;
+
+      impl = forcedImpl;
+      if (impl != nullptr)
+        return impl;
+
+      // Several threads might get here at once, but they will all
+      // pick the same one
+      impl = bestImpl;
+      if (impl == nullptr) {
+        impl = select();
+        bestImpl = impl;
+      }
+
+      return impl;
+    }
+
+    const char* name() { return get()->name; }
+
+    // set() forces a specific implementation. It returns false if there
+    // is none with that name, or if it isn't supported. A null name
+    // goes back to picking the best one.
+    bool set(const char* name)
+    {
+      if (name == nullptr) {
+        forcedImpl = nullptr;
+        return true;
+      }
+
+      for (size_t i = 0; i < count; i++) {
+        if (strcmp(impls[i].name, name) != 0)
+          continue;
+        if (!isSupported(&impls[i]))
+          return false;
+        forcedImpl = &impls[i];
+        return true;
+      }
+
+      return false;
+    }
+
+  private:
+    static bool isSupported(const Impl* impl)
+    {
+      return (impl->supported == nullptr) || impl->supported();
+    }
+
+    const Impl* select()
+    {
+      for (size_t i = 0; i < count; i++) {
+        if (!isSupported(&impls[i]))
+          continue;
+        vlog->debug("Using %s implementation", impls[i].name);
+        return &impls[i];
+      }
+
+      assert(false);
+      return nullptr;
+    }
+
+    const Impl* impls;
+    size_t count;
+    LogWriter* vlog;
+
+    std::atomic<const Impl*> bestImpl;
+    // Set if someone has explicitly asked for a specific one
+    std::atomic<const Impl*> forcedImpl;
+  };
+
+}
+
+#endif
@@ -34,112 +34,112 @@ static LogWriter vlog("Region");
 
 Region::Region()
 {
-  rgn = new struct pixman_region16;
-  pixman_region_init(rgn);
+  rgn = new struct pixman_region32;
+  pixman_region32_init(rgn);
 }
 
 Region::Region(const Rect& r)
 {
-  rgn = new struct pixman_region16;
-  pixman_region_init_rect(rgn, r.tl.x, r.tl.y, r.width(), r.height());
+  rgn = new struct pixman_region32;
+  pixman_region32_init_rect(rgn, r.tl.x, r.tl.y, r.width(), r.height());
 }
 
 Region::Region(const Region& r)
 {
-  rgn = new struct pixman_region16;
-  pixman_region_init(rgn);
-  pixman_region_copy(rgn, r.rgn);
+  rgn = new struct pixman_region32;
+  pixman_region32_init(rgn);
+  pixman_region32_copy(rgn, r.rgn);
 }
 
 Region::~Region()
 {
-  pixman_region_fini(rgn);
+  pixman_region32_fini(rgn);
   delete rgn;
 }
 
 Region& Region::operator=(const Region& r)
 {
-  pixman_region_copy(rgn, r.rgn);
+  pixman_region32_copy(rgn, r.rgn);
   return *this;
 }
 
 void Region::clear()
 {
-  // pixman_region_clear() isn't available on some older systems
-  pixman_region_fini(rgn);
-  pixman_region_init(rgn);
+  // pixman_region32_clear() isn't available on some older systems
+  pixman_region32_fini(rgn);
+  pixman_region32_init(rgn);
 }
 
 void Region::reset(const Rect& r)
 {
-  pixman_region_fini(rgn);
-  pixman_region_init_rect(rgn, r.tl.x, r.tl.y, r.width(), r.height());
+  pixman_region32_fini(rgn);
+  pixman_region32_init_rect(rgn, r.tl.x, r.tl.y, r.width(), r.height());
 }
 
 void Region::translate(const Point& delta)
 {
-  pixman_region_translate(rgn, delta.x, delta.y);
+  pixman_region32_translate(rgn, delta.x, delta.y);
 }
 
 void Region::assign_intersect(const Region& r)
 {
-  pixman_region_intersect(rgn, rgn, r.rgn);
+  pixman_region32_intersect(rgn, rgn, r.rgn);
 }
 
 void Region::assign_union(const Region& r)
 {
-  pixman_region_union(rgn, rgn, r.rgn);
+  pixman_region32_union(rgn, rgn, r.rgn);
 }
 
 void Region::assign_subtract(const Region& r)
 {
-  pixman_region_subtract(rgn, rgn, r.rgn);
+  pixman_region32_subtract(rgn, rgn, r.rgn);
 }
 
 Region Region::intersect(const Region& r) const
 {
   Region ret;
-  pixman_region_intersect(ret.rgn, rgn, r.rgn);
+  pixman_region32_intersect(ret.rgn, rgn, r.rgn);
   return ret;
 }
 
 Region Region::union_(const Region& r) const
 {
   Region ret;
-  pixman_region_union(ret.rgn, rgn, r.rgn);
+  pixman_region32_union(ret.rgn, rgn, r.rgn);
   return ret;
 }
 
 Region Region::subtract(const Region& r) const
 {
   Region ret;
-  pixman_region_subtract(ret.rgn, rgn, r.rgn);
+  pixman_region32_subtract(ret.rgn, rgn, r.rgn);
   return ret;
 }
 
 bool Region::operator==(const Region& r) const
 {
-  return pixman_region_equal(rgn, r.rgn);
+  return pixman_region32_equal(rgn, r.rgn);
 }
 
 bool Region::operator!=(const Region& r) const
 {
-  return !pixman_region_equal(rgn, r.rgn);
+  return !pixman_region32_equal(rgn, r.rgn);
 }
 
 int Region::numRects() const
 {
-  return pixman_region_n_rects(rgn);
+  return pixman_region32_n_rects(rgn);
 }
 
 bool Region::get_rects(std::vector<Rect>* rects,
                        bool left2right, bool topdown) const
 {
   int nRects;
-  const pixman_box16_t* boxes;
+  const pixman_box32_t* boxes;
   int xInc, yInc, i;
 
-  boxes = pixman_region_rectangles(rgn, &nRects);
+  boxes = pixman_region32_rectangles(rgn, &nRects);
 
   rects->clear();
   rects->reserve(nRects);
@@ -177,8 +177,8 @@ bool Region::get_rects(std::vector<Rect>* rects,
 
 Rect Region::get_bounding_rect() const
 {
-  const pixman_box16_t* extents;
-  extents = pixman_region_extents(rgn);
+  const pixman_box32_t* extents;
+  extents = pixman_region32_extents(rgn);
   return Rect(extents->x1, extents->y1, extents->x2, extents->y2);
 }
 
@@ -26,7 +26,7 @@
 
 #include <core/Rect.h>
 
-struct pixman_region16;
+struct pixman_region32;
 
 namespace core {
 
@@ -77,7 +77,7 @@ namespace core {
 
   protected:
 
-    struct pixman_region16* rgn;
+    struct pixman_region32* rgn;
   };
 
 };
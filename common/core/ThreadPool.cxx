@@ -0,0 +1,183 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+
+#include <algorithm>
+
+#include <core/LogWriter.h>
+#include <core/ThreadPool.h>
+
+using namespace core;
+
+static LogWriter vlog("ThreadPool");
+
+ThreadPool::ThreadPool(size_t threadCount)
+  : stopRequested(false)
+{
+  while (threadCount--)
+    threads.push_back(new std::thread(&ThreadPool::worker, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  stopRequested = true;
+  workerCond.notify_all();
+
+  lock.unlock();
+
+  while (!threads.empty()) {
+    threads.back()->join();
+    delete threads.back();
+    threads.pop_back();
+  }
+
+  // Anything left will never be run, so mark it as done so that no
+  // one waits forever
+  for (Job* job : queue)
+    job->state = Job::Finished;
+}
+
+void ThreadPool::submit(Job* job)
+{
+  const std::lock_guard<std::mutex> lock(mutex);
+
+  assert(job->state != Job::Queued);
+  assert(job->state != Job::Running);
+
+  job->state = Job::Queued;
+  job->exception = nullptr;
+
+  queue.push_back(job);
+
+  workerCond.notify_one();
+}
+
+void ThreadPool::wait(Job* job)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  assert(job->state != Job::Idle);
+
+  // Nobody has got to it yet, so do it ourselves
+  if (job->state == Job::Queued) {
+    queue.erase(std::find(queue.begin(), queue.end(), job));
+    job->state = Job::Running;
+
+    lock.unlock();
+
+    try {
+      job->run();
+    } catch (...) {
+      job->exception = std::current_exception();
+    }
+
+    lock.lock();
+
+    job->state = Job::Finished;
+    job->finished();
+  }
+
+  while (job->state != Job::Finished)
+    finishedCond.wait(lock);
+
+  job->state = Job::Idle;
+
+  if (job->exception) {
+    std::exception_ptr e;
+
+    e = job->exception;
+    job->exception = nullptr;
+
+    lock.unlock();
+
+    std::rethrow_exception(e);
+  }
+}
+
+bool ThreadPool::isFinished(Job* job)
+{
+  const std::lock_guard<std::mutex> lock(mutex);
+
+  assert(job->state != Job::Idle);
+
+  return job->state == Job::Finished;
+}
+
+ThreadPool* ThreadPool::shared()
+{
+  static ThreadPool* pool = nullptr;
+  static std::once_flag once;
+
+  std::call_once(once, []() {
+    size_t cpuCount;
+
+    cpuCount = std::thread::hardware_concurrency();
+    if (cpuCount == 0)
+      cpuCount = 1;
+
+    // The thread calling wait() helps out, so one thread less is
+    // enough to keep all cores busy
+    vlog.debug("Creating %d worker thread(s)", (int)cpuCount - 1);
+
+    pool = new ThreadPool(cpuCount - 1);
+  });
+
+  return pool;
+}
+
+void ThreadPool::worker()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  while (!stopRequested) {
+    Job* job;
+
+    if (queue.empty()) {
+      workerCond.wait(lock);
+      continue;
+    }
+
+    job = queue.front();
+    queue.pop_front();
+
+    job->state = Job::Running;
+
+    lock.unlock();
+
+    try {
+      job->run();
+    } catch (...) {
+      job->exception = std::current_exception();
+    }
+
+    lock.lock();
+
+    job->state = Job::Finished;
+    job->finished();
+
+    // We can't wake just the thread waiting for this job
+    finishedCond.notify_all();
+  }
+}
@@ -0,0 +1,112 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifndef __CORE_THREADPOOL_H__
+#define __CORE_THREADPOOL_H__
+
+#include <condition_variable>
+#include <exception>
+#include <list>
+#include <mutex>
+#include <thread>
+
+namespace core {
+
+  /* ThreadPool
+
+     A fixed set of worker threads that run independent jobs in the
+     background. Jobs are queued using submit() and will be picked up
+     by the workers in any order. The caller then uses wait() to get
+     the results back in whatever order it needs them.
+
+     A thread calling wait() on a job that no worker has started yet
+     will run that job itself rather than sleep. This means that a pool
+     without any threads is perfectly usable, and that the waiting
+     thread helps out instead of idling.
+
+     Most users should use the process wide pool given by shared(),
+     which is sized after the number of CPU cores.
+  */
+
+  class ThreadPool {
+  public:
+
+    struct Job {
+      Job() : state(Idle) {}
+      virtual ~Job() {}
+
+      // run()
+      //   Does the actual work. Called from a worker thread, or from
+      //   the thread calling wait(). Any exception will be passed on
+      //   to wait().
+      virtual void run() = 0;
+
+      // finished()
+      //   Called after run() has returned and the job has been marked
+      //   as finished, so wait() will no longer block. The pool is
+      //   locked during the call, so it must be quick and must not
+      //   call back in to the pool.
+      virtual void finished() {}
+
+    private:
+      friend class ThreadPool;
+
+      enum { Idle, Queued, Running, Finished } state;
+      std::exception_ptr exception;
+    };
+
+    ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    // size()
+    //   Returns the number of worker threads.
+    size_t size() const { return threads.size(); }
+
+    // submit()
+    //   Queues the job for processing. The job must not be modified
+    //   or destroyed until wait() has returned for it.
+    void submit(Job* job);
+
+    // wait()
+    //   Blocks until the job has finished, running it on the calling
+    //   thread if needed. Rethrows any exception thrown by the job.
+    void wait(Job* job);
+
+    // isFinished()
+    //   Returns true if the job is done, so that wait() won't block.
+    bool isFinished(Job* job);
+
+    // shared()
+    //   Returns the process wide pool.
+    static ThreadPool* shared();
+
+  private:
+    void worker();
+
+    std::list<std::thread*> threads;
+    std::list<Job*> queue;
+    bool stopRequested;
+
+    std::mutex mutex;
+    std::condition_variable workerCond;
+    std::condition_variable finishedCond;
+  };
+
+};
+
+#endif
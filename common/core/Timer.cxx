@@ -26,8 +26,6 @@
 #include <stdio.h>
 #include <sys/time.h>
 
-#include <algorithm>
-
 #include <core/LogWriter.h>
 #include <core/Timer.h>
 #include <core/time.h>
@@ -38,34 +36,28 @@ using namespace core;
 static LogWriter vlog("Timer");
 #endif
 
-std::list<Timer*> Timer::pending;
+std::vector<Timer*> Timer::pending;
+uint64_t Timer::nextSequence = 0;
 
 int Timer::checkTimeouts() {
   timeval start;
-  std::list<Timer*> ready;
+  uint64_t lastSequence;
 
   if (pending.empty())
     return -1;
 
-  // Convoluted logic to handle changes to the list as we iterate
-
   gettimeofday(&start, nullptr);
-  for (Timer* timer : pending) {
-    if (!timer->isBefore(start))
-      break;
-    ready.push_back(timer);
-  }
 
-  for (Timer* timer : ready) {
-    // Still alive?
-    if (std::find(pending.begin(), pending.end(), timer) == pending.end())
-      continue;
+  // The handlers can start and stop any timers. Anything they start is
+  // left for the next call, as it could already be due if the clock
+  // has jumped backwards.
+  lastSequence = nextSequence;
+  while (!pending.empty() && pending.front()->isBefore(start) &&
+         (pending.front()->sequence < lastSequence)) {
+    Timer* timer;
 
-    // Changed timeout?
-    if (!timer->isBefore(start))
-      continue;
-
-    pending.remove(timer);
+    timer = pending.front();
+    removeTimer(timer);
 
     timer->lastDueTime = timer->dueTime;
     timer->cb->handleTimeout(timer);
@@ -97,14 +89,83 @@ int Timer::getNextTimeout() {
 }
 
 void Timer::insertTimer(Timer* t) {
-  std::list<Timer*>::iterator i;
-  for (i=pending.begin(); i!=pending.end(); i++) {
-    if (t->isBefore((*i)->dueTime)) {
-      pending.insert(i, t);
-      return;
-    }
-  }
+  t->sequence = nextSequence++;
+  t->heapIndex = pending.size();
   pending.push_back(t);
+  siftUp(t->heapIndex);
+}
+
+void Timer::removeTimer(Timer* t) {
+  size_t index;
+  Timer* last;
+
+  index = t->heapIndex;
+  t->heapIndex = -1;
+
+  last = pending.back();
+  pending.pop_back();
+  if (last == t)
+    return;
+
+  // Fill the hole with the last Timer and move it to where it belongs
+  pending[index] = last;
+  last->heapIndex = index;
+  siftUp(index);
+  siftDown(last->heapIndex);
+}
+
+bool Timer::isEarlier(const Timer* a, const Timer* b) {
+  if (a->dueTime.tv_sec != b->dueTime.tv_sec)
+    return a->dueTime.tv_sec < b->dueTime.tv_sec;
+  if (a->dueTime.tv_usec != b->dueTime.tv_usec)
+    return a->dueTime.tv_usec < b->dueTime.tv_usec;
+  return a->sequence < b->sequence;
+}
+
+void Timer::siftUp(size_t index) {
+  Timer* t;
+
+  t = pending[index];
+  while (index > 0) {
+    size_t parent;
+
+    parent = (index - 1) / 2;
+    if (!isEarlier(t, pending[parent]))
+      break;
+
+    pending[index] = pending[parent];
+    pending[index]->heapIndex = index;
+    index = parent;
+  }
+
+  pending[index] = t;
+  t->heapIndex = index;
+}
+
+void Timer::siftDown(size_t index) {
+  Timer* t;
+
+  t = pending[index];
+  while (true) {
+    size_t child;
+
+    child = index * 2 + 1;
+    if (child >= pending.size())
+      break;
+    if ((child + 1 < pending.size()) &&
+        isEarlier(pending[child + 1], pending[child]))
+      child++;
+
+    if (!isEarlier(pending[child], t))
+      break;
+
+    pending[index] = pending[child];
+    pending[index]->heapIndex = index;
+    index = child;
+  }
+
+  pending[index] = t;
+  t->heapIndex = index;
 }
 
 void Timer::start(int timeoutMs_) {
@@ -143,12 +204,12 @@ void Timer::repeat(int timeoutMs_) {
 }
 
 void Timer::stop() {
-  pending.remove(this);
+  if (heapIndex != -1)
+    removeTimer(this);
 }
 
 bool Timer::isStarted() {
-  return std::find(pending.begin(), pending.end(),
-                   this) != pending.end();
+  return heapIndex != -1;
 }
 
 int Timer::getTimeoutMs() {
@@ -20,9 +20,12 @@
 #ifndef __CORE_TIMER_H__
 #define __CORE_TIMER_H__
 
-#include <list>
+#include <stddef.h>
+#include <stdint.h>
 #include <sys/time.h>
 
+#include <vector>
+
 namespace core {
 
   /* Timer
@@ -67,7 +70,7 @@ namespace core {
     static int getNextTimeout();
 
     // Create a Timer with the specified callback handler
-    Timer(Callback* cb_) {cb = cb_;}
+    Timer(Callback* cb_) : timeoutMs(0), cb(cb_), heapIndex(-1) {}
     ~Timer() {stop();}
 
     // start()
@@ -112,10 +115,23 @@ namespace core {
     int timeoutMs;
     Callback* cb;
 
+    // Position in pending, or -1 if not started
+    ptrdiff_t heapIndex;
+    // Keeps Timers with the same due time in the order they were
+    // started
+    uint64_t sequence;
+
     static void insertTimer(Timer* t);
-    // The list of currently active Timers, ordered by time left until
-    // timeout.
-    static std::list<Timer*> pending;
+    static void removeTimer(Timer* t);
+
+    static bool isEarlier(const Timer* a, const Timer* b);
+    static void siftUp(size_t index);
+    static void siftDown(size_t index);
+
+    // The currently active Timers, as a binary heap with the Timer
+    // that will time out first at the front
+    static std::vector<Timer*> pending;
+    static uint64_t nextSequence;
   };
 
   template<class T> class MethodTimer
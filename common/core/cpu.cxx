@@ -0,0 +1,62 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <core/cpu.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+bool core::cpuSupportsSSSE3()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3");
+}
+
+bool core::cpuSupportsSSE41()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.1");
+}
+
+bool core::cpuSupportsAVX2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+bool core::cpuSupportsSSSE3()
+{
+  return false;
+}
+
+bool core::cpuSupportsSSE41()
+{
+  return false;
+}
+
+bool core::cpuSupportsAVX2()
+{
+  return false;
+}
+
+#endif
@@ -0,0 +1,37 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// cpu.h - run time checks for CPU features
+//
+
+#ifndef __CORE_CPU_H__
+#define __CORE_CPU_H__
+
+namespace core {
+
+  // These check if the CPU we are running on has instructions that the
+  // compiler can't assume are present. They always return false on
+  // other architectures.
+  bool cpuSupportsSSSE3();
+  bool cpuSupportsSSE41();
+  bool cpuSupportsAVX2();
+
+}
+
+#endif
@@ -0,0 +1,181 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+#include <core/Exception.h>
+#include <core/Timer.h>
+
+#include <network/EventLoop.h>
+
+using namespace network;
+
+EventLoop::EventLoop()
+  : epollFd(-1)
+{
+#ifdef __linux__
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0)
+    throw core::socket_error("epoll_create1", errno);
+#endif
+}
+
+EventLoop::~EventLoop()
+{
+  if (epollFd != -1)
+    close(epollFd);
+}
+
+void EventLoop::setFd(int fd, int events)
+{
+  std::map<int, int>::iterator iter;
+
+  iter = fds.find(fd);
+  if ((iter != fds.end()) && (iter->second == events))
+    return;
+
+#ifdef __linux__
+  struct epoll_event ev;
+
+  // Level triggered, so anything not handled is reported again
+  ev.events = 0;
+  if (events & EventRead)
+    ev.events |= EPOLLIN;
+  if (events & EventWrite)
+    ev.events |= EPOLLOUT;
+  ev.data.u64 = 0;
+  ev.data.fd = fd;
+
+  if (epoll_ctl(epollFd, iter == fds.end() ? EPOLL_CTL_ADD : EPOLL_CTL_MOD,
+                fd, &ev) < 0)
+    throw core::socket_error("epoll_ctl", errno);
+#endif
+
+  fds[fd] = events;
+}
+
+void EventLoop::removeFd(int fd)
+{
+  if (fds.erase(fd) == 0)
+    return;
+
+  ready.erase(fd);
+
+#ifdef __linux__
+  if (epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr) < 0)
+    throw core::socket_error("epoll_ctl", errno);
+#endif
+}
+
+bool EventLoop::wait(int timeout)
+{
+  int nextTimeout;
+  int n;
+
+  ready.clear();
+
+  // Trigger timers and check when the next will expire
+  nextTimeout = core::Timer::checkTimeouts();
+  if (nextTimeout >= 0 && (timeout == -1 || nextTimeout < timeout))
+    timeout = nextTimeout;
+
+#ifdef __linux__
+  std::vector<struct epoll_event> events(fds.empty() ? 1 : fds.size());
+
+  n = epoll_wait(epollFd, events.data(), events.size(), timeout);
+  if (n < 0) {
+    if (errno == EINTR)
+      return false;
+    throw core::socket_error("epoll_wait", errno);
+  }
+
+  for (int i = 0; i < n; i++) {
+    int mask;
+
+    mask = 0;
+    if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+      mask |= EventRead;
+    if (events[i].events & EPOLLOUT)
+      mask |= EventWrite;
+
+    ready[events[i].data.fd] = mask;
+  }
+#else
+  std::vector<struct pollfd> pfds;
+
+  pfds.reserve(fds.size());
+  for (const auto& entry : fds) {
+    struct pollfd pfd;
+
+    pfd.fd = entry.first;
+    pfd.events = 0;
+    if (entry.second & EventRead)
+      pfd.events |= POLLIN;
+    if (entry.second & EventWrite)
+      pfd.events |= POLLOUT;
+    pfd.revents = 0;
+
+    pfds.push_back(pfd);
+  }
+
+  n = poll(pfds.data(), pfds.size(), timeout);
+  if (n < 0) {
+    if (errno == EINTR)
+      return false;
+    throw core::socket_error("poll", errno);
+  }
+
+  for (const struct pollfd& pfd : pfds) {
+    int mask;
+
+    mask = 0;
+    if (pfd.revents & (POLLIN | POLLERR | POLLHUP | POLLNVAL))
+      mask |= EventRead;
+    if (pfd.revents & POLLOUT)
+      mask |= EventWrite;
+
+    if (mask != 0)
+      ready[pfd.fd] = mask;
+  }
+#endif
+
+  return true;
+}
+
+int EventLoop::getEvents(int fd) const
+{
+  std::map<int, int>::const_iterator iter;
+
+  iter = ready.find(fd);
+  if (iter == ready.end())
+    return 0;
+
+  return iter->second;
+}
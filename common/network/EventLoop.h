@@ -0,0 +1,72 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// EventLoop waits for activity on a set of file descriptors, and for
+// the next core::Timer to expire. It uses epoll on Linux, and poll()
+// elsewhere, so it has no limit on the descriptor numbers and doesn't
+// need the full set to be rebuilt for every wait.
+//
+
+#ifndef __NETWORK_EVENTLOOP_H__
+#define __NETWORK_EVENTLOOP_H__
+
+#include <map>
+#include <vector>
+
+namespace network {
+
+  enum EventMask {
+    EventRead = 1 << 0,
+    EventWrite = 1 << 1,
+  };
+
+  class EventLoop {
+  public:
+    EventLoop();
+    ~EventLoop();
+
+    // setFd() starts watching the given fd, or changes the events it
+    // is watched for. Only events that are asked for are reported,
+    // except errors and hang ups which are reported as EventRead.
+    void setFd(int fd, int events);
+    // removeFd() must be called before the fd is closed
+    void removeFd(int fd);
+
+    // wait() dispatches any expired timers, and then waits until an
+    // fd has activity or the next timer expires. It never waits for
+    // more than timeout milliseconds, unless timeout is -1. Returns
+    // false if it was interrupted by a signal.
+    bool wait(int timeout);
+
+    // getEvents() returns what happened to the fd during the last
+    // call to wait()
+    int getEvents(int fd) const;
+
+  private:
+    int epollFd;
+
+    // Watched fds and their events
+    std::map<int, int> fds;
+    // Results from the last wait()
+    std::map<int, int> ready;
+  };
+
+}
+
+#endif
@@ -34,13 +34,14 @@
 
 using namespace rdr;
 
-const int MaxMessageSize = 8192;
+// What every peer can receive, unless it has said otherwise
+const size_t DefaultMessageSize = 8192;
 
 AESOutStream::AESOutStream(OutStream* _out, const uint8_t* key,
                            int _keySize)
-  : keySize(_keySize), out(_out), counter()
+  : keySize(_keySize), out(_out), counter(),
+    maxMessageSize(DefaultMessageSize)
 {
-  msg = new uint8_t[MaxMessageSize + 16 + 2];
   if (keySize == 128)
     EAX_SET_KEY(&eaxCtx128, aes128_set_encrypt_key, aes128_encrypt, key);
   else if (keySize == 256)
@@ -51,7 +52,6 @@ AESOutStream::AESOutStream(OutStream* _out, const uint8_t* key,
 
 AESOutStream::~AESOutStream()
 {
-    delete[] msg;
 }
 
 void AESOutStream::flush()
@@ -66,21 +66,50 @@ void AESOutStream::cork(bool enable)
   out->cork(enable);
 }
 
+void AESOutStream::setMaxMessageSize(size_t size)
+{
+  if ((size == 0) || (size > MaxMessageSize))
+    throw std::out_of_range("Invalid message size");
+  maxMessageSize = size;
+}
+
 bool AESOutStream::flushBuffer()
 {
+  // The messages are only queued up here, and are sent together once
+  // flush() reaches the underlying stream
   while (sentUpTo < ptr) {
     size_t n = ptr - sentUpTo;
-    if (n > MaxMessageSize)
-      n = MaxMessageSize;
+    if (n > maxMessageSize)
+      n = maxMessageSize;
     writeMessage(sentUpTo, n);
     sentUpTo += n;
   }
   return true;
 }
 
+size_t AESOutStream::flushBufferDirect(const uint8_t* data, size_t length)
+{
+  flushBuffer();
+
+  // Large blocks are encrypted from where they are, rather than first
+  // being copied to our buffer in pieces
+  for (size_t pos = 0; pos < length; pos += maxMessageSize) {
+    size_t n = length - pos;
+    if (n > maxMessageSize)
+      n = maxMessageSize;
+    writeMessage(data + pos, n);
+  }
+
+  return length;
+}
 
 void AESOutStream::writeMessage(const uint8_t* data, size_t length)
 {
+  uint8_t* msg;
+
+  // Encrypt straight in to the underlying stream's buffer
+  msg = out->getptr(2 + length + EAX_DIGEST_SIZE);
+
   msg[0] = (length & 0xff00) >> 8;
   msg[1] = length & 0xff;
 
@@ -103,8 +132,7 @@ void AESOutStream::writeMessage(const uint8_t* data, size_t length)
     EAX_DIGEST(&eaxCtx256, aes256_encrypt, EAX_DIGEST_SIZE, msg + 2 + length);
 #endif
   }
-  out->writeBytes(msg, 2 + length + EAX_DIGEST_SIZE);
-  out->flush();
+  out->setptr(2 + length + EAX_DIGEST_SIZE);
 
   // Update nonce by incrementing the counter as a
   // 128bit little endian unsigned integer
@@ -34,18 +34,27 @@ namespace rdr {
     void flush() override;
     void cork(bool enable) override;
 
+    // The largest length that fits in the message header
+    static const size_t MaxMessageSize = 65535;
+
+    // Messages are limited to 8 KiB by default, as that is all some
+    // peers can receive. Only raise this once the peer has said it can
+    // handle more.
+    void setMaxMessageSize(size_t size);
+
   private:
     bool flushBuffer() override;
+    size_t flushBufferDirect(const uint8_t* data, size_t length) override;
     void writeMessage(const uint8_t* data, size_t length);
 
     int keySize;
     OutStream* out;
-    uint8_t* msg;
     union {
       struct EAX_CTX(aes128_ctx) eaxCtx128;
       struct EAX_CTX(aes256_ctx) eaxCtx256;
     };
     uint8_t counter[16];
+    size_t maxMessageSize;
   };
 };
 
@@ -31,6 +31,8 @@ using namespace rdr;
 
 static const size_t DEFAULT_BUF_SIZE = 16384;
 static const size_t MAX_BUF_SIZE = 32 * 1024 * 1024;
+// Copying is cheaper than an extra system call for anything smaller
+static const size_t MIN_DIRECT_SIZE = 65536;
 
 BufferedOutStream::BufferedOutStream(bool emulateCork_)
   : bufSize(DEFAULT_BUF_SIZE), offset(0), emulateCork(emulateCork_)
@@ -99,6 +101,44 @@ void BufferedOutStream::flush()
   }
 }
 
+void BufferedOutStream::writeBytesDirect(const uint8_t* data,
+                                         size_t length)
+{
+  if (length < MIN_DIRECT_SIZE) {
+    writeBytes(data, length);
+    return;
+  }
+
+  while (length > 0) {
+    size_t buffered, n;
+
+    buffered = ptr - sentUpTo;
+
+    n = flushBufferDirect(data, length);
+
+    offset += buffered - (ptr - sentUpTo);
+
+    if (n == 0)
+      break;
+
+    offset += n;
+    data += n;
+    length -= n;
+  }
+
+  if (sentUpTo == ptr)
+    ptr = sentUpTo = start;
+
+  // Whatever couldn't be sent right away has to wait in the buffer
+  writeBytes(data, length);
+}
+
+size_t BufferedOutStream::flushBufferDirect(const uint8_t* /*data*/,
+                                            size_t /*length*/)
+{
+  return 0;
+}
+
 bool BufferedOutStream::hasBufferedData()
 {
   return sentUpTo != ptr;
@@ -38,6 +38,8 @@ namespace rdr {
     size_t length() override;
     void flush() override;
 
+    void writeBytesDirect(const uint8_t* data, size_t length) override;
+
     // hasBufferedData() checks if there is any data yet to be flushed
 
     bool hasBufferedData();
@@ -49,6 +51,14 @@ namespace rdr {
 
     virtual bool flushBuffer() = 0;
 
+    // flushBufferDirect() is like flushBuffer(), but also sends the
+    // given data directly after what is in the buffer. It returns how
+    // many bytes of that data were sent, which can only be non-zero
+    // once the buffer has been emptied. Streams that can't do this
+    // return 0 and the data will be copied to the buffer instead.
+
+    virtual size_t flushBufferDirect(const uint8_t* data, size_t length);
+
     void overrun(size_t needed) override;
 
   private:
@@ -32,15 +32,11 @@
 #else
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <poll.h>
 #include <unistd.h>
 #define errorNumber errno
 #endif
 
-/* Old systems have select() in sys/time.h */
-#ifdef HAVE_SYS_SELECT_H
-#include <sys/select.h>
-#endif
-
 #include <core/Exception.h>
 
 #include <rdr/FdInStream.h>
@@ -72,9 +68,9 @@ bool FdInStream::fillBuffer()
 // readFd() reads up to the given length in bytes from the
 // file descriptor into a buffer. Zero is
 // returned if no bytes can be read. Otherwise it returns the number of bytes read.  It
-// never attempts to recv() unless select() indicates that the fd is readable -
+// never attempts to recv() unless poll() indicates that the fd is readable -
 // this means it can be used on an fd which has been set non-blocking.  It also
-// has to cope with the annoying possibility of both select() and recv()
+// has to cope with the annoying possibility of both poll() and recv()
 // returning EINTR.
 //
 
@@ -82,6 +78,8 @@ size_t FdInStream::readFd(uint8_t* buf, size_t len)
 {
   int n;
   do {
+#ifdef _WIN32
+    // Windows' fd_set is a list, so any socket number fits
     fd_set fds;
     struct timeval tv;
 
@@ -90,18 +88,34 @@ size_t FdInStream::readFd(uint8_t* buf, size_t len)
     FD_ZERO(&fds);
     FD_SET(fd, &fds);
     n = select(fd+1, &fds, nullptr, nullptr, &tv);
+#else
+    // select() can't handle fds above FD_SETSIZE
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    n = poll(&pfd, 1, 0);
+#endif
   } while (n < 0 && errorNumber == EINTR);
 
   if (n < 0)
-    throw core::socket_error("select", errorNumber);
+    throw core::socket_error("poll", errorNumber);
 
   if (n == 0)
     return 0;
 
   do {
+    // Notifications on the error queue also make poll() say that
+    // the fd is readable, so there might not be any data after all
+#ifndef MSG_DONTWAIT
     n = ::recv(fd, (char*)buf, len, 0);
+#else
+    n = ::recv(fd, (char*)buf, len, MSG_DONTWAIT);
+#endif
   } while (n < 0 && errorNumber == EINTR);
 
+  if (n < 0 && (errorNumber == EAGAIN || errorNumber == EWOULDBLOCK))
+    return 0;
   if (n < 0)
     throw core::socket_error("read", errorNumber);
   if (n == 0)
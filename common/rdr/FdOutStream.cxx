@@ -34,14 +34,20 @@
 #include <unistd.h>
 #include <sys/time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <poll.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #define errorNumber errno
 #endif
 
-/* Old systems have select() in sys/time.h */
-#ifdef HAVE_SYS_SELECT_H
-#include <sys/select.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && \
+    defined(SO_EE_ORIGIN_ZEROCOPY)
+#define HAVE_ZEROCOPY
 #endif
 
 #include <core/Exception.h>
@@ -57,7 +63,7 @@ FdOutStream::FdOutStream(int fd_)
 #else
   : BufferedOutStream(true),
 #endif
-  fd(fd_)
+  fd(fd_), zeroCopy(false), zeroCopyId(0)
 {
   gettimeofday(&lastWrite, nullptr);
 }
@@ -81,6 +87,47 @@ void FdOutStream::cork(bool enable)
 #endif
 }
 
+void FdOutStream::flush()
+{
+  BufferedOutStream::flush();
+
+  if (!zeroCopyPending.empty())
+    processCompletions();
+}
+
+void FdOutStream::writeBuffer(const SharedBuffer& buffer)
+{
+  if (!zeroCopy) {
+    writeBytesDirect(buffer->data(), buffer->size());
+    return;
+  }
+
+  // Marks the data that flushBufferDirect() may send without copying
+  zeroCopyBuffer = buffer;
+  try {
+    writeBytesDirect(buffer->data(), buffer->size());
+  } catch (...) {
+    zeroCopyBuffer.reset();
+    throw;
+  }
+  zeroCopyBuffer.reset();
+}
+
+bool FdOutStream::setZeroCopy(bool enable)
+{
+#ifdef HAVE_ZEROCOPY
+  int one = enable ? 1 : 0;
+  if (setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0)
+    return false;
+
+  zeroCopy = enable;
+  return true;
+#else
+  (void)enable;
+  return false;
+#endif
+}
+
 bool FdOutStream::flushBuffer()
 {
   size_t n = writeFd(sentUpTo, ptr - sentUpTo);
@@ -92,20 +139,154 @@ bool FdOutStream::flushBuffer()
   return true;
 }
 
+#ifndef _WIN32
+size_t FdOutStream::flushBufferDirect(const uint8_t* data, size_t length)
+{
+  struct iovec iov[2];
+  struct msghdr msg;
+  size_t buffered;
+  int flags;
+  ssize_t n;
+
+  buffered = ptr - sentUpTo;
+
+  flags = 0;
+#ifdef MSG_DONTWAIT
+  flags |= MSG_DONTWAIT;
+#endif
+
+#ifdef HAVE_ZEROCOPY
+  if (zeroCopyBuffer && (data >= zeroCopyBuffer->data()) &&
+      (data < zeroCopyBuffer->data() + zeroCopyBuffer->size())) {
+    // Our own buffer gets reused right away, so it must be copied
+    // before the rest can be sent without copying
+    if (buffered > 0) {
+      sentUpTo += writeFd(sentUpTo, buffered);
+      if (sentUpTo != ptr)
+        return 0;
+      buffered = 0;
+    }
+
+    flags |= MSG_ZEROCOPY;
+  }
+#endif
+
+  if (!isWritable())
+    return 0;
+
+  iov[0].iov_base = sentUpTo;
+  iov[0].iov_len = buffered;
+  iov[1].iov_base = (void*)data;
+  iov[1].iov_len = length;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = buffered > 0 ? &iov[0] : &iov[1];
+  msg.msg_iovlen = buffered > 0 ? 2 : 1;
+
+  do {
+    n = ::sendmsg(fd, &msg, flags);
+  } while (n < 0 && (errorNumber == EINTR));
+
+#ifdef HAVE_ZEROCOPY
+  // Too much is already waiting to be completed, so copy it instead
+  if ((n < 0) && (flags & MSG_ZEROCOPY) && (errorNumber == ENOBUFS))
+    return 0;
+#endif
+
+  if (n < 0)
+    throw core::socket_error("write", errorNumber);
+
+  gettimeofday(&lastWrite, nullptr);
+
+#ifdef HAVE_ZEROCOPY
+  // Every successful call gets a completion, counting up from zero
+  if (flags & MSG_ZEROCOPY)
+    zeroCopyPending.push_back({zeroCopyId++, zeroCopyBuffer});
+#endif
+
+  // Didn't even get through the buffer?
+  if ((size_t)n < buffered) {
+    sentUpTo += n;
+    return 0;
+  }
+
+  sentUpTo = ptr;
+
+  return n - buffered;
+}
+#endif
+
 //
-// writeFd() writes up to the given length in bytes from the given
-// buffer to the file descriptor. It returns the number of bytes written.  It
-// never attempts to send() unless select() indicates that the fd is writable
-// - this means it can be used on an fd which has been set non-blocking.  It
-// also has to cope with the annoying possibility of both select() and send()
-// returning EINTR.
+// processCompletions() reads the notifications for sends that the
+// kernel no longer needs the memory for, and releases those buffers.
 //
 
-size_t FdOutStream::writeFd(const uint8_t* data, size_t length)
+void FdOutStream::processCompletions()
+{
+#ifdef HAVE_ZEROCOPY
+  while (!zeroCopyPending.empty()) {
+    struct msghdr msg;
+    uint8_t control[128];
+    struct cmsghdr* cmsg;
+    ssize_t n;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    do {
+      n = ::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+    } while (n < 0 && (errorNumber == EINTR));
+
+    // Nothing more has completed yet
+    if (n < 0)
+      return;
+
+    for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      struct sock_extended_err serr;
+      uint32_t first, count;
+
+      if (!((cmsg->cmsg_level == SOL_IP) &&
+            (cmsg->cmsg_type == IP_RECVERR)) &&
+          !((cmsg->cmsg_level == SOL_IPV6) &&
+            (cmsg->cmsg_type == IPV6_RECVERR)))
+        continue;
+
+      memcpy(&serr, CMSG_DATA(cmsg), sizeof(serr));
+      if ((serr.ee_errno != 0) ||
+          (serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY))
+        continue;
+
+      // The kernel had to copy the data anyway, e.g. because it went
+      // over loopback, so the notifications are only overhead
+      if (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+        setZeroCopy(false);
+
+      // Covers the range ee_info to ee_data, which may wrap around
+      first = serr.ee_info;
+      count = serr.ee_data - serr.ee_info + 1;
+      zeroCopyPending.remove_if(
+        [first, count](const std::pair<uint32_t, SharedBuffer>& entry) {
+          return (entry.first - first) < count;
+        });
+    }
+  }
+#endif
+}
+
+//
+// isWritable() checks if poll() indicates that the fd is writable, while
+// coping with the annoying possibility of poll() returning EINTR.
+//
+
+bool FdOutStream::isWritable()
 {
   int n;
 
   do {
+#ifdef _WIN32
+    // Windows' fd_set is a list, so any socket number fits
     fd_set fds;
     struct timeval tv;
 
@@ -114,16 +295,39 @@ size_t FdOutStream::writeFd(const uint8_t* data, size_t length)
     FD_ZERO(&fds);
     FD_SET(fd, &fds);
     n = select(fd+1, nullptr, &fds, nullptr, &tv);
+#else
+    // select() can't handle fds above FD_SETSIZE
+    struct pollfd pfd;
+
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    n = poll(&pfd, 1, 0);
+#endif
   } while (n < 0 && errorNumber == EINTR);
 
   if (n < 0)
-    throw core::socket_error("select", errorNumber);
+    throw core::socket_error("poll", errorNumber);
 
-  if (n == 0)
+  return n != 0;
+}
+
+//
+// writeFd() writes up to the given length in bytes from the given
+// buffer to the file descriptor. It returns the number of bytes written.  It
+// never attempts to send() unless poll() indicates that the fd is writable
+// - this means it can be used on an fd which has been set non-blocking.  It
+// also has to cope with the possibility of send() returning EINTR.
+//
+
+size_t FdOutStream::writeFd(const uint8_t* data, size_t length)
+{
+  int n;
+
+  if (!isWritable())
     return 0;
 
   do {
-    // select only guarantees that you can write SO_SNDLOWAT without
+    // poll only guarantees that you can write SO_SNDLOWAT without
     // blocking, which is normally 1. Use MSG_DONTWAIT to avoid
     // blocking, when possible.
 #ifndef MSG_DONTWAIT
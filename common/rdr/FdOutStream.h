@@ -26,6 +26,9 @@
 
 #include <sys/time.h>
 
+#include <list>
+#include <utility>
+
 #include <rdr/BufferedOutStream.h>
 
 namespace rdr {
@@ -43,11 +46,30 @@ namespace rdr {
 
     void cork(bool enable) override;
 
+    void flush() override;
+    void writeBuffer(const SharedBuffer& buffer) override;
+
+    // setZeroCopy() lets the kernel send large shared buffers straight
+    // from memory, rather than copying them. The buffers are kept
+    // until the kernel says it is done with them. Returns false if
+    // this isn't supported by the system or the socket.
+    bool setZeroCopy(bool enable);
+
   private:
     bool flushBuffer() override;
+#ifndef _WIN32
+    size_t flushBufferDirect(const uint8_t* data, size_t length) override;
+#endif
+    bool isWritable();
     size_t writeFd(const uint8_t* data, size_t length);
+    void processCompletions();
     int fd;
     struct timeval lastWrite;
+
+    bool zeroCopy;
+    SharedBuffer zeroCopyBuffer;
+    uint32_t zeroCopyId;
+    std::list<std::pair<uint32_t, SharedBuffer>> zeroCopyPending;
   };
 
 }
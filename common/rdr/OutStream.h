@@ -27,7 +27,9 @@
 #include <stdint.h>
 #include <string.h> // for memcpy
 
+#include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include <rdr/InStream.h>
 
@@ -41,6 +43,8 @@ namespace rdr {
 
   public:
 
+    typedef std::shared_ptr<const std::vector<uint8_t>> SharedBuffer;
+
     virtual ~OutStream() {}
 
     // avail() returns the number of bytes that currently be written to the
@@ -84,6 +88,23 @@ namespace rdr {
       }
     }
 
+    // writeBytesDirect() is like writeBytes(), but is meant for large
+    // blocks of data. Streams that can will send the data straight
+    // from the given buffer rather than copying it in to their own
+    // buffer first. The data is never referenced after the call.
+
+    virtual void writeBytesDirect(const uint8_t* data, size_t length) {
+      writeBytes(data, length);
+    }
+
+    // writeBuffer() is like writeBytesDirect(), but the stream may
+    // keep a reference to the buffer for as long as it needs it. The
+    // buffer must not be modified after this.
+
+    virtual void writeBuffer(const SharedBuffer& buffer) {
+      writeBytesDirect(buffer->data(), buffer->size());
+    }
+
     // copyBytes() efficiently transfers data between streams
 
     void copyBytes(InStream* is, size_t length) {
@@ -27,12 +27,29 @@
 #include <core/LogWriter.h>
 #include <core/i18n.h>
 
+#include <rdr/FdInStream.h>
+#include <rdr/FdOutStream.h>
 #include <rdr/InStream.h>
 #include <rdr/OutStream.h>
 #include <rdr/TLSException.h>
 #include <rdr/TLSSocket.h>
 
 #include <errno.h>
+#include <string.h>
+
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <linux/tls.h>
+#endif
+
+#if defined(TCP_ULP) && defined(SOL_TLS) && defined(TLS_TX) && \
+    defined(TLS_RX) && defined(TLS_GET_RECORD_TYPE)
+#define HAVE_KTLS
+#endif
 
 #ifdef HAVE_GNUTLS
 
@@ -40,9 +57,120 @@ using namespace rdr;
 
 static core::LogWriter vlog("TLSSocket");
 
+// TLS record content types
+static const uint8_t recordAlert = 21;
+static const uint8_t recordHandshake = 22;
+static const uint8_t recordApplicationData = 23;
+
+static const uint8_t handshakeNewSessionTicket = 4;
+
+#ifdef HAVE_KTLS
+template<class T>
+static bool fillGCMInfo(T* info, int cipherType, int version,
+                        const gnutls_datum_t& iv,
+                        const gnutls_datum_t& key,
+                        const uint8_t* seq)
+{
+  if (key.size != sizeof(info->key))
+    return false;
+  // TLS 1.2 only has the implicit part of the nonce here
+  if (version == TLS_1_2_VERSION) {
+    if (iv.size < sizeof(info->salt))
+      return false;
+  } else {
+    if (iv.size < sizeof(info->salt) + sizeof(info->iv))
+      return false;
+  }
+
+  memset(info, 0, sizeof(*info));
+  info->info.version = version;
+  info->info.cipher_type = cipherType;
+
+  memcpy(info->salt, iv.data, sizeof(info->salt));
+  // TLS 1.2 uses an explicit nonce, which starts out as the sequence
+  // number
+  if (version == TLS_1_2_VERSION)
+    memcpy(info->iv, seq, sizeof(info->iv));
+  else
+    memcpy(info->iv, iv.data + sizeof(info->salt), sizeof(info->iv));
+  memcpy(info->rec_seq, seq, sizeof(info->rec_seq));
+  memcpy(info->key, key.data, sizeof(info->key));
+
+  return true;
+}
+
+static bool installKeys(int fd, gnutls_session_t session, bool read)
+{
+  union {
+    struct tls12_crypto_info_aes_gcm_128 aes128;
+    struct tls12_crypto_info_aes_gcm_256 aes256;
+    struct tls12_crypto_info_chacha20_poly1305 chacha20;
+  } info;
+  size_t infoSize;
+
+  gnutls_datum_t macKey, iv, key;
+  uint8_t seq[8];
+  int version;
+  int err;
+
+  switch (gnutls_protocol_get_version(session)) {
+  case GNUTLS_TLS1_2:
+    version = TLS_1_2_VERSION;
+    break;
+  case GNUTLS_TLS1_3:
+    version = TLS_1_3_VERSION;
+    break;
+  default:
+    return false;
+  }
+
+  err = gnutls_record_get_state(session, read ? 1 : 0,
+                                &macKey, &iv, &key, seq);
+  if (err != GNUTLS_E_SUCCESS)
+    return false;
+
+  switch (gnutls_cipher_get(session)) {
+  case GNUTLS_CIPHER_AES_128_GCM:
+    if (!fillGCMInfo(&info.aes128, TLS_CIPHER_AES_GCM_128,
+                     version, iv, key, seq))
+      return false;
+    infoSize = sizeof(info.aes128);
+    break;
+  case GNUTLS_CIPHER_AES_256_GCM:
+    if (!fillGCMInfo(&info.aes256, TLS_CIPHER_AES_GCM_256,
+                     version, iv, key, seq))
+      return false;
+    infoSize = sizeof(info.aes256);
+    break;
+  case GNUTLS_CIPHER_CHACHA20_POLY1305:
+    if ((key.size != sizeof(info.chacha20.key)) ||
+        (iv.size != sizeof(info.chacha20.iv)))
+      return false;
+    memset(&info.chacha20, 0, sizeof(info.chacha20));
+    info.chacha20.info.version = version;
+    info.chacha20.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+    memcpy(info.chacha20.iv, iv.data, sizeof(info.chacha20.iv));
+    memcpy(info.chacha20.rec_seq, seq, sizeof(info.chacha20.rec_seq));
+    memcpy(info.chacha20.key, key.data, sizeof(info.chacha20.key));
+    infoSize = sizeof(info.chacha20);
+    break;
+  default:
+    return false;
+  }
+
+  err = setsockopt(fd, SOL_TLS, read ? TLS_RX : TLS_TX, &info, infoSize);
+
+  // Don't leave the keys lying around
+  memset(&info, 0, sizeof(info));
+
+  return err == 0;
+}
+#endif
+
 TLSSocket::TLSSocket(InStream* in_, OutStream* out_,
                      gnutls_session_t session_)
   : session(session_), established(false),
+    fd(-1), kernelSend(false), kernelRecv(false),
     in(in_), out(out_), tlsin(this), tlsout(this)
 {
   gnutls_transport_set_pull_function(
@@ -100,6 +228,57 @@ bool TLSSocket::handshake()
   return true;
 }
 
+bool TLSSocket::enableKernelTLS()
+{
+#ifdef HAVE_KTLS
+  FdInStream* fdin;
+  FdOutStream* fdout;
+
+  if (!established || kernelSend || kernelRecv)
+    return false;
+
+  fdin = dynamic_cast<FdInStream*>(in);
+  fdout = dynamic_cast<FdOutStream*>(out);
+  if ((fdin == nullptr) || (fdout == nullptr) ||
+      (fdin->getFd() != fdout->getFd()))
+    return false;
+
+  // Anything GnuTLS has already encrypted must be sent before the
+  // kernel starts encrypting everything
+  fdout->flush();
+  if (fdout->hasBufferedData())
+    return false;
+
+  fd = fdout->getFd();
+
+  if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0) {
+    vlog.debug("Kernel TLS not available: %s", strerror(errno));
+    return false;
+  }
+
+  kernelSend = installKeys(fd, session, false);
+
+  // Records that have already been read must be decrypted by GnuTLS,
+  // so only switch if we are at a record boundary
+  if ((in->avail() == 0) && (gnutls_record_check_pending(session) == 0))
+    kernelRecv = installKeys(fd, session, true);
+
+  if (!kernelSend && !kernelRecv) {
+    vlog.debug("Kernel TLS not possible with %s",
+               gnutls_session_get_desc(session));
+    return false;
+  }
+
+  vlog.debug("Using kernel TLS for %s",
+             kernelSend && kernelRecv ? "sending and receiving" :
+             kernelSend ? "sending" : "receiving");
+
+  return true;
+#else
+  return false;
+#endif
+}
+
 void TLSSocket::shutdown()
 {
   int ret;
@@ -119,6 +298,17 @@ void TLSSocket::shutdown()
                e.what());
   }
 
+  // GnuTLS no longer knows the state of the connection
+  if (kernelSend) {
+    established = false;
+    try {
+      sendKernelAlert(GNUTLS_AL_WARNING, GNUTLS_A_CLOSE_NOTIFY);
+    } catch (std::exception& e) {
+      vlog.error(_("Failed to terminate TLS cleanly: %s"), e.what());
+    }
+    return;
+  }
+
   // FIXME: We can't currently wait for the response, so we only send
   //        our close and hope for the best
   ret = gnutls_bye(session, GNUTLS_SHUT_WR);
@@ -141,6 +331,9 @@ size_t TLSSocket::readTLS(uint8_t* buf, size_t len)
 {
   int n;
 
+  if (kernelRecv)
+    return readKernel(buf, len);
+
   while (true) {
     streamEmpty = false;
     n = gnutls_record_recv(session, (void *) buf, len);
@@ -175,6 +368,13 @@ size_t TLSSocket::writeTLS(const uint8_t* data, size_t length)
 {
   int n;
 
+  // The kernel encrypts whatever is written to the socket
+  if (kernelSend) {
+    out->writeBytesDirect(data, length);
+    out->flush();
+    return length;
+  }
+
   n = gnutls_record_send(session, data, length);
   if (n == GNUTLS_E_INTERRUPTED || n == GNUTLS_E_AGAIN)
     return 0;
@@ -191,6 +391,114 @@ size_t TLSSocket::writeTLS(const uint8_t* data, size_t length)
   return n;
 }
 
+size_t TLSSocket::readKernel(uint8_t* buf, size_t len)
+{
+#ifdef HAVE_KTLS
+  while (true) {
+    struct msghdr msg;
+    struct iovec iov;
+    uint8_t control[CMSG_SPACE(sizeof(uint8_t))];
+    struct cmsghdr* cmsg;
+    uint8_t type;
+    ssize_t n;
+
+    iov.iov_base = buf;
+    iov.iov_len = len;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    do {
+      n = ::recvmsg(fd, &msg, MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return 0;
+    if (n < 0)
+      throw core::socket_error("read", errno);
+    if (n == 0)
+      throw end_of_stream();
+
+    // Anything other than data comes with its record type
+    type = recordApplicationData;
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if ((cmsg != nullptr) && (cmsg->cmsg_level == SOL_TLS) &&
+        (cmsg->cmsg_type == TLS_GET_RECORD_TYPE))
+      type = *CMSG_DATA(cmsg);
+
+    if (type == recordApplicationData)
+      return n;
+
+    if ((type == recordAlert) && (n >= 2)) {
+      if (buf[1] == GNUTLS_A_CLOSE_NOTIFY)
+        throw end_of_stream();
+      throw tls_error(_("Failed receiving TLS data"),
+                      buf[0] == GNUTLS_AL_FATAL ?
+                        GNUTLS_E_FATAL_ALERT_RECEIVED :
+                        GNUTLS_E_WARNING_ALERT_RECEIVED,
+                      buf[1]);
+    }
+
+    // Servers may send session tickets at any time, but we never use
+    // them for anything
+    if ((type == recordHandshake) && (n >= 1) &&
+        (buf[0] == handshakeNewSessionTicket))
+      continue;
+
+    throw tls_error(_("Failed receiving TLS data"),
+                    GNUTLS_E_UNEXPECTED_PACKET);
+  }
+#else
+  (void)buf;
+  (void)len;
+  throw std::logic_error("Kernel TLS not supported");
+#endif
+}
+
+void TLSSocket::sendKernelAlert(uint8_t level, uint8_t description)
+{
+#ifdef HAVE_KTLS
+  struct msghdr msg;
+  struct iovec iov;
+  uint8_t control[CMSG_SPACE(sizeof(uint8_t))];
+  struct cmsghdr* cmsg;
+  uint8_t alert[2];
+  ssize_t n;
+
+  alert[0] = level;
+  alert[1] = description;
+
+  iov.iov_base = alert;
+  iov.iov_len = sizeof(alert);
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = recordAlert;
+
+  do {
+    n = ::sendmsg(fd, &msg, MSG_DONTWAIT);
+  } while (n < 0 && errno == EINTR);
+
+  if (n < 0)
+    throw core::socket_error("write", errno);
+#else
+  (void)level;
+  (void)description;
+  throw std::logic_error("Kernel TLS not supported");
+#endif
+}
+
 ssize_t TLSSocket::pull(void* data, size_t size)
 {
   streamEmpty = false;
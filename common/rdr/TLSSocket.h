@@ -49,6 +49,12 @@ namespace rdr {
     bool handshake();
     void shutdown();
 
+    // enableKernelTLS() hands the encryption over to the kernel once
+    // the handshake is done, turning the streams in to simple pass
+    // throughs. Only possible for sockets, and only on Linux. Returns
+    // false if GnuTLS is still used in both directions.
+    bool enableKernelTLS();
+
   protected:
     /* Used by the stream classes */
     size_t readTLS(uint8_t* buf, size_t len);
@@ -61,9 +67,15 @@ namespace rdr {
     ssize_t pull(void* data, size_t size);
     ssize_t push(const void* data, size_t size);
 
+    size_t readKernel(uint8_t* buf, size_t len);
+    void sendKernelAlert(uint8_t level, uint8_t description);
+
     gnutls_session_t session;
     bool established;
 
+    int fd;
+    bool kernelSend, kernelRecv;
+
     InStream* in;
     OutStream* out;
 
@@ -0,0 +1,214 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdexcept>
+
+#include <core/ImplSelector.h>
+#include <core/LogWriter.h>
+#include <core/i18n.h>
+
+#include <rdr/ZlibBackend.h>
+#ifdef HAVE_ZLIBNG
+#include <rdr/ZlibNgBackend.h>
+#endif
+
+#include <zlib.h>
+
+using namespace rdr;
+
+static core::LogWriter vlog("ZlibBackend");
+
+namespace {
+
+class ZlibDeflater : public Deflater {
+public:
+  ZlibDeflater(int level)
+  {
+    zs.zalloc = nullptr;
+    zs.zfree = nullptr;
+    zs.opaque = nullptr;
+    zs.next_in = nullptr;
+    zs.avail_in = 0;
+    if (deflateInit(&zs, level) != Z_OK)
+      throw std::runtime_error(_("Failed to initialize zlib"));
+  }
+
+  ~ZlibDeflater()
+  {
+    deflateEnd(&zs);
+  }
+
+  int reset() override
+  {
+    return deflateReset(&zs);
+  }
+
+  int setLevel(int level) override
+  {
+    int rc;
+
+    // Changing parameters can flush data, so the buffers are needed
+    load();
+    rc = deflateParams(&zs, level, Z_DEFAULT_STRATEGY);
+    store();
+
+    return rc;
+  }
+
+  int deflate(int flush) override
+  {
+    int rc;
+
+    load();
+    rc = ::deflate(&zs, flush);
+    store();
+
+    return rc;
+  }
+
+private:
+  void load()
+  {
+    zs.next_in = (Bytef*)nextIn;
+    zs.avail_in = availIn;
+    zs.next_out = nextOut;
+    zs.avail_out = availOut;
+  }
+
+  void store()
+  {
+    nextIn = zs.next_in;
+    availIn = zs.avail_in;
+    nextOut = zs.next_out;
+    availOut = zs.avail_out;
+  }
+
+  z_stream zs;
+};
+
+class ZlibInflater : public Inflater {
+public:
+  ZlibInflater()
+  {
+    zs.zalloc = nullptr;
+    zs.zfree = nullptr;
+    zs.opaque = nullptr;
+    zs.next_in = nullptr;
+    zs.avail_in = 0;
+    if (inflateInit(&zs) != Z_OK)
+      throw std::runtime_error(_("Failed to initialize zlib"));
+  }
+
+  ~ZlibInflater()
+  {
+    inflateEnd(&zs);
+  }
+
+  int inflate(int flush) override
+  {
+    int rc;
+
+    zs.next_in = (Bytef*)nextIn;
+    zs.avail_in = availIn;
+    zs.next_out = nextOut;
+    zs.avail_out = availOut;
+
+    rc = ::inflate(&zs, flush);
+
+    nextIn = zs.next_in;
+    availIn = zs.avail_in;
+    nextOut = zs.next_out;
+    availOut = zs.avail_out;
+
+    return rc;
+  }
+
+private:
+  z_stream zs;
+};
+
+}
+
+static Deflater* createZlibDeflater(int level)
+{
+  return new ZlibDeflater(level);
+}
+
+static Inflater* createZlibInflater()
+{
+  return new ZlibInflater();
+}
+
+struct ZlibImpl {
+  const char* name;
+  Deflater* (*createDeflater)(int level);
+  Inflater* (*createInflater)();
+  bool (*supported)();
+};
+
+// In order of preference
+static const ZlibImpl impls[] = {
+#ifdef HAVE_ZLIBNG
+  { "zlib-ng", createZlibNgDeflater, createZlibNgInflater, nullptr },
+#endif
+  { "zlib", createZlibDeflater, createZlibInflater, nullptr },
+};
+
+static core::ImplSelector<ZlibImpl> selector(impls, &vlog);
+
+Deflater* rdr::createDeflater(int level)
+{
+  Deflater* deflater;
+
+  deflater = selector.get()->createDeflater(level);
+
+  deflater->nextIn = nullptr;
+  deflater->availIn = 0;
+  deflater->nextOut = nullptr;
+  deflater->availOut = 0;
+
+  return deflater;
+}
+
+Inflater* rdr::createInflater()
+{
+  Inflater* inflater;
+
+  inflater = selector.get()->createInflater();
+
+  inflater->nextIn = nullptr;
+  inflater->availIn = 0;
+  inflater->nextOut = nullptr;
+  inflater->availOut = 0;
+
+  return inflater;
+}
+
+const char* rdr::zlibImpl()
+{
+  return selector.name();
+}
+
+bool rdr::setZlibImpl(const char* name)
+{
+  return selector.set(name);
+}
@@ -0,0 +1,78 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// The zlib streams can use different implementations of zlib. They
+// all produce standard zlib data, so the other side doesn't need to
+// know which one is used.
+//
+
+#ifndef __RDR_ZLIBBACKEND_H__
+#define __RDR_ZLIBBACKEND_H__
+
+#include <stdint.h>
+
+namespace rdr {
+
+  class Deflater {
+  public:
+    virtual ~Deflater() {}
+
+    // These work like deflateReset(), deflateParams() and deflate()
+    // in zlib, including the return values
+    virtual int reset() = 0;
+    virtual int setLevel(int level) = 0;
+    virtual int deflate(int flush) = 0;
+
+  public:
+    const uint8_t* nextIn;
+    unsigned int availIn;
+    uint8_t* nextOut;
+    unsigned int availOut;
+  };
+
+  class Inflater {
+  public:
+    virtual ~Inflater() {}
+
+    // Works like inflate() in zlib, including the return values
+    virtual int inflate(int flush) = 0;
+
+  public:
+    const uint8_t* nextIn;
+    unsigned int availIn;
+    uint8_t* nextOut;
+    unsigned int availOut;
+  };
+
+  // createDeflater() and createInflater() set up a new stream using
+  // the current implementation. They throw an exception on failure.
+  Deflater* createDeflater(int level);
+  Inflater* createInflater();
+
+  // zlibImpl() returns the name of the implementation that new
+  // streams will use. The fastest one available is picked
+  // automatically, but setZlibImpl() can be used to force a specific
+  // one. It returns false if it isn't available. A null name goes
+  // back to automatic selection.
+  const char* zlibImpl();
+  bool setZlibImpl(const char* name);
+
+}
+
+#endif
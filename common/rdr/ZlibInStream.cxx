@@ -24,6 +24,7 @@
 
 #include <core/i18n.h>
 
+#include <rdr/ZlibBackend.h>
 #include <rdr/ZlibInStream.h>
 #include <zlib.h>
 
@@ -69,24 +70,13 @@ void ZlibInStream::init()
 {
   assert(zs == nullptr);
 
-  zs = new z_stream;
-  zs->zalloc    = nullptr;
-  zs->zfree     = nullptr;
-  zs->opaque    = nullptr;
-  zs->next_in   = nullptr;
-  zs->avail_in  = 0;
-  if (inflateInit(zs) != Z_OK) {
-    delete zs;
-    zs = nullptr;
-    throw std::runtime_error(_("Failed to initialize zlib"));
-  }
+  zs = createInflater();
 }
 
 void ZlibInStream::deinit()
 {
   assert(zs != nullptr);
   setUnderlying(nullptr, 0);
-  inflateEnd(zs);
   delete zs;
   zs = nullptr;
 }
@@ -96,24 +86,24 @@ bool ZlibInStream::fillBuffer()
   if (!underlying)
     throw std::logic_error("ZlibInStream overrun: No underlying stream");
 
-  zs->next_out = (uint8_t*)end;
-  zs->avail_out = availSpace();
+  zs->nextOut = (uint8_t*)end;
+  zs->availOut = availSpace();
 
   if (!underlying->hasData(1))
     return false;
   size_t length = underlying->avail();
   if (length > bytesIn)
     length = bytesIn;
-  zs->next_in = (uint8_t*)underlying->getptr(length);
-  zs->avail_in = length;
+  zs->nextIn = underlying->getptr(length);
+  zs->availIn = length;
 
-  int rc = inflate(zs, Z_SYNC_FLUSH);
+  int rc = zs->inflate(Z_SYNC_FLUSH);
   if (rc < 0) {
     throw std::runtime_error(_("Failed to decompress data"));
   }
 
-  bytesIn -= length - zs->avail_in;
-  end = zs->next_out;
-  underlying->setptr(length - zs->avail_in);
+  bytesIn -= length - zs->availIn;
+  end = zs->nextOut;
+  underlying->setptr(length - zs->availIn);
   return true;
 }
@@ -26,10 +26,10 @@
 
 #include <rdr/BufferedInStream.h>
 
-struct z_stream_s;
-
 namespace rdr {
 
+  class Inflater;
+
   class ZlibInStream : public BufferedInStream {
 
   public:
@@ -48,7 +48,7 @@ namespace rdr {
 
   private:
     InStream* underlying;
-    z_stream_s* zs;
+    Inflater* zs;
     size_t bytesIn;
   };
 
@@ -0,0 +1,156 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <rdr/ZlibNgBackend.h>
+
+#ifdef HAVE_ZLIBNG
+
+#include <stdexcept>
+
+#include <core/i18n.h>
+
+#include <zlib-ng.h>
+
+using namespace rdr;
+
+namespace {
+
+class ZlibNgDeflater : public Deflater {
+public:
+  ZlibNgDeflater(int level)
+  {
+    zs.zalloc = nullptr;
+    zs.zfree = nullptr;
+    zs.opaque = nullptr;
+    zs.next_in = nullptr;
+    zs.avail_in = 0;
+    if (zng_deflateInit(&zs, level) != Z_OK)
+      throw std::runtime_error(_("Failed to initialize zlib-ng"));
+  }
+
+  ~ZlibNgDeflater()
+  {
+    zng_deflateEnd(&zs);
+  }
+
+  int reset() override
+  {
+    return zng_deflateReset(&zs);
+  }
+
+  int setLevel(int level) override
+  {
+    int rc;
+
+    // Changing parameters can flush data, so the buffers are needed
+    load();
+    rc = zng_deflateParams(&zs, level, Z_DEFAULT_STRATEGY);
+    store();
+
+    return rc;
+  }
+
+  int deflate(int flush) override
+  {
+    int rc;
+
+    load();
+    rc = zng_deflate(&zs, flush);
+    store();
+
+    return rc;
+  }
+
+private:
+  void load()
+  {
+    zs.next_in = nextIn;
+    zs.avail_in = availIn;
+    zs.next_out = nextOut;
+    zs.avail_out = availOut;
+  }
+
+  void store()
+  {
+    nextIn = zs.next_in;
+    availIn = zs.avail_in;
+    nextOut = zs.next_out;
+    availOut = zs.avail_out;
+  }
+
+  zng_stream zs;
+};
+
+class ZlibNgInflater : public Inflater {
+public:
+  ZlibNgInflater()
+  {
+    zs.zalloc = nullptr;
+    zs.zfree = nullptr;
+    zs.opaque = nullptr;
+    zs.next_in = nullptr;
+    zs.avail_in = 0;
+    if (zng_inflateInit(&zs) != Z_OK)
+      throw std::runtime_error(_("Failed to initialize zlib-ng"));
+  }
+
+  ~ZlibNgInflater()
+  {
+    zng_inflateEnd(&zs);
+  }
+
+  int inflate(int flush) override
+  {
+    int rc;
+
+    zs.next_in = nextIn;
+    zs.avail_in = availIn;
+    zs.next_out = nextOut;
+    zs.avail_out = availOut;
+
+    rc = zng_inflate(&zs, flush);
+
+    nextIn = zs.next_in;
+    availIn = zs.avail_in;
+    nextOut = zs.next_out;
+    availOut = zs.avail_out;
+
+    return rc;
+  }
+
+private:
+  zng_stream zs;
+};
+
+}
+
+Deflater* rdr::createZlibNgDeflater(int level)
+{
+  return new ZlibNgDeflater(level);
+}
+
+Inflater* rdr::createZlibNgInflater()
+{
+  return new ZlibNgInflater();
+}
+
+#endif
@@ -0,0 +1,35 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifndef __RDR_ZLIBNGBACKEND_H__
+#define __RDR_ZLIBNGBACKEND_H__
+
+#ifdef HAVE_ZLIBNG
+#include <rdr/ZlibBackend.h>
+
+namespace rdr {
+
+  // zlib-ng in its native mode has its own names for everything, so
+  // it can be used alongside the normal zlib
+  Deflater* createZlibNgDeflater(int level);
+  Inflater* createZlibNgInflater();
+
+}
+
+#endif
+#endif
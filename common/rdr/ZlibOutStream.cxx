@@ -26,6 +26,7 @@
 #include <core/LogWriter.h>
 #include <core/i18n.h>
 
+#include <rdr/ZlibBackend.h>
 #include <rdr/ZlibOutStream.h>
 
 #include <zlib.h>
@@ -39,16 +40,7 @@ using namespace rdr;
 ZlibOutStream::ZlibOutStream(OutStream* os, int compressLevel)
   : underlying(os), compressionLevel(compressLevel), newLevel(compressLevel)
 {
-  zs = new z_stream;
-  zs->zalloc    = nullptr;
-  zs->zfree     = nullptr;
-  zs->opaque    = nullptr;
-  zs->next_in   = nullptr;
-  zs->avail_in  = 0;
-  if (deflateInit(zs, compressLevel) != Z_OK) {
-    delete zs;
-    throw std::runtime_error(_("Failed to initialize zlib"));
-  }
+  zs = createDeflater(compressLevel);
 }
 
 ZlibOutStream::~ZlibOutStream()
@@ -57,7 +49,6 @@ ZlibOutStream::~ZlibOutStream()
     flush();
   } catch (std::exception&) {
   }
-  deflateEnd(zs);
   delete zs;
 }
 
@@ -76,6 +67,15 @@ void ZlibOutStream::setCompressionLevel(int level)
   newLevel = level;
 }
 
+void ZlibOutStream::reset()
+{
+  if (hasBufferedData())
+    throw std::logic_error("ZlibOutStream: Reset with pending data");
+
+  if (zs->reset() != Z_OK)
+    throw std::runtime_error(_("Failed to reset zlib stream"));
+}
+
 void ZlibOutStream::flush()
 {
   BufferedOutStream::flush();
@@ -94,17 +94,17 @@ bool ZlibOutStream::flushBuffer()
 {
   checkCompressionLevel();
 
-  zs->next_in = sentUpTo;
-  zs->avail_in = ptr - sentUpTo;
+  zs->nextIn = sentUpTo;
+  zs->availIn = ptr - sentUpTo;
 
 #ifdef ZLIBOUT_DEBUG
-  vlog.debug("Flush: avail_in %d",zs->avail_in);
+  vlog.debug("Flush: avail_in %d",zs->availIn);
 #endif
 
   // Force out everything from the zlib encoder
   deflate(corked ? Z_NO_FLUSH : Z_SYNC_FLUSH);
 
-  sentUpTo = zs->next_in;
+  sentUpTo = ptr - zs->availIn;
 
   return true;
 }
@@ -116,20 +116,20 @@ void ZlibOutStream::deflate(int flush)
   if (!underlying)
     throw std::logic_error("ZlibOutStream: Underlying OutStream has not been set");
 
-  if ((flush == Z_NO_FLUSH) && (zs->avail_in == 0))
+  if ((flush == Z_NO_FLUSH) && (zs->availIn == 0))
     return;
 
   do {
     size_t chunk;
-    zs->next_out = underlying->getptr(1);
-    zs->avail_out = chunk = underlying->avail();
+    zs->nextOut = underlying->getptr(1);
+    zs->availOut = chunk = underlying->avail();
 
 #ifdef ZLIBOUT_DEBUG
     vlog.debug("Calling deflate, avail_in %d, avail_out %d",
-               zs->avail_in,zs->avail_out);
+               zs->availIn,zs->availOut);
 #endif
 
-    rc = ::deflate(zs, flush);
+    rc = zs->deflate(flush);
     if (rc < 0) {
       // Silly zlib returns an error if you try to flush something twice
       if ((rc == Z_BUF_ERROR) && (flush != Z_NO_FLUSH))
@@ -140,11 +140,11 @@ void ZlibOutStream::deflate(int flush)
 
 #ifdef ZLIBOUT_DEBUG
     vlog.debug("After deflate: %d bytes",
-               zs->next_out-underlying->getptr());
+               zs->nextOut-underlying->getptr());
 #endif
 
-    underlying->setptr(chunk - zs->avail_out);
-  } while (zs->avail_out == 0);
+    underlying->setptr(chunk - zs->availOut);
+  } while (zs->availOut == 0);
 }
 
 void ZlibOutStream::checkCompressionLevel()
@@ -153,7 +153,7 @@ void ZlibOutStream::checkCompressionLevel()
 
   if (newLevel != compressionLevel) {
 #ifdef ZLIBOUT_DEBUG
-    vlog.debug("Change: avail_in %d",zs->avail_in);
+    vlog.debug("Change: avail_in %d",zs->availIn);
 #endif
 
     // zlib is just horribly stupid. It does an implicit flush on
@@ -163,7 +163,7 @@ void ZlibOutStream::checkCompressionLevel()
     // need to do a more proper flush here first.
     deflate(Z_SYNC_FLUSH);
 
-    rc = deflateParams (zs, newLevel, Z_DEFAULT_STRATEGY);
+    rc = zs->setLevel(newLevel);
     if (rc < 0) {
       // The implicit flush can result in this error, caused by the
       // explicit flush we did above. It should be safe to ignore though
@@ -27,10 +27,10 @@
 
 #include <rdr/BufferedOutStream.h>
 
-struct z_stream_s;
-
 namespace rdr {
 
+  class Deflater;
+
   class ZlibOutStream : public BufferedOutStream {
 
   public:
@@ -40,6 +40,9 @@ namespace rdr {
 
     void setUnderlying(OutStream* os);
     void setCompressionLevel(int level=-1);
+    // Starts a new zlib stream, discarding any history. All data must
+    // have been flushed before this is called.
+    void reset();
     void flush() override;
     void cork(bool enable) override;
 
@@ -51,7 +54,7 @@ namespace rdr {
     OutStream* underlying;
     int compressionLevel;
     int newLevel;
-    z_stream_s* zs;
+    Deflater* zs;
   };
 
 } // end of namespace rdr
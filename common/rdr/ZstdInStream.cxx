@@ -0,0 +1,113 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdexcept>
+
+#include <core/i18n.h>
+
+#include <rdr/ZstdInStream.h>
+
+#ifdef HAVE_ZSTD
+
+#include <zstd.h>
+
+using namespace rdr;
+
+ZstdInStream::ZstdInStream()
+  : underlying(nullptr), bytesIn(0)
+{
+  ds = ZSTD_createDCtx();
+  if (ds == nullptr)
+    throw std::runtime_error(_("Failed to initialize zstd"));
+}
+
+ZstdInStream::~ZstdInStream()
+{
+  ZSTD_freeDCtx(ds);
+}
+
+void ZstdInStream::setUnderlying(InStream* is, size_t bytesIn_)
+{
+  underlying = is;
+  bytesIn = bytesIn_;
+  skip(avail());
+}
+
+void ZstdInStream::flushUnderlying()
+{
+  while (bytesIn > 0) {
+    if (!hasData(1))
+      throw std::runtime_error(
+        _("Failed to flush remaining stream data"));
+    skip(avail());
+  }
+
+  setUnderlying(nullptr, 0);
+}
+
+void ZstdInStream::reset()
+{
+  setUnderlying(nullptr, 0);
+  if (ZSTD_isError(ZSTD_DCtx_reset(ds, ZSTD_reset_session_only)))
+    throw std::runtime_error(_("Failed to reset zstd stream"));
+}
+
+bool ZstdInStream::fillBuffer()
+{
+  ZSTD_inBuffer input;
+  ZSTD_outBuffer output;
+  size_t length, rc;
+
+  if (!underlying)
+    throw std::logic_error("ZstdInStream overrun: No underlying stream");
+
+  // zstd can have output left over even after all input has been
+  // consumed, so we might have to call it without any input
+  length = 0;
+  if (bytesIn > 0) {
+    if (!underlying->hasData(1))
+      return false;
+    length = underlying->avail();
+    if (length > bytesIn)
+      length = bytesIn;
+  }
+
+  input.src = underlying->getptr(length);
+  input.size = length;
+  input.pos = 0;
+
+  output.dst = (uint8_t*)end;
+  output.size = availSpace();
+  output.pos = 0;
+
+  rc = ZSTD_decompressStream(ds, &output, &input);
+  if (ZSTD_isError(rc))
+    throw std::runtime_error(_("Failed to decompress data"));
+
+  bytesIn -= input.pos;
+  end += output.pos;
+  underlying->setptr(input.pos);
+
+  return (input.pos != 0) || (output.pos != 0);
+}
+
+#endif
@@ -0,0 +1,168 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdexcept>
+
+#include <core/i18n.h>
+
+#include <rdr/ZstdOutStream.h>
+
+#ifdef HAVE_ZSTD
+
+#include <zstd.h>
+
+using namespace rdr;
+
+ZstdOutStream::ZstdOutStream(OutStream* os, int compressLevel)
+  : underlying(os), compressionLevel(0), newLevel(0)
+{
+  cs = ZSTD_createCCtx();
+  if (cs == nullptr)
+    throw std::runtime_error(_("Failed to initialize zstd"));
+
+  setCompressionLevel(compressLevel);
+  compressionLevel = newLevel;
+  if (ZSTD_isError(ZSTD_CCtx_setParameter(cs, ZSTD_c_compressionLevel,
+                                          compressionLevel))) {
+    ZSTD_freeCCtx(cs);
+    throw std::runtime_error(_("Failed to initialize zstd"));
+  }
+}
+
+ZstdOutStream::~ZstdOutStream()
+{
+  try {
+    flush();
+  } catch (std::exception&) {
+  }
+  ZSTD_freeCCtx(cs);
+}
+
+void ZstdOutStream::setUnderlying(OutStream* os)
+{
+  underlying = os;
+  if (underlying)
+    underlying->cork(corked);
+}
+
+void ZstdOutStream::setCompressionLevel(int level)
+{
+  if (level < ZSTD_minCLevel() || level > ZSTD_maxCLevel())
+    level = 0;
+
+  newLevel = level;
+}
+
+void ZstdOutStream::reset()
+{
+  if (hasBufferedData())
+    throw std::logic_error("ZstdOutStream: Reset with pending data");
+
+  if (ZSTD_isError(ZSTD_CCtx_reset(cs, ZSTD_reset_session_only)))
+    throw std::runtime_error(_("Failed to reset zstd stream"));
+}
+
+void ZstdOutStream::flush()
+{
+  BufferedOutStream::flush();
+  if (underlying != nullptr)
+    underlying->flush();
+}
+
+void ZstdOutStream::cork(bool enable)
+{
+  BufferedOutStream::cork(enable);
+  if (underlying != nullptr)
+    underlying->cork(enable);
+}
+
+bool ZstdOutStream::flushBuffer()
+{
+  ZSTD_inBuffer input;
+
+  checkCompressionLevel();
+
+  input.src = sentUpTo;
+  input.size = ptr - sentUpTo;
+  input.pos = 0;
+
+  // Force out everything from the zstd encoder
+  compress(&input, corked ? ZSTD_e_continue : ZSTD_e_flush);
+
+  sentUpTo += input.pos;
+
+  return true;
+}
+
+void ZstdOutStream::compress(ZSTD_inBuffer* input, int mode)
+{
+  size_t rc;
+
+  if (!underlying)
+    throw std::logic_error("ZstdOutStream: Underlying OutStream has not been set");
+
+  if ((mode == ZSTD_e_continue) && (input->pos == input->size))
+    return;
+
+  do {
+    ZSTD_outBuffer output;
+
+    output.dst = underlying->getptr(1);
+    output.size = underlying->avail();
+    output.pos = 0;
+
+    rc = ZSTD_compressStream2(cs, &output, input,
+                              (ZSTD_EndDirective)mode);
+    if (ZSTD_isError(rc))
+      throw std::runtime_error(_("Failed to compress data"));
+
+    underlying->setptr(output.pos);
+
+    // Flushing isn't done until zstd says there is nothing left,
+    // otherwise we only need to hand over all the input
+    if (mode == ZSTD_e_continue)
+      rc = input->size - input->pos;
+  } while (rc != 0);
+}
+
+void ZstdOutStream::checkCompressionLevel()
+{
+  ZSTD_inBuffer input;
+
+  if (newLevel == compressionLevel)
+    return;
+
+  // The level can only be changed between frames, so finish the
+  // current one first. This also means losing the history.
+  input.src = nullptr;
+  input.size = 0;
+  input.pos = 0;
+  compress(&input, ZSTD_e_end);
+
+  if (ZSTD_isError(ZSTD_CCtx_setParameter(cs, ZSTD_c_compressionLevel,
+                                          newLevel)))
+    throw std::runtime_error(_("Failed to compress data"));
+
+  compressionLevel = newLevel;
+}
+
+#endif
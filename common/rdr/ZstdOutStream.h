@@ -0,0 +1,65 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// ZstdOutStream streams to a compressed data stream (underlying),
+// compressing with Zstandard on the fly.
+//
+
+#ifndef __RDR_ZSTDOUTSTREAM_H__
+#define __RDR_ZSTDOUTSTREAM_H__
+
+#ifdef HAVE_ZSTD
+#include <rdr/BufferedOutStream.h>
+
+struct ZSTD_CCtx_s;
+struct ZSTD_inBuffer_s;
+
+namespace rdr {
+
+  class ZstdOutStream : public BufferedOutStream {
+
+  public:
+
+    // A compression level of 0 gives the library default
+    ZstdOutStream(OutStream* os=nullptr, int compressionLevel=0);
+    virtual ~ZstdOutStream();
+
+    void setUnderlying(OutStream* os);
+    void setCompressionLevel(int level=0);
+    // Starts a new zstd stream, discarding any history. All data must
+    // have been flushed before this is called.
+    void reset();
+    void flush() override;
+    void cork(bool enable) override;
+
+  private:
+    bool flushBuffer() override;
+    void compress(ZSTD_inBuffer_s* input, int mode);
+    void checkCompressionLevel();
+
+    OutStream* underlying;
+    int compressionLevel;
+    int newLevel;
+    ZSTD_CCtx_s* cs;
+  };
+
+} // end of namespace rdr
+
+#endif
+#endif
@@ -0,0 +1,478 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <string.h>
+
+#include <core/ImplSelector.h>
+#include <core/LogWriter.h>
+#include <core/cpu.h>
+
+#include <rfb/BlockCompare.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__)
+#define HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace rfb;
+
+static core::LogWriter vlog("BlockCompare");
+
+static const int G = BlockCompareGranularity;
+
+// Each implementation provides two row functions:
+//
+//   differs()  - A quick check if anything in the row has changed
+//   diffMask() - Returns a bit mask of which chunks of the row have
+//                changed (one bit per BlockCompareGranularity bytes)
+//
+// The block loop is shared, and is forcibly inlined in to each
+// implementation so that it gets compiled for the right instruction
+// set.
+
+template<class Row>
+#if defined(__GNUC__)
+__attribute__((always_inline))
+#endif
+static inline bool compareRows(uint8_t* oldData, int oldStride,
+                               const uint8_t* newData, int newStride,
+                               int width, int height,
+                               core::Rect* changed)
+{
+  uint64_t columns;
+  int top, bottom;
+  int y;
+
+  assert(width <= BlockCompareMaxWidth);
+
+  columns = 0;
+  top = bottom = -1;
+
+  for (y = 0; y < height; y++) {
+    if (Row::differs(oldData, newData, width)) {
+      columns |= Row::diffMask(oldData, newData, width);
+
+      if (top == -1)
+        top = y;
+      bottom = y + 1;
+
+      memcpy(oldData, newData, width);
+    }
+
+    oldData += oldStride;
+    newData += newStride;
+  }
+
+  if (top == -1)
+    return false;
+
+  changed->tl.x = 0;
+  while (!(columns & 1)) {
+    columns >>= 1;
+    changed->tl.x += G;
+  }
+
+  changed->br.x = changed->tl.x;
+  while (columns != 0) {
+    columns >>= 1;
+    changed->br.x += G;
+  }
+  if (changed->br.x > width)
+    changed->br.x = width;
+
+  changed->tl.y = top;
+  changed->br.y = bottom;
+
+  return true;
+}
+
+// Handles the final partial chunk of a row
+static inline uint64_t diffTail(const uint8_t* oldData,
+                                const uint8_t* newData, int width)
+{
+  int tail;
+
+  tail = width % G;
+  if (tail == 0)
+    return 0;
+
+  if (memcmp(oldData + width - tail, newData + width - tail, tail) == 0)
+    return 0;
+
+  return (uint64_t)1 << (width / G);
+}
+
+struct GenericRow {
+  static inline bool differs(const uint8_t* oldData,
+                             const uint8_t* newData, int width)
+  {
+    return memcmp(oldData, newData, width) != 0;
+  }
+
+  static inline uint64_t diffMask(const uint8_t* oldData,
+                                  const uint8_t* newData, int width)
+  {
+    uint64_t mask;
+    int i;
+
+    mask = 0;
+    for (i = 0; i + G <= width; i += G) {
+      if (memcmp(oldData + i, newData + i, G) != 0)
+        mask |= (uint64_t)1 << (i / G);
+    }
+
+    return mask | diffTail(oldData, newData, width);
+  }
+};
+
+static bool compareBlockGeneric(uint8_t* oldData, int oldStride,
+                                const uint8_t* newData, int newStride,
+                                int width, int height,
+                                core::Rect* changed)
+{
+  return compareRows<GenericRow>(oldData, oldStride, newData, newStride,
+                                 width, height, changed);
+}
+
+#ifdef HAVE_SSE2
+
+struct SSE2Row {
+  static inline bool differs(const uint8_t* oldData,
+                             const uint8_t* newData, int width)
+  {
+    __m128i acc;
+    int i;
+
+    acc = _mm_setzero_si128();
+    for (i = 0; i + G <= width; i += G) {
+      __m128i a, b;
+      a = _mm_loadu_si128((const __m128i*)(oldData + i));
+      b = _mm_loadu_si128((const __m128i*)(newData + i));
+      acc = _mm_or_si128(acc, _mm_xor_si128(a, b));
+    }
+
+    acc = _mm_cmpeq_epi8(acc, _mm_setzero_si128());
+    if (_mm_movemask_epi8(acc) != 0xffff)
+      return true;
+
+    return diffTail(oldData, newData, width) != 0;
+  }
+
+  static inline uint64_t diffMask(const uint8_t* oldData,
+                                  const uint8_t* newData, int width)
+  {
+    uint64_t mask;
+    int i;
+
+    mask = 0;
+    for (i = 0; i + G <= width; i += G) {
+      __m128i a, b;
+      a = _mm_loadu_si128((const __m128i*)(oldData + i));
+      b = _mm_loadu_si128((const __m128i*)(newData + i));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xffff)
+        mask |= (uint64_t)1 << (i / G);
+    }
+
+    return mask | diffTail(oldData, newData, width);
+  }
+};
+
+static bool compareBlockSSE2(uint8_t* oldData, int oldStride,
+                             const uint8_t* newData, int newStride,
+                             int width, int height, core::Rect* changed)
+{
+  return compareRows<SSE2Row>(oldData, oldStride, newData, newStride,
+                              width, height, changed);
+}
+
+#endif
+
+#ifdef HAVE_AVX2
+
+struct AVX2Row {
+  __attribute__((target("avx2")))
+  static inline bool differs(const uint8_t* oldData,
+                             const uint8_t* newData, int width)
+  {
+    __m256i acc;
+    int i;
+
+    acc = _mm256_setzero_si256();
+    for (i = 0; i + G * 2 <= width; i += G * 2) {
+      __m256i a, b;
+      a = _mm256_loadu_si256((const __m256i*)(oldData + i));
+      b = _mm256_loadu_si256((const __m256i*)(newData + i));
+      acc = _mm256_or_si256(acc, _mm256_xor_si256(a, b));
+    }
+
+    if (!_mm256_testz_si256(acc, acc))
+      return true;
+
+    if (i + G <= width) {
+      __m128i a, b;
+      a = _mm_loadu_si128((const __m128i*)(oldData + i));
+      b = _mm_loadu_si128((const __m128i*)(newData + i));
+      a = _mm_xor_si128(a, b);
+      if (!_mm_testz_si128(a, a))
+        return true;
+    }
+
+    return diffTail(oldData, newData, width) != 0;
+  }
+
+  __attribute__((target("avx2")))
+  static inline uint64_t diffMask(const uint8_t* oldData,
+                                  const uint8_t* newData, int width)
+  {
+    uint64_t mask;
+    int i;
+
+    mask = 0;
+    for (i = 0; i + G * 2 <= width; i += G * 2) {
+      __m256i a, b;
+      uint32_t equal;
+      a = _mm256_loadu_si256((const __m256i*)(oldData + i));
+      b = _mm256_loadu_si256((const __m256i*)(newData + i));
+      equal = _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+      if ((equal & 0xffff) != 0xffff)
+        mask |= (uint64_t)1 << (i / G);
+      if ((equal >> 16) != 0xffff)
+        mask |= (uint64_t)1 << (i / G + 1);
+    }
+
+    if (i + G <= width) {
+      __m128i a, b;
+      a = _mm_loadu_si128((const __m128i*)(oldData + i));
+      b = _mm_loadu_si128((const __m128i*)(newData + i));
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xffff)
+        mask |= (uint64_t)1 << (i / G);
+    }
+
+    return mask | diffTail(oldData, newData, width);
+  }
+};
+
+__attribute__((target("avx2")))
+static bool compareBlockAVX2(uint8_t* oldData, int oldStride,
+                             const uint8_t* newData, int newStride,
+                             int width, int height, core::Rect* changed)
+{
+  return compareRows<AVX2Row>(oldData, oldStride, newData, newStride,
+                              width, height, changed);
+}
+
+#endif
+
+#ifdef HAVE_NEON
+
+struct NEONRow {
+  static inline bool differs(const uint8_t* oldData,
+                             const uint8_t* newData, int width)
+  {
+    uint8x16_t acc;
+    int i;
+
+    acc = vdupq_n_u8(0);
+    for (i = 0; i + G <= width; i += G) {
+      uint8x16_t a, b;
+      a = vld1q_u8(oldData + i);
+      b = vld1q_u8(newData + i);
+      acc = vorrq_u8(acc, veorq_u8(a, b));
+    }
+
+    if (vmaxvq_u8(acc) != 0)
+      return true;
+
+    return diffTail(oldData, newData, width) != 0;
+  }
+
+  static inline uint64_t diffMask(const uint8_t* oldData,
+                                  const uint8_t* newData, int width)
+  {
+    uint64_t mask;
+    int i;
+
+    mask = 0;
+    for (i = 0; i + G <= width; i += G) {
+      uint8x16_t a, b;
+      a = vld1q_u8(oldData + i);
+      b = vld1q_u8(newData + i);
+      if (vmaxvq_u8(veorq_u8(a, b)) != 0)
+        mask |= (uint64_t)1 << (i / G);
+    }
+
+    return mask | diffTail(oldData, newData, width);
+  }
+};
+
+static bool compareBlockNEON(uint8_t* oldData, int oldStride,
+                             const uint8_t* newData, int newStride,
+                             int width, int height, core::Rect* changed)
+{
+  return compareRows<NEONRow>(oldData, oldStride, newData, newStride,
+                              width, height, changed);
+}
+
+#endif
+
+// The hash is built from the primitives of XXH64, but is fed one row
+// at a time so that it doesn't need the pixels to be contiguous
+
+static const uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t Prime3 = 0x165667B19E3779F9ULL;
+static const uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t hashRound(uint64_t acc, uint64_t input)
+{
+  acc += input * Prime2;
+  acc = rotl64(acc, 31);
+  acc *= Prime1;
+  return acc;
+}
+
+static inline uint64_t hashMerge(uint64_t acc, uint64_t val)
+{
+  acc ^= hashRound(0, val);
+  acc = acc * Prime1 + Prime4;
+  return acc;
+}
+
+static inline void hashStripe(uint64_t v[4], const uint8_t* data)
+{
+  uint64_t lanes[4];
+
+  memcpy(lanes, data, sizeof(lanes));
+
+  v[0] = hashRound(v[0], lanes[0]);
+  v[1] = hashRound(v[1], lanes[1]);
+  v[2] = hashRound(v[2], lanes[2]);
+  v[3] = hashRound(v[3], lanes[3]);
+}
+
+uint64_t rfb::hashBlock(const uint8_t* data, int stride,
+                        int width, int height)
+{
+  uint64_t v[4];
+  uint64_t h;
+  int y;
+
+  v[0] = Prime1 + Prime2;
+  v[1] = Prime2;
+  v[2] = 0;
+  v[3] = 0 - Prime1;
+
+  for (y = 0; y < height; y++) {
+    int x;
+
+    for (x = 0; x + 32 <= width; x += 32)
+      hashStripe(v, data + x);
+
+    // Pad the end of the row with zeroes, which is safe as all rows
+    // have the same width
+    if (x < width) {
+      uint8_t stripe[32];
+
+      memset(stripe, 0, sizeof(stripe));
+      memcpy(stripe, data + x, width - x);
+      hashStripe(v, stripe);
+    }
+
+    data += stride;
+  }
+
+  h = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18);
+  h = hashMerge(h, v[0]);
+  h = hashMerge(h, v[1]);
+  h = hashMerge(h, v[2]);
+  h = hashMerge(h, v[3]);
+
+  h += (uint64_t)width * height + Prime5;
+
+  h ^= h >> 33;
+  h *= Prime2;
+  h ^= h >> 29;
+  h *= Prime3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+typedef bool (*CompareBlockFunc)(uint8_t*, int, const uint8_t*, int,
+                                 int, int, core::Rect*);
+
+struct CompareBlockImpl {
+  const char* name;
+  CompareBlockFunc func;
+  bool (*supported)();
+};
+
+// Best implementation first
+static const CompareBlockImpl impls[] = {
+#ifdef HAVE_AVX2
+  { "avx2", compareBlockAVX2, core::cpuSupportsAVX2 },
+#endif
+#ifdef HAVE_SSE2
+  { "sse2", compareBlockSSE2, nullptr },
+#endif
+#ifdef HAVE_NEON
+  { "neon", compareBlockNEON, nullptr },
+#endif
+  { "generic", compareBlockGeneric, nullptr },
+};
+
+static core::ImplSelector<CompareBlockImpl> selector(impls, &vlog);
+
+bool rfb::compareBlock(uint8_t* oldData, int oldStride,
+                       const uint8_t* newData, int newStride,
+                       int width, int height, core::Rect* changed)
+{
+  return selector.get()->func(oldData, oldStride, newData, newStride,
+                           width, height, changed);
+}
+
+const char* rfb::compareBlockImpl()
+{
+  return selector.name();
+}
+
+bool rfb::setCompareBlockImpl(const char* name)
+{
+  return selector.set(name);
+}
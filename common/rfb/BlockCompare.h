@@ -0,0 +1,56 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifndef __RFB_BLOCKCOMPARE_H__
+#define __RFB_BLOCKCOMPARE_H__
+
+#include <stdint.h>
+
+#include <core/Rect.h>
+
+namespace rfb {
+
+  // The widest block, in bytes, that compareBlock() can handle
+  static const int BlockCompareMaxWidth = 1024;
+
+  // The horizontal resolution, in bytes, of the changed area
+  static const int BlockCompareGranularity = 16;
+
+  // compareBlock() compares a block of old and new framebuffer data
+  // and copies every row that differs over to the old data. The
+  // changed area is returned in changed, in bytes relative to the
+  // start of the block. Returns false if the block is unchanged.
+  bool compareBlock(uint8_t* oldData, int oldStride,
+                    const uint8_t* newData, int newStride,
+                    int width, int height, core::Rect* changed);
+
+  // hashBlock() computes a 64-bit hash of a block of pixel data. It
+  // is fast, but should not be used for anything security related.
+  uint64_t hashBlock(const uint8_t* data, int stride,
+                     int width, int height);
+
+  // compareBlockImpl() returns the name of the implementation that
+  // compareBlock() currently uses. The best one available on this CPU
+  // is picked automatically, but setCompareBlockImpl() can be used to
+  // force a specific one. It returns false if it isn't supported.
+  const char* compareBlockImpl();
+  bool setCompareBlockImpl(const char* name);
+
+}
+
+#endif
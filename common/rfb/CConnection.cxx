@@ -1108,6 +1108,8 @@ void CConnection::updateEncodings()
   encodings.push_back(pseudoEncodingFence);
   encodings.push_back(pseudoEncodingQEMUKeyEvent);
   encodings.push_back(pseudoEncodingExtendedMouseButtons);
+  encodings.push_back(pseudoEncodingTileCache);
+  encodings.push_back(pseudoEncodingLargeRA2Messages);
 
   if (Decoder::supported(preferredEncoding)) {
     if (!noJpeg || preferredEncoding != encodingJPEG)
@@ -1116,6 +1118,11 @@ void CConnection::updateEncodings()
 
   encodings.push_back(encodingCopyRect);
 
+  // Outside the normal range, so it needs to be added separately
+  if ((preferredEncoding != encodingZstdRLE) &&
+      Decoder::supported(encodingZstdRLE))
+    encodings.push_back(encodingZstdRLE);
+
   for (int i = encodingMax; i >= 0; i--) {
     if ((i != preferredEncoding) && Decoder::supported(i)) {
       if (noJpeg && i == encodingJPEG)
@@ -61,6 +61,11 @@ core::StringParameter CSecurityTLS::X509CRL(
   "X509CRL",
   _("Path to the X.509 certificate revocation list"),
   configdirfn("x509_crl.pem"));
+core::BoolParameter CSecurityTLS::KernelTLS(
+  "KernelTLS",
+  _("Let the kernel handle the encryption once a TLS connection has "
+    "been set up (Linux only)"),
+  false);
 
 static core::LogWriter vlog("TLS");
 
@@ -175,6 +180,9 @@ bool CSecurityTLS::processMsg()
 
   checkSession();
 
+  if (KernelTLS)
+    tlssock->enableKernelTLS();
+
   cc->setStreams(&tlssock->inStream(), &tlssock->outStream());
 
   return true;
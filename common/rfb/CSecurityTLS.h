@@ -49,6 +49,7 @@ namespace rfb {
 
     static core::StringParameter X509CA;
     static core::StringParameter X509CRL;
+    static core::BoolParameter KernelTLS;
 
   protected:
     void shutdown();
@@ -29,21 +29,52 @@
 #include <core/LogWriter.h>
 #include <core/string.h>
 
+#include <rfb/BlockCompare.h>
 #include <rfb/ComparingUpdateTracker.h>
 
 using namespace rfb;
 
 static core::LogWriter vlog("ComparingUpdateTracker");
 
+// How many rounds of comparison a tile copy is kept after the tile
+// last changed, when using hashes
+static const unsigned TileCopyLifetime = 256;
+
+// Never keep copies of more than this fraction of the tiles
+static const int TileCopyFraction = 8;
+
+// Comparing is fast, so small changes aren't worth handing out to
+// other threads
+static const int ThreadedMinArea = 65536;
+
+static unsigned long long regionArea(const core::Region& region)
+{
+  std::vector<core::Rect> rects;
+  std::vector<core::Rect>::iterator i;
+  unsigned long long area;
+
+  area = 0;
+  region.get_rects(&rects);
+  for (i = rects.begin(); i != rects.end(); i++)
+    area += i->area();
+
+  return area;
+}
+
 ComparingUpdateTracker::ComparingUpdateTracker(PixelBuffer* buffer)
-  : fb(buffer), oldFb(fb->getPF(), 0, 0), firstCompare(true),
-    enabled(true), totalPixels(0), missedPixels(0)
+  : fb(buffer), oldFb(nullptr), firstCompare(true),
+    enabled(true), method(CompareCopy), threads(1),
+    scrollDetection(false), tileColumns(0), tileRows(0),
+    compareCount(0), totalPixels(0), missedPixels(0), scrolledPixels(0)
 {
     changed.assign_union(fb->getRect());
 }
 
 ComparingUpdateTracker::~ComparingUpdateTracker()
 {
+  for (CompareJob* job : jobs)
+    delete job;
+  delete oldFb;
 }
 
 
@@ -53,6 +84,7 @@ bool ComparingUpdateTracker::compare()
 {
   std::vector<core::Rect> rects;
   std::vector<core::Rect>::iterator i;
+  bool scrolled;
 
   if (!enabled)
     return false;
@@ -60,38 +92,62 @@ bool ComparingUpdateTracker::compare()
   if (firstCompare) {
     // NB: We leave the change region untouched on this iteration,
     // since in effect the entire framebuffer has changed.
-    oldFb.setSize(fb->width(), fb->height());
-
-    for (int y=0; y<fb->height(); y+=BLOCK_SIZE) {
-      core::Rect pos(0, y, fb->width(), std::min(fb->height(), y+BLOCK_SIZE));
-      int srcStride;
-      const uint8_t* srcData = fb->getBuffer(pos, &srcStride);
-      oldFb.imageRect(pos, srcData, srcStride);
-    }
+    if (method == CompareHash)
+      hashFramebuffer();
+    else
+      copyFramebuffer();
 
     firstCompare = false;
 
     return false;
   }
 
-  copied.get_rects(&rects, copy_delta.x<=0, copy_delta.y<=0);
-  for (i = rects.begin(); i != rects.end(); i++)
-    oldFb.copyRect(*i, copy_delta);
+  scrolled = false;
 
-  changed.get_rects(&rects);
+  if (method == CompareHash) {
+    // The hashes can't be moved along with the pixels
+    invalidateTiles(copied);
+    touchTiles();
+  } else {
+    if (scrollDetection && copied.is_empty())
+      scrolled = findScroll();
+
+    copied.get_rects(&rects, copy_delta.x<=0, copy_delta.y<=0);
+    for (i = rects.begin(); i != rects.end(); i++)
+      oldFb->copyRect(*i, copy_delta);
+  }
+
+  prepareBands();
+  compareBands();
 
   core::Region newChanged;
-  for (i = rects.begin(); i != rects.end(); i++)
-    compareRect(*i, &newChanged);
 
-  changed.get_rects(&rects);
-  for (i = rects.begin(); i != rects.end(); i++)
-    totalPixels += i->area();
-  newChanged.get_rects(&rects);
-  for (i = rects.begin(); i != rects.end(); i++)
-    missedPixels += i->area();
+  for (CompareJob* job : jobs)
+    newChanged.assign_union(job->newChanged);
+
+  if (method == CompareHash) {
+    compareCount++;
+
+    for (CompareJob* job : jobs)
+      compareTiles(job->changedTiles, &newChanged);
 
-  if (changed == newChanged)
+    // We looked at whole tiles, but only the changed region can
+    // actually have been modified
+    newChanged.assign_intersect(changed);
+
+    expireTileCopies();
+  }
+
+  for (size_t n = 0; n < jobs.size(); n++) {
+    bandStats[n].totalPixels += regionArea(jobs[n]->region);
+    bandStats[n].missedPixels +=
+      regionArea(newChanged.intersect(jobs[n]->band));
+  }
+
+  totalPixels += regionArea(changed);
+  missedPixels += regionArea(newChanged);
+
+  if (!scrolled && (changed == newChanged))
     return false;
 
   changed = newChanged;
@@ -112,6 +168,184 @@ void ComparingUpdateTracker::disable()
   firstCompare = true;
 }
 
+void ComparingUpdateTracker::setMethod(CompareMethod method_)
+{
+  if (method == method_)
+    return;
+
+  method = method_;
+
+  firstCompare = true;
+}
+
+void ComparingUpdateTracker::setThreads(int threads_)
+{
+  threads = threads_;
+}
+
+void ComparingUpdateTracker::setScrollDetection(bool enabled_)
+{
+  scrollDetection = enabled_;
+}
+
+void ComparingUpdateTracker::CompareJob::run()
+{
+  std::vector<core::Rect> rects;
+  std::vector<core::Rect>::iterator i;
+
+  if (tracker->method == CompareHash) {
+    tracker->hashTiles(band, &changedTiles);
+    return;
+  }
+
+  region.get_rects(&rects);
+  for (i = rects.begin(); i != rects.end(); i++)
+    tracker->compareRect(*i, &newChanged);
+}
+
+void ComparingUpdateTracker::prepareBands()
+{
+  int rows, count, height;
+
+  // Bands are whole rows of blocks, so that no block or tile is
+  // shared between two threads
+  rows = (fb->height() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+  count = std::max(std::min(threads, rows), 1);
+  height = (rows + count - 1) / count * BLOCK_SIZE;
+  if (height > 0)
+    count = std::max((fb->height() + height - 1) / height, 1);
+
+  while (jobs.size() < (size_t)count)
+    jobs.push_back(new CompareJob(this));
+  while (jobs.size() > (size_t)count) {
+    delete jobs.back();
+    jobs.pop_back();
+  }
+
+  if (bandStats.size() < (size_t)count)
+    bandStats.resize(count, {0, 0});
+
+  for (int n = 0; n < count; n++) {
+    CompareJob* job;
+
+    job = jobs[n];
+
+    job->band = {0, std::min(n * height, fb->height()),
+                 fb->width(), std::min((n + 1) * height, fb->height())};
+    job->region = changed.intersect(job->band);
+    job->newChanged.clear();
+    job->changedTiles.clear();
+  }
+}
+
+void ComparingUpdateTracker::compareBands()
+{
+  core::ThreadPool* pool;
+  bool threaded;
+  size_t n;
+
+  threaded = true;
+  if (jobs.size() <= 1)
+    threaded = false;
+  else if (core::ThreadPool::shared()->size() == 0)
+    threaded = false;
+  else if (regionArea(changed) < ThreadedMinArea)
+    threaded = false;
+
+  if (!threaded) {
+    for (CompareJob* job : jobs)
+      job->run();
+    return;
+  }
+
+  pool = core::ThreadPool::shared();
+
+  for (CompareJob* job : jobs) {
+    if (!job->region.is_empty())
+      pool->submit(job);
+  }
+
+  // The thread calling wait() picks up any band that no worker has
+  // started yet
+  n = 0;
+  try {
+    for (n = 0; n < jobs.size(); n++) {
+      if (!jobs[n]->region.is_empty())
+        pool->wait(jobs[n]);
+    }
+  } catch (...) {
+    // The jobs reference the framebuffer, so we can't leave them
+    // running
+    for (n++; n < jobs.size(); n++) {
+      if (jobs[n]->region.is_empty())
+        continue;
+      try {
+        pool->wait(jobs[n]);
+      } catch (...) {
+      }
+    }
+    throw;
+  }
+}
+
+bool ComparingUpdateTracker::findScroll()
+{
+  std::vector<core::Rect> rects;
+  std::vector<core::Rect>::iterator i;
+  core::Rect bestDest;
+  core::Point bestDelta;
+
+  // Only one copy can be sent per update, so pick the largest
+  changed.get_rects(&rects);
+  for (i = rects.begin(); i != rects.end(); i++) {
+    core::Rect r, dest;
+    core::Point delta;
+
+    r = i->intersect(fb->getRect());
+    if (r.is_empty())
+      continue;
+
+    if (!scrollDetector.detect(oldFb, fb, r, &dest, &delta))
+      continue;
+
+    if (dest.area() > bestDest.area()) {
+      bestDest = dest;
+      bestDelta = delta;
+    }
+  }
+
+  if (bestDest.is_empty())
+    return false;
+
+  // The copied area is still part of the changed region, so the
+  // comparison will take care of anything that wasn't a perfect match
+  add_copied(bestDest, bestDelta);
+
+  scrolledPixels += bestDest.area();
+
+  return true;
+}
+
+void ComparingUpdateTracker::copyFramebuffer()
+{
+  tileHashes.clear();
+  tileValid.clear();
+  tileCopies.clear();
+
+  if (oldFb == nullptr)
+    oldFb = new ManagedPixelBuffer(fb->getPF(), 0, 0);
+
+  oldFb->setSize(fb->width(), fb->height());
+
+  for (int y=0; y<fb->height(); y+=BLOCK_SIZE) {
+    core::Rect pos(0, y, fb->width(), std::min(fb->height(), y+BLOCK_SIZE));
+    int srcStride;
+    const uint8_t* srcData = fb->getBuffer(pos, &srcStride);
+    oldFb->imageRect(pos, srcData, srcStride);
+  }
+}
+
 void ComparingUpdateTracker::compareRect(const core::Rect& r,
                                          core::Region* newChanged)
 {
@@ -126,13 +360,9 @@ void ComparingUpdateTracker::compareRect(const core::Rect& r,
 
   int bytesPerPixel = fb->getPF().bpp/8;
   int oldStride;
-  uint8_t* oldData = oldFb.getBufferRW(r, &oldStride);
+  uint8_t* oldData = oldFb->getBufferRW(r, &oldStride);
   int oldStrideBytes = oldStride * bytesPerPixel;
 
-  // Used to efficiently crop the left and right of the change rectangle
-  int minCompareWidthInPixels = BLOCK_SIZE / 8;
-  int minCompareWidthInBytes = minCompareWidthInPixels * bytesPerPixel;
-
   for (int blockTop = r.tl.y; blockTop < r.br.y; blockTop += BLOCK_SIZE)
   {
     // Get a strip of the source buffer
@@ -146,104 +376,21 @@ void ComparingUpdateTracker::compareRect(const core::Rect& r,
 
     for (int blockLeft = r.tl.x; blockLeft < r.br.x; blockLeft += BLOCK_SIZE)
     {
-      const uint8_t* newPtr = newBlockPtr;
-      uint8_t* oldPtr = oldBlockPtr;
-
       int blockRight = std::min(blockLeft+BLOCK_SIZE, r.br.x);
       int blockWidthInBytes = (blockRight-blockLeft) * bytesPerPixel;
 
-      // Scan the block top to bottom, to identify the first row of change
-      for (int y = blockTop; y < blockBottom; y++)
-      {
-        if (memcmp(oldPtr, newPtr, blockWidthInBytes) != 0)
-        {
-          // Define the change rectangle using pessimistic values to start
-          int changeHeight = blockBottom - y;
-          int changeLeft = blockLeft;
-          int changeRight = blockRight;
-
-          // For every unchanged row at the bottom of the block, decrement change height
-          {
-            const uint8_t* newRowPtr = newPtr + ((changeHeight - 1) * newStrideBytes);
-            const uint8_t* oldRowPtr = oldPtr + ((changeHeight - 1) * oldStrideBytes);
-            while (changeHeight > 1 && memcmp(oldRowPtr, newRowPtr, blockWidthInBytes) == 0)
-            {
-              newRowPtr -= newStrideBytes;
-              oldRowPtr -= oldStrideBytes;
-
-              changeHeight--;
-            }
-          }
-
-          // For every unchanged column at the left of the block, increment change left
-          {
-            const uint8_t* newColumnPtr = newPtr;
-            const uint8_t* oldColumnPtr = oldPtr;
-            while (changeLeft + minCompareWidthInPixels < changeRight)
-            {
-              const uint8_t* newRowPtr = newColumnPtr;
-              const uint8_t* oldRowPtr = oldColumnPtr;
-              for (int row = 0; row < changeHeight; row++)
-              {
-                if (memcmp(oldRowPtr, newRowPtr, minCompareWidthInBytes) != 0)
-                  goto endOfChangeLeft;
-
-                newRowPtr += newStrideBytes;
-                oldRowPtr += oldStrideBytes;
-              }
-
-              newColumnPtr += minCompareWidthInBytes;
-              oldColumnPtr += minCompareWidthInBytes;
-
-              changeLeft += minCompareWidthInPixels;
-            }
-          }
-        endOfChangeLeft:
-
-          // For every unchanged column at the right of the block, decrement change right
-          {
-            const uint8_t* newColumnPtr = newPtr + blockWidthInBytes;
-            const uint8_t* oldColumnPtr = oldPtr + blockWidthInBytes;
-            while (changeLeft + minCompareWidthInPixels < changeRight)
-            {
-              newColumnPtr -= minCompareWidthInBytes;
-              oldColumnPtr -= minCompareWidthInBytes;
-
-              const uint8_t* newRowPtr = newColumnPtr;
-              const uint8_t* oldRowPtr = oldColumnPtr;
-              for (int row = 0; row < changeHeight; row++)
-              {
-                if (memcmp(oldRowPtr, newRowPtr, minCompareWidthInBytes) != 0)
-                  goto endOfChangeRight;
-
-                newRowPtr += newStrideBytes;
-                oldRowPtr += oldStrideBytes;
-              }
-
-              changeRight -= minCompareWidthInPixels;
-            }
-          }
-        endOfChangeRight:
-
-          // Block change extends from (changeLeft, y) to (changeRight,
-          // y + changeHeight)
-          newChanged->assign_union({{changeLeft, y,
-                                     changeRight, y + changeHeight}});
-
-          // Copy the change from fb to oldFb to allow future changes to be identified
-          for (int row = 0; row < changeHeight; row++)
-          {
-            memcpy(oldPtr, newPtr, blockWidthInBytes);
-            newPtr += newStrideBytes;
-            oldPtr += oldStrideBytes;
-          }
-
-          // No further processing is required for this block
-          break;
-        }
-
-        newPtr += newStrideBytes;
-        oldPtr += oldStrideBytes;
+      core::Rect change;
+
+      // Finds the changed area and also copies it over to oldFb to
+      // allow future changes to be identified
+      if (compareBlock(oldBlockPtr, oldStrideBytes,
+                       newBlockPtr, newStrideBytes,
+                       blockWidthInBytes, blockBottom - blockTop,
+                       &change)) {
+        newChanged->assign_union({{blockLeft + change.tl.x / bytesPerPixel,
+                                   blockTop + change.tl.y,
+                                   blockLeft + change.br.x / bytesPerPixel,
+                                   blockTop + change.br.y}});
       }
 
       oldBlockPtr += blockWidthInBytes;
@@ -253,7 +400,207 @@ void ComparingUpdateTracker::compareRect(const core::Rect& r,
     oldData += oldStrideBytes * BLOCK_SIZE;
   }
 
-  oldFb.commitBufferRW(r);
+  oldFb->commitBufferRW(r);
+}
+
+void ComparingUpdateTracker::hashFramebuffer()
+{
+  int bytesPerPixel;
+  int index;
+
+  // The whole point is to not keep this around
+  delete oldFb;
+  oldFb = nullptr;
+
+  tileColumns = (fb->width() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  tileRows = (fb->height() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+  tileHashes.assign(tileColumns * tileRows, 0);
+  tileValid.assign(tileColumns * tileRows, true);
+  tileCopies.clear();
+
+  bytesPerPixel = fb->getPF().bpp/8;
+
+  for (index = 0; index < tileColumns * tileRows; index++) {
+    core::Rect r;
+    const uint8_t* data;
+    int stride;
+
+    r = tileRect(index);
+    data = fb->getBuffer(r, &stride);
+
+    tileHashes[index] = hashBlock(data, stride * bytesPerPixel,
+                                  r.width() * bytesPerPixel, r.height());
+  }
+}
+
+void ComparingUpdateTracker::invalidateTiles(const core::Region& region)
+{
+  std::vector<core::Rect> rects;
+  std::vector<core::Rect>::iterator i;
+
+  region.get_rects(&rects);
+  for (i = rects.begin(); i != rects.end(); i++) {
+    core::Rect r;
+
+    r = i->intersect(fb->getRect());
+    if (r.is_empty())
+      continue;
+
+    for (int y = r.tl.y / BLOCK_SIZE; y <= (r.br.y - 1) / BLOCK_SIZE; y++) {
+      for (int x = r.tl.x / BLOCK_SIZE; x <= (r.br.x - 1) / BLOCK_SIZE; x++) {
+        tileValid[y * tileColumns + x] = false;
+        tileCopies.erase(y * tileColumns + x);
+      }
+    }
+  }
+}
+
+void ComparingUpdateTracker::touchTiles()
+{
+  std::vector<core::Rect> rects;
+  std::vector<core::Rect>::iterator i;
+
+  tileTouched.assign(tileColumns * tileRows, false);
+
+  changed.get_rects(&rects);
+  for (i = rects.begin(); i != rects.end(); i++) {
+    core::Rect r;
+
+    r = i->intersect(fb->getRect());
+    if (r.is_empty())
+      continue;
+
+    for (int y = r.tl.y / BLOCK_SIZE; y <= (r.br.y - 1) / BLOCK_SIZE; y++) {
+      for (int x = r.tl.x / BLOCK_SIZE; x <= (r.br.x - 1) / BLOCK_SIZE; x++)
+        tileTouched[y * tileColumns + x] = true;
+    }
+  }
+}
+
+void ComparingUpdateTracker::hashTiles(const core::Rect& band,
+                                       TileChanges* changedTiles)
+{
+  int bytesPerPixel;
+
+  // Only reads the shared tile state, so that bands can be hashed in
+  // parallel. The changes are applied by compareTiles() afterwards.
+
+  if (band.is_empty())
+    return;
+
+  bytesPerPixel = fb->getPF().bpp/8;
+
+  for (int index = band.tl.y / BLOCK_SIZE * tileColumns;
+       index < (band.br.y + BLOCK_SIZE - 1) / BLOCK_SIZE * tileColumns;
+       index++) {
+    core::Rect r;
+    const uint8_t* data;
+    int stride;
+    uint64_t hash;
+
+    if (!tileTouched[index])
+      continue;
+
+    r = tileRect(index);
+    data = fb->getBuffer(r, &stride);
+
+    hash = hashBlock(data, stride * bytesPerPixel,
+                     r.width() * bytesPerPixel, r.height());
+    if (tileValid[index] && (tileHashes[index] == hash))
+      continue;
+
+    changedTiles->push_back({index, hash});
+  }
+}
+
+void ComparingUpdateTracker::compareTiles(const TileChanges& changedTiles,
+                                          core::Region* newChanged)
+{
+  int bytesPerPixel;
+  size_t maxCopies;
+
+  bytesPerPixel = fb->getPF().bpp/8;
+  maxCopies = tileColumns * tileRows / TileCopyFraction;
+
+  for (const std::pair<int, uint64_t>& tile : changedTiles) {
+    int index;
+    core::Rect r;
+    const uint8_t* data;
+    int stride, strideBytes, widthBytes;
+
+    std::map<int, TileCopy>::iterator copy;
+
+    index = tile.first;
+
+    tileHashes[index] = tile.second;
+    tileValid[index] = true;
+
+    r = tileRect(index);
+    data = fb->getBuffer(r, &stride);
+
+    strideBytes = stride * bytesPerPixel;
+    widthBytes = r.width() * bytesPerPixel;
+
+    // A tile that changed recently is likely to change again, and
+    // then we can find the exact area that changed
+    copy = tileCopies.find(index);
+    if (copy != tileCopies.end()) {
+      core::Rect change;
+
+      if (compareBlock(copy->second.data.data(), widthBytes,
+                       data, strideBytes, widthBytes, r.height(),
+                       &change)) {
+        newChanged->assign_union({{r.tl.x + change.tl.x / bytesPerPixel,
+                                   r.tl.y + change.tl.y,
+                                   r.tl.x + change.br.x / bytesPerPixel,
+                                   r.tl.y + change.br.y}});
+      }
+
+      copy->second.lastChanged = compareCount;
+
+      continue;
+    }
+
+    newChanged->assign_union(r);
+
+    if (tileCopies.size() >= maxCopies)
+      continue;
+
+    TileCopy& newCopy = tileCopies[index];
+
+    newCopy.data.resize(widthBytes * r.height());
+    for (int y = 0; y < r.height(); y++) {
+      memcpy(newCopy.data.data() + y * widthBytes,
+             data + y * strideBytes, widthBytes);
+    }
+    newCopy.lastChanged = compareCount;
+  }
+}
+
+void ComparingUpdateTracker::expireTileCopies()
+{
+  std::map<int, TileCopy>::iterator iter;
+
+  iter = tileCopies.begin();
+  while (iter != tileCopies.end()) {
+    if ((compareCount - iter->second.lastChanged) > TileCopyLifetime)
+      iter = tileCopies.erase(iter);
+    else
+      ++iter;
+  }
+}
+
+core::Rect ComparingUpdateTracker::tileRect(int index) const
+{
+  core::Rect r;
+
+  r.tl.x = index % tileColumns * BLOCK_SIZE;
+  r.tl.y = index / tileColumns * BLOCK_SIZE;
+  r.br.x = r.tl.x + BLOCK_SIZE;
+  r.br.y = r.tl.y + BLOCK_SIZE;
+
+  return r.intersect(fb->getRect());
 }
 
 void ComparingUpdateTracker::logStats()
@@ -269,5 +616,19 @@ void ComparingUpdateTracker::logStats()
              core::siPrefix(missedPixels, "pixels").c_str());
   vlog.debug("(1:%g ratio)", ratio);
 
-  totalPixels = missedPixels = 0;
+  if (scrolledPixels != 0) {
+    vlog.debug("%s found scrolling",
+               core::siPrefix(scrolledPixels, "pixels").c_str());
+  }
+
+  if (bandStats.size() > 1) {
+    for (size_t n = 0; n < bandStats.size(); n++) {
+      vlog.debug("Band %d: %s in / %s out", (int)n,
+                 core::siPrefix(bandStats[n].totalPixels, "pixels").c_str(),
+                 core::siPrefix(bandStats[n].missedPixels, "pixels").c_str());
+    }
+  }
+
+  totalPixels = missedPixels = scrolledPixels = 0;
+  bandStats.clear();
 }
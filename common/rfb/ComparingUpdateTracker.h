@@ -19,7 +19,13 @@
 #ifndef __RFB_COMPARINGUPDATETRACKER_H__
 #define __RFB_COMPARINGUPDATETRACKER_H__
 
+#include <map>
+#include <vector>
+
+#include <core/ThreadPool.h>
+
 #include <rfb/PixelBuffer.h>
+#include <rfb/ScrollDetector.h>
 #include <rfb/UpdateTracker.h>
 
 namespace rfb {
@@ -42,16 +48,95 @@ namespace rfb {
     virtual void enable();
     virtual void disable();
 
+    // setMethod() selects how changes are detected. CompareCopy keeps
+    // a full copy of the framebuffer, whilst CompareHash only keeps a
+    // hash of each tile, plus copies of the tiles that have recently
+    // changed. Changing method restarts the comparison.
+
+    enum CompareMethod { CompareCopy, CompareHash };
+
+    void setMethod(CompareMethod method);
+
+    // setThreads() sets how many threads may be used to compare a
+    // large change. The framebuffer is split into that many horizontal
+    // bands, which are compared in parallel. A value of 0 or 1 keeps
+    // everything on the calling thread.
+
+    void setThreads(int threads);
+
+    // setScrollDetection() turns on looking for content that has
+    // moved, so that it can be sent as a copy. This is only done when
+    // there are no copies already, and only with CompareCopy as it
+    // needs the previous pixels.
+
+    void setScrollDetection(bool enabled);
+
     void logStats();
 
   private:
+    // Tiles with a new hash, and that hash
+    typedef std::vector<std::pair<int, uint64_t>> TileChanges;
+
+    struct CompareJob : public core::ThreadPool::Job {
+      CompareJob(ComparingUpdateTracker* tracker_) : tracker(tracker_) {}
+      void run() override;
+
+      ComparingUpdateTracker* tracker;
+
+      core::Rect band;
+      core::Region region;
+      core::Region newChanged;
+      TileChanges changedTiles;
+    };
+
+    void prepareBands();
+    void compareBands();
+
+    bool findScroll();
+
+    void copyFramebuffer();
     void compareRect(const core::Rect& r, core::Region* newchanged);
+
+    void hashFramebuffer();
+    void invalidateTiles(const core::Region& region);
+    void touchTiles();
+    void hashTiles(const core::Rect& band, TileChanges* changedTiles);
+    void compareTiles(const TileChanges& changedTiles,
+                      core::Region* newChanged);
+    void expireTileCopies();
+
+    core::Rect tileRect(int index) const;
+
     PixelBuffer* fb;
-    ManagedPixelBuffer oldFb;
+    ManagedPixelBuffer* oldFb;
     bool firstCompare;
     bool enabled;
+    CompareMethod method;
+    int threads;
+    bool scrollDetection;
+
+    ScrollDetector scrollDetector;
+
+    std::vector<CompareJob*> jobs;
+
+    int tileColumns, tileRows;
+    std::vector<uint64_t> tileHashes;
+    std::vector<bool> tileValid;
+    std::vector<bool> tileTouched;
+
+    struct TileCopy {
+      std::vector<uint8_t> data;
+      unsigned lastChanged;
+    };
+    std::map<int, TileCopy> tileCopies;
+    unsigned compareCount;
+
+    unsigned long long totalPixels, missedPixels, scrolledPixels;
 
-    unsigned long long totalPixels, missedPixels;
+    struct BandStats {
+      unsigned long long totalPixels, missedPixels;
+    };
+    std::vector<BandStats> bandStats;
   };
 
 }
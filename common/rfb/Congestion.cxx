@@ -315,6 +315,14 @@ size_t Congestion::getBandwidth()
   return bandwidth;
 }
 
+int Congestion::getRTT()
+{
+  if (safeBaseRTT == (unsigned)-1)
+    return -1;
+
+  return safeBaseRTT;
+}
+
 void Congestion::debugTrace(const char* filename, int fd)
 {
   (void)filename;
@@ -51,6 +51,10 @@ namespace rfb {
     // per second.
     size_t getBandwidth();
 
+    // getRTT() returns the current estimation of the round trip time
+    // in milliseconds, or -1 if there hasn't been any measurements yet.
+    int getRTT();
+
     // debugTrace() writes the current congestion window, as well as the
     // congestion window of the underlying TCP layer, to the specified
     // file
@@ -44,10 +44,6 @@ DecodeManager::DecodeManager(CConnection *conn_) :
 {
   size_t cpuCount;
 
-  memset(decoders, 0, sizeof(decoders));
-
-  memset(stats, 0, sizeof(stats));
-
   cpuCount = std::thread::hardware_concurrency();
   if (cpuCount == 0) {
     vlog.error(_("Unable to determine the number of CPU cores on this system"));
@@ -86,8 +82,8 @@ DecodeManager::~DecodeManager()
     freeBuffers.pop_back();
   }
 
-  for (Decoder* decoder : decoders)
-    delete decoder;
+  for (const std::pair<const int, Decoder*>& decoder : decoders)
+    delete decoder.second;
 
   delete partialEntry;
 }
@@ -108,12 +104,13 @@ bool DecodeManager::decodeRect(const core::Rect& r, int encoding,
       throw protocol_error(_("Unknown encoding"));
     }
 
-    if (!decoders[encoding]) {
-      decoders[encoding] = Decoder::createDecoder(encoding);
-      if (!decoders[encoding]) {
+    if (decoders.count(encoding) == 0) {
+      decoder = Decoder::createDecoder(encoding);
+      if (!decoder) {
         vlog.error(_("Unknown encoding %d"), encoding);
         throw protocol_error(_("Unknown encoding"));
       }
+      decoders[encoding] = decoder;
     }
 
     decoder = decoders[encoding];
@@ -203,7 +200,7 @@ void DecodeManager::flush()
 
 void DecodeManager::logStats()
 {
-  size_t i;
+  std::map<int, DecoderStats>::const_iterator iter;
 
   unsigned rects;
   unsigned long long pixels, bytes, equivalent;
@@ -213,27 +210,31 @@ void DecodeManager::logStats()
   rects = 0;
   pixels = bytes = equivalent = 0;
 
-  for (i = 0;i < (sizeof(stats)/sizeof(stats[0]));i++) {
+  for (iter = stats.begin(); iter != stats.end(); ++iter) {
+    const char* name;
+
     // Did this class do anything at all?
-    if (stats[i].rects == 0)
+    if (iter->second.rects == 0)
       continue;
 
-    rects += stats[i].rects;
-    pixels += stats[i].pixels;
-    bytes += stats[i].bytes;
-    equivalent += stats[i].equivalent;
+    rects += iter->second.rects;
+    pixels += iter->second.pixels;
+    bytes += iter->second.bytes;
+    equivalent += iter->second.equivalent;
+
+    ratio = (double)iter->second.equivalent / iter->second.bytes;
 
-    ratio = (double)stats[i].equivalent / stats[i].bytes;
+    name = encodingName(iter->first);
 
-    vlog.info("    %s: %s, %s", encodingName(i),
+    vlog.info("    %s: %s, %s", name,
               // TRANSLATORS: Will get a SI prefix before (k/M/G/...)
-              core::siPrefix(stats[i].rects, _("rects")).c_str(),
+              core::siPrefix(iter->second.rects, _("rects")).c_str(),
               // TRANSLATORS: Will get a SI prefix before (k/M/G/...)
-              core::siPrefix(stats[i].pixels, _("pixels")).c_str());
+              core::siPrefix(iter->second.pixels, _("pixels")).c_str());
     vlog.info("    %*s  %s (1:%g %s)",
-              (int)strlen(encodingName(i)), "",
+              (int)strlen(name), "",
               // TRANSLATORS: Short form of bytes
-              core::iecPrefix(stats[i].bytes, _("B")).c_str(),
+              core::iecPrefix(iter->second.bytes, _("B")).c_str(),
               ratio, _("ratio"));
   }
 
@@ -22,6 +22,7 @@
 #include <condition_variable>
 #include <exception>
 #include <list>
+#include <map>
 #include <mutex>
 #include <thread>
 
@@ -61,7 +62,9 @@ namespace rfb {
 
   private:
     CConnection *conn;
-    Decoder *decoders[encodingMax+1];
+    // Pseudo-encodings can also carry pixel data, so these can't be
+    // indexed directly
+    std::map<int, Decoder*> decoders;
 
     struct DecoderStats {
       unsigned rects;
@@ -70,7 +73,7 @@ namespace rfb {
       unsigned long long equivalent;
     };
 
-    DecoderStats stats[encodingMax+1];
+    std::map<int, DecoderStats> stats;
     size_t beforePos;
 
     struct QueueEntry {
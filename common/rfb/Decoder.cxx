@@ -34,9 +34,13 @@
 #include <rfb/JPEGDecoder.h>
 #include <rfb/ZRLEDecoder.h>
 #include <rfb/TightDecoder.h>
+#include <rfb/TileCacheDecoder.h>
 #ifdef HAVE_H264
 #include <rfb/H264Decoder.h>
 #endif
+#ifdef HAVE_ZSTD
+#include <rfb/ZstdRLEDecoder.h>
+#endif
 
 using namespace rfb;
 
@@ -80,6 +84,10 @@ bool Decoder::supported(int encoding)
   case encodingTight:
 #ifdef HAVE_H264
   case encodingH264:
+#endif
+  case pseudoEncodingTileCache:
+#ifdef HAVE_ZSTD
+  case encodingZstdRLE:
 #endif
     return true;
   default:
@@ -107,6 +115,12 @@ Decoder* Decoder::createDecoder(int encoding)
 #ifdef HAVE_H264
   case encodingH264:
     return new H264Decoder();
+#endif
+  case pseudoEncodingTileCache:
+    return new TileCacheDecoder();
+#ifdef HAVE_ZSTD
+  case encodingZstdRLE:
+    return new ZstdRLEDecoder();
 #endif
   default:
     return nullptr;
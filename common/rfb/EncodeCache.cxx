@@ -0,0 +1,217 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <iterator>
+
+#include <core/LogWriter.h>
+#include <core/Region.h>
+#include <core/string.h>
+
+#include <rfb/EncodeCache.h>
+
+using namespace rfb;
+
+static core::LogWriter vlog("EncodeCache");
+
+// Entries are only useful while the clients catch up with the same
+// changes, so there is no point in keeping a lot of them
+static const size_t MaxCacheSize = 64 * 1024 * 1024;
+
+EncodeCache::EncodeCache()
+  : totalSize(0), hits(0), misses(0), bytesSaved(0)
+{
+}
+
+EncodeCache::~EncodeCache()
+{
+}
+
+void EncodeCache::setParams(const EncodeManager* user,
+                            const Params& params)
+{
+  users[user] = params;
+}
+
+void EncodeCache::removeUser(const EncodeManager* user)
+{
+  users.erase(user);
+}
+
+bool EncodeCache::isShared(const Params& params) const
+{
+  int count;
+
+  count = 0;
+  for (const auto& user : users) {
+    if (user.second != params)
+      continue;
+    count++;
+    if (count > 1)
+      return true;
+  }
+
+  return false;
+}
+
+const std::vector<uint8_t>* EncodeCache::lookup(const core::Rect& rect,
+                                                const Params& params,
+                                                int* type)
+{
+  return lookupShared(rect, params, type).get();
+}
+
+EncodeCache::Data EncodeCache::lookupShared(const core::Rect& rect,
+                                            const Params& params,
+                                            int* type)
+{
+  std::map<Key, EntryList::iterator>::const_iterator iter;
+
+  iter = index.find(makeKey(rect, params));
+  if (iter == index.end())
+    return nullptr;
+
+  hits++;
+  bytesSaved += iter->second->data->size();
+
+  *type = iter->second->type;
+  return iter->second->data;
+}
+
+bool EncodeCache::contains(const core::Rect& rect,
+                           const Params& params) const
+{
+  return index.count(makeKey(rect, params)) != 0;
+}
+
+EncodeCache::Data EncodeCache::insert(const core::Rect& rect,
+                                      const Params& params, int type,
+                                      const uint8_t* data, size_t length)
+{
+  Key key;
+  std::map<Key, EntryList::iterator>::iterator iter;
+
+  // Anything inserted is something we had to encode
+  misses++;
+
+  if (length > MaxCacheSize)
+    return nullptr;
+
+  key = makeKey(rect, params);
+
+  iter = index.find(key);
+  if (iter != index.end())
+    remove(iter->second);
+
+  while ((totalSize + length) > MaxCacheSize)
+    remove(entries.begin());
+
+  entries.emplace_back();
+  entries.back().key = key;
+  entries.back().rect = rect;
+  entries.back().type = type;
+  entries.back().data =
+    std::make_shared<const std::vector<uint8_t>>(data, data + length);
+
+  index[key] = std::prev(entries.end());
+  totalSize += length;
+
+  return entries.back().data;
+}
+
+void EncodeCache::invalidate(const core::Region& changed)
+{
+  std::vector<core::Rect> rects;
+  core::Rect bounds;
+  EntryList::iterator entry;
+
+  if (entries.empty())
+    return;
+
+  changed.get_rects(&rects);
+  if (rects.empty())
+    return;
+
+  bounds = changed.get_bounding_rect();
+
+  entry = entries.begin();
+  while (entry != entries.end()) {
+    EntryList::iterator next;
+    bool overlaps;
+
+    next = std::next(entry);
+
+    overlaps = false;
+    if (entry->rect.overlaps(bounds)) {
+      for (const core::Rect& rect : rects) {
+        if (entry->rect.overlaps(rect)) {
+          overlaps = true;
+          break;
+        }
+      }
+    }
+
+    if (overlaps)
+      remove(entry);
+
+    entry = next;
+  }
+}
+
+void EncodeCache::clear()
+{
+  entries.clear();
+  index.clear();
+  totalSize = 0;
+}
+
+void EncodeCache::logStats()
+{
+  if ((hits == 0) && (misses == 0))
+    return;
+
+  vlog.debug("%llu hits, %llu misses, %s saved", hits, misses,
+             core::iecPrefix(bytesSaved, "B").c_str());
+
+  hits = misses = bytesSaved = 0;
+}
+
+EncodeCache::Key EncodeCache::makeKey(const core::Rect& rect,
+                                      const Params& params)
+{
+  Key key;
+
+  key.reserve(params.size() + 4);
+  key.push_back(rect.tl.x);
+  key.push_back(rect.tl.y);
+  key.push_back(rect.br.x);
+  key.push_back(rect.br.y);
+  key.insert(key.end(), params.begin(), params.end());
+
+  return key;
+}
+
+void EncodeCache::remove(EntryList::iterator entry)
+{
+  totalSize -= entry->data->size();
+  index.erase(entry->key);
+  entries.erase(entry);
+}
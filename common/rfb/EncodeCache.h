@@ -0,0 +1,128 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifndef __RFB_ENCODECACHE_H__
+#define __RFB_ENCODECACHE_H__
+
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <stdint.h>
+
+#include <core/Rect.h>
+
+namespace core { class Region; }
+
+namespace rfb {
+
+  class EncodeManager;
+
+  /* EncodeCache
+
+     Keeps encoded rects around so that clients that would encode the
+     same framebuffer area in exactly the same way can reuse the data
+     rather than doing the work again. Typical for many view-only
+     clients connected to the same desktop.
+
+     Entries are only valid as long as the framebuffer contents are
+     unchanged, so the server must call invalidate() for every area
+     that is modified. The encoded data must also be self-contained,
+     i.e. not depend on any compression history in the client.
+  */
+
+  class EncodeCache {
+  public:
+    // Everything that affects the encoded data, other than the
+    // framebuffer contents
+    typedef std::vector<int> Params;
+    // Entries can be kept alive after they have been dropped, e.g. by
+    // a stream that sends them without copying
+    typedef std::shared_ptr<const std::vector<uint8_t>> Data;
+
+    EncodeCache();
+    ~EncodeCache();
+
+    // setParams()
+    //   Registers the parameters a client is currently using, so that
+    //   the cache knows if anyone else can make use of its entries.
+    void setParams(const EncodeManager* user, const Params& params);
+    void removeUser(const EncodeManager* user);
+
+    // isShared()
+    //   Returns true if more than one client is currently using the
+    //   given parameters.
+    bool isShared(const Params& params) const;
+
+    // lookup()
+    //   Returns the encoded data for the rect, or nullptr if there is
+    //   none. The data stays valid until the next call to insert(),
+    //   invalidate() or clear().
+    const std::vector<uint8_t>* lookup(const core::Rect& rect,
+                                       const Params& params, int* type);
+    // lookupShared()
+    //   Like lookup(), but the data stays valid for as long as the
+    //   caller keeps the reference.
+    Data lookupShared(const core::Rect& rect, const Params& params,
+                      int* type);
+    bool contains(const core::Rect& rect, const Params& params) const;
+
+    // insert()
+    //   Returns the new entry, or nullptr if the data is too large to
+    //   be cached.
+    Data insert(const core::Rect& rect, const Params& params, int type,
+                const uint8_t* data, size_t length);
+
+    // invalidate()
+    //   Drops every entry that overlaps the given area.
+    void invalidate(const core::Region& changed);
+    void clear();
+
+    void logStats();
+
+  protected:
+    typedef std::vector<int> Key;
+
+    struct Entry {
+      Key key;
+      core::Rect rect;
+      int type;
+      Data data;
+    };
+
+    typedef std::list<Entry> EntryList;
+
+    static Key makeKey(const core::Rect& rect, const Params& params);
+
+    void remove(EntryList::iterator entry);
+
+    // Oldest entries first
+    EntryList entries;
+    std::map<Key, EntryList::iterator> index;
+    size_t totalSize;
+
+    std::map<const EncodeManager*, Params> users;
+
+    unsigned long long hits, misses;
+    unsigned long long bytesSaved;
+  };
+
+}
+
+#endif
@@ -23,18 +23,25 @@
 #include <config.h>
 #endif
 
+#include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <sys/time.h>
 
 #include <core/LogWriter.h>
 #include <core/i18n.h>
 #include <core/string.h>
 
+#include <rfb/BlockCompare.h>
 #include <rfb/Cursor.h>
 #include <rfb/EncodeManager.h>
 #include <rfb/Encoder.h>
+#include <rfb/H264EncoderContext.h>
 #include <rfb/Palette.h>
+#include <rfb/PixelScan.h>
 #include <rfb/SConnection.h>
 #include <rfb/SMsgWriter.h>
+#include <rfb/ServerCore.h>
 #include <rfb/UpdateTracker.h>
 #include <rfb/encodings.h>
 
@@ -43,8 +50,12 @@
 #include <rfb/HextileEncoder.h>
 #include <rfb/JPEGEncoder.h>
 #include <rfb/ZRLEEncoder.h>
+#ifdef HAVE_ZSTD
+#include <rfb/ZstdRLEEncoder.h>
+#endif
 #include <rfb/TightEncoder.h>
 #include <rfb/TightJPEGEncoder.h>
+#include <rfb/H264Encoder.h>
 
 using namespace rfb;
 
@@ -61,9 +72,90 @@ static const int SolidSearchBlock = 16;
 // Don't bother with blocks smaller than this
 static const int SolidBlockMinArea = 2048;
 
+// Size of the tiles kept in the client's tile cache. They are aligned
+// to this grid so that the same content in the same place always gets
+// the same hash.
+static const int CachedTileSize = 64;
+
 // How long we consider a region recently changed (in ms)
 static const int RecentChangeTimeout = 50;
 
+// Sub-rects smaller than this are encoded directly rather than being
+// handed to a worker thread. The overhead isn't worth it, and we would
+// also lose the compression history for the many small rects.
+static const int ThreadedMinArea = 16384;
+
+// Rough costs used when deciding how to split up areas that will be
+// sent using a lossy encoder, in microseconds. Every slice needs its
+// own set of headers and a trip through the thread pool, so we only
+// want as many as it takes to keep all the threads busy.
+static const int LossySliceCost = 150;
+static const int LossyMegapixelCost = 15000;
+
+// Lossy slices are a multiple of this height so that the edges line
+// up with what the encoder works with internally
+static const int LossySliceAlign = 16;
+
+static bool isWithin(const core::Rect& rect, const core::Region& region)
+{
+  if (region.is_empty())
+    return false;
+
+  return core::Region(rect).subtract(region).is_empty();
+}
+
+static void splitLossyRect(const core::Rect& rect, size_t threads,
+                           std::vector<core::Rect>* rects)
+{
+  int columns, maxSlices, slices, sh;
+  unsigned bestCost;
+  core::Rect sr;
+
+  // The width limit is still needed for Tight
+  columns = (rect.width() + SubRectMaxWidth - 1) / SubRectMaxWidth;
+
+  maxSlices = (rect.height() + LossySliceAlign - 1) / LossySliceAlign;
+
+  // Estimate how long it takes until the last slice is done for each
+  // number of slices, and pick the fastest
+  slices = 1;
+  bestCost = UINT_MAX;
+  for (int n = 1; n <= maxSlices; n++) {
+    size_t pieces, rounds;
+    unsigned cost;
+
+    pieces = (size_t)n * columns;
+    rounds = (pieces + threads - 1) / threads;
+
+    cost = (unsigned long long)rect.area() * LossyMegapixelCost /
+           1000000 / pieces * rounds;
+    cost += pieces * LossySliceCost;
+
+    if (cost < bestCost) {
+      bestCost = cost;
+      slices = n;
+    }
+  }
+
+  sh = (rect.height() + slices - 1) / slices;
+  sh = (sh + LossySliceAlign - 1) / LossySliceAlign * LossySliceAlign;
+
+  for (sr.tl.y = rect.tl.y; sr.tl.y < rect.br.y; sr.tl.y += sh) {
+    sr.br.y = sr.tl.y + sh;
+    if (sr.br.y > rect.br.y)
+      sr.br.y = rect.br.y;
+
+    for (sr.tl.x = rect.tl.x; sr.tl.x < rect.br.x;
+         sr.tl.x += SubRectMaxWidth) {
+      sr.br.x = sr.tl.x + SubRectMaxWidth;
+      if (sr.br.x > rect.br.x)
+        sr.br.x = rect.br.x;
+
+      rects->push_back(sr);
+    }
+  }
+}
+
 namespace rfb {
 
 enum EncoderClass {
@@ -73,7 +165,11 @@ enum EncoderClass {
   encoderTight,
   encoderTightJPEG,
   encoderZRLE,
+#ifdef HAVE_ZSTD
+  encoderZstdRLE,
+#endif
   encoderJPEG,
+  encoderH264,
   encoderClassMax,
 };
 
@@ -109,8 +205,14 @@ static const char *encoderClassName(EncoderClass klass)
     return "Tight (JPEG)";
   case encoderZRLE:
     return "ZRLE";
+#ifdef HAVE_ZSTD
+  case encoderZstdRLE:
+    return "ZstdRLE";
+#endif
   case encoderJPEG:
     return "JPEG";
+  case encoderH264:
+    return "H.264";
   case encoderClassMax:
     break;
   }
@@ -140,24 +242,27 @@ static const char *encoderTypeName(EncoderType type)
   return _("Unknown encoder type");
 }
 
-EncodeManager::EncodeManager(SConnection* conn_)
-  : conn(conn_), recentChangeTimer(this)
+EncodeManager::EncodeManager(SConnection* conn_, EncodeCache* cache_,
+                             core::ThreadPool* pool_)
+  : conn(conn_), lossyAllowed(true), cache(cache_), pool(pool_),
+    recentChangeTimer(this), tileCacheGeneration(0),
+    updateJob(nullptr), updating(false)
 {
   StatsVector::iterator iter;
+  int klass;
+
+  if (pool == nullptr)
+    pool = core::ThreadPool::shared();
 
   encoders.resize(encoderClassMax, nullptr);
   activeEncoders.resize(encoderTypeMax, encoderRaw);
 
-  encoders[encoderRaw] = new RawEncoder(conn);
-  encoders[encoderRRE] = new RREEncoder(conn);
-  encoders[encoderHextile] = new HextileEncoder(conn);
-  encoders[encoderTight] = new TightEncoder(conn);
-  encoders[encoderTightJPEG] = new TightJPEGEncoder(conn);
-  encoders[encoderZRLE] = new ZRLEEncoder(conn);
-  encoders[encoderJPEG] = new JPEGEncoder(conn);
+  for (klass = 0; klass < encoderClassMax; klass++)
+    encoders[klass] = createEncoder(klass);
 
   updates = 0;
   memset(&copyStats, 0, sizeof(copyStats));
+  memset(&tileCacheStats, 0, sizeof(tileCacheStats));
   stats.resize(encoderClassMax);
   for (iter = stats.begin();iter != stats.end();++iter) {
     StatsVector::value_type::iterator iter2;
@@ -169,8 +274,23 @@ EncodeManager::EncodeManager(SConnection* conn_)
 
 EncodeManager::~EncodeManager()
 {
+  if (updating) {
+    try {
+      finishUpdate();
+    } catch (...) {
+    }
+  }
+
+  delete updateJob;
+
   logStats();
 
+  if (cache != nullptr)
+    cache->removeUser(this);
+
+  for (EncodeJob* job : jobs)
+    delete job;
+
   for (Encoder* encoder : encoders)
     delete encoder;
 }
@@ -211,6 +331,28 @@ void EncodeManager::logStats()
               ratio, _("ratio"));
   }
 
+  if (tileCacheStats.rects != 0) {
+    vlog.info("  %s:", "TileCache");
+
+    rects += tileCacheStats.rects;
+    pixels += tileCacheStats.pixels;
+    bytes += tileCacheStats.bytes;
+    equivalent += tileCacheStats.equivalent;
+
+    ratio = (double)tileCacheStats.equivalent / tileCacheStats.bytes;
+
+    vlog.info("    %s: %s, %s", _("Cached"),
+              // TRANSLATORS: Will get a SI prefix before (k/M/G/...)
+              core::siPrefix(tileCacheStats.rects, _("rects")).c_str(),
+              // TRANSLATORS: Will get a SI prefix before (k/M/G/...)
+              core::siPrefix(tileCacheStats.pixels, _("pixels")).c_str());
+    vlog.info("    %*s  %s (1:%g %s)",
+              (int)strlen(_("Cached")), "",
+              // TRANSLATORS: Short form of bytes
+              core::iecPrefix(tileCacheStats.bytes, _("B")).c_str(),
+              ratio, _("ratio"));
+  }
+
   for (i = 0;i < stats.size();i++) {
     // Did this class do anything at all?
     for (j = 0;j < stats[i].size();j++) {
@@ -269,7 +411,12 @@ bool EncodeManager::supported(int encoding)
   case encodingJPEG:
   case encodingZRLE:
   case encodingTight:
+#ifdef HAVE_ZSTD
+  case encodingZstdRLE:
+#endif
     return true;
+  case encodingH264:
+    return H264EncoderContext::isAvailable();
   default:
     return false;
   }
@@ -305,9 +452,15 @@ void EncodeManager::forceRefresh(const core::Region& req)
     pendingRefreshRegion.assign_union(req);
 }
 
+void EncodeManager::setNetworkEstimate(size_t bandwidth, int rtt)
+{
+  qualityController.setNetwork(bandwidth, rtt);
+}
+
 void EncodeManager::writeUpdate(const UpdateInfo& ui, const PixelBuffer* pb,
                                 const RenderedCursor* renderedCursor)
 {
+  prepareEncoders(true);
   doUpdate(true, ui.changed, ui.copied, ui.copy_delta, pb, renderedCursor);
 
   recentlyChangedRegion.assign_union(ui.changed);
@@ -321,16 +474,110 @@ void EncodeManager::writeLosslessRefresh(const core::Region& req,
                                          const RenderedCursor* renderedCursor,
                                          size_t maxUpdateSize)
 {
+  prepareEncoders(false);
   doUpdate(false, getLosslessRefresh(req, maxUpdateSize),
            {}, {}, pb, renderedCursor);
 }
 
+void EncodeManager::startUpdate(const UpdateInfo& ui,
+                                const PixelBuffer* pb,
+                                const RenderedCursor* renderedCursor,
+                                UpdateCallback* cb)
+{
+  core::Region needed;
+  std::vector<core::Rect> rects;
+
+  assert(!updating);
+
+  if (snapshot.getPF() != pb->getPF())
+    snapshot.setPF(pb->getPF());
+  if ((snapshot.width() != pb->width()) ||
+      (snapshot.height() != pb->height()))
+    snapshot.setSize(pb->width(), pb->height());
+
+  needed = ui.changed;
+  if (!conn->client.supportsEncoding(encodingCopyRect))
+    needed.assign_union(ui.copied);
+
+  needed.get_rects(&rects);
+  for (const core::Rect& rect : rects) {
+    const uint8_t* data;
+    int stride;
+
+    data = pb->getBuffer(rect, &stride);
+    snapshot.imageRect(rect, data, stride);
+  }
+
+  // The cursor is drawn straight on to the copy, so it doesn't need
+  // one of its own
+  if (renderedCursor != nullptr) {
+    needed.assign_intersect(renderedCursor->getEffectiveRect());
+    needed.get_rects(&rects);
+    for (const core::Rect& rect : rects) {
+      const uint8_t* data;
+      int stride;
+
+      data = renderedCursor->getBuffer(rect, &stride);
+      snapshot.imageRect(rect, data, stride);
+    }
+  }
+
+  updating = true;
+
+  // Anything that touches the cache or the timers has to be done
+  // here, as neither can be used from another thread
+  prepareEncoders(true);
+
+  recentlyChangedRegion.assign_union(ui.changed);
+  recentlyChangedRegion.assign_union(ui.copied);
+  if (!recentChangeTimer.isStarted())
+    recentChangeTimer.start(RecentChangeTimeout);
+
+  if (updateJob == nullptr)
+    updateJob = new UpdateJob(this);
+
+  updateJob->changed = ui.changed;
+  updateJob->copied = ui.copied;
+  updateJob->copyDelta = ui.copy_delta;
+  updateJob->cb = cb;
+
+  pool->submit(updateJob);
+}
+
+void EncodeManager::finishUpdate()
+{
+  assert(updating);
+
+  updating = false;
+
+  pool->wait(updateJob);
+}
+
+bool EncodeManager::isUpdateDone()
+{
+  assert(updating);
+
+  return pool->isFinished(updateJob);
+}
+
 void EncodeManager::handleTimeout(core::Timer* t)
 {
   if (t == &recentChangeTimer) {
+    struct timeval now;
+
+    // The background thread owns everything until it is done
+    if (updating) {
+      t->repeat();
+      return;
+    }
+
     // Any lossy region that wasn't recently updated can
-    // now be scheduled for a refresh
-    pendingRefreshRegion.assign_union(lossyRegion.subtract(recentlyChangedRegion));
+    // now be scheduled for a refresh, except for video that will
+    // probably change again before the refresh is even seen
+    gettimeofday(&now, nullptr);
+    videoRegion = classifier.getRegion(contentVideo, &now);
+    pendingRefreshRegion.assign_union(lossyRegion.subtract(recentlyChangedRegion)
+                                                 .subtract(videoRegion));
     recentlyChangedRegion.clear();
 
     // Will there be more to do? (i.e. do we need another round)
@@ -348,10 +595,25 @@ void EncodeManager::doUpdate(bool allowLossy, const
 {
     int nRects;
     core::Region changed, cursorRegion;
+    struct timeval now, end;
+    bool useTileCache;
+    TileList newTiles;
+    size_t startLength;
 
     updates++;
 
-    prepareEncoders(allowLossy);
+    // Refreshes aren't new content, so they shouldn't affect how we
+    // classify things
+    gettimeofday(&now, nullptr);
+    startLength = conn->getOutStream()->length();
+
+    classifier.setSize(pb->width(), pb->height());
+    if (allowLossy)
+      classifier.update(changed_, copied, &now);
+
+    videoRegion = classifier.getRegion(contentVideo, &now);
+    textRegion = classifier.getRegion(contentStatic, &now);
+    textRegion.assign_union(classifier.getRegion(contentScrolling, &now));
 
     changed = changed_;
 
@@ -389,10 +651,36 @@ void EncodeManager::doUpdate(bool allowLossy, const
     if (conn->client.supportsEncoding(pseudoEncodingLastRect))
       writeSolidRects(&changed, pb);
 
-    writeRects(changed, pb);
-    writeRects(cursorRegion, renderedCursor);
+    // The cache can replace any number of rects, so we can only use
+    // it if we don't have to count them beforehand
+    useTileCache = conn->client.supportsEncoding(pseudoEncodingTileCache) &&
+                   conn->client.supportsEncoding(pseudoEncodingLastRect);
+
+    if (useTileCache)
+      writeCachedTiles(&changed, pb, &newTiles);
+
+    writeRects(changed, pb, true);
+    writeRects(cursorRegion, renderedCursor, false);
+
+    // The client must have the new tiles before it can store them
+    if (useTileCache)
+      writeStoreTiles(newTiles);
 
     conn->writer()->writeFramebufferUpdateEnd();
+
+    // Refreshes are sized to fit the bandwidth, so they don't tell us
+    // anything useful
+    if (allowLossy && Server::adaptiveQuality &&
+        (Server::frameRate > 0)) {
+      unsigned encodeTime;
+
+      gettimeofday(&end, nullptr);
+      encodeTime = (end.tv_sec - now.tv_sec) * 1000000 +
+                   (end.tv_usec - now.tv_usec);
+
+      qualityController.update(conn->getOutStream()->length() - startLength,
+                               encodeTime, 1000 / Server::frameRate, &end);
+    }
 }
 
 void EncodeManager::prepareEncoders(bool allowLossy)
@@ -404,6 +692,16 @@ void EncodeManager::prepareEncoders(bool allowLossy)
 
   std::vector<int>::iterator iter;
 
+  lossyAllowed = allowLossy;
+
+  // The client's settings are the starting point for any adjustments
+  if (!Server::adaptiveQuality)
+    qualityController = QualityController();
+  qualityController.setClientSettings(conn->client.compressLevel,
+                                      conn->client.qualityLevel,
+                                      conn->client.fineQualityLevel,
+                                      conn->client.subsampling);
+
   solid = bitmap = bitmapRLE = encoderRaw;
   indexed = indexedRLE = fullColour = encoderRaw;
 
@@ -434,9 +732,20 @@ void EncodeManager::prepareEncoders(bool allowLossy)
     bitmapRLE = indexedRLE = encoderZRLE;
     bitmap = indexed = encoderZRLE;
     break;
+#ifdef HAVE_ZSTD
+  case encodingZstdRLE:
+    fullColour = encoderZstdRLE;
+    bitmapRLE = indexedRLE = encoderZstdRLE;
+    bitmap = indexed = encoderZstdRLE;
+    break;
+#endif
   case encodingJPEG:
     fullColour = encoderJPEG;
     break;
+  case encodingH264:
+    if (encoders[encoderH264]->isSupported())
+      fullColour = encoderH264;
+    break;
   }
 
   // JPEG is the only encoder that can reduce things to grayscale
@@ -486,6 +795,10 @@ void EncodeManager::prepareEncoders(bool allowLossy)
       fullColour = encoderTightJPEG;
     else if (encoders[encoderZRLE]->isSupported())
       fullColour = encoderZRLE;
+#ifdef HAVE_ZSTD
+    else if (encoders[encoderZstdRLE]->isSupported())
+      fullColour = encoderZstdRLE;
+#endif
     else if (encoders[encoderTight]->isSupported())
       fullColour = encoderTight;
     else if (encoders[encoderHextile]->isSupported())
@@ -495,6 +808,10 @@ void EncodeManager::prepareEncoders(bool allowLossy)
   if (indexed == encoderRaw) {
     if (encoders[encoderZRLE]->isSupported())
       indexed = encoderZRLE;
+#ifdef HAVE_ZSTD
+    else if (encoders[encoderZstdRLE]->isSupported())
+      indexed = encoderZstdRLE;
+#endif
     else if (encoders[encoderTight]->isSupported())
       indexed = encoderTight;
     else if (encoders[encoderHextile]->isSupported())
@@ -516,6 +833,10 @@ void EncodeManager::prepareEncoders(bool allowLossy)
       solid = encoderRRE;
     else if (encoders[encoderZRLE]->isSupported())
       solid = encoderZRLE;
+#ifdef HAVE_ZSTD
+    else if (encoders[encoderZstdRLE]->isSupported())
+      solid = encoderZstdRLE;
+#endif
     else if (encoders[encoderHextile]->isSupported())
       solid = encoderHextile;
   }
@@ -527,25 +848,111 @@ void EncodeManager::prepareEncoders(bool allowLossy)
   activeEncoders[encoderIndexedRLE] = indexedRLE;
   activeEncoders[encoderFullColour] = fullColour;
 
-  for (iter = activeEncoders.begin(); iter != activeEncoders.end(); ++iter) {
-    Encoder *encoder;
+  for (iter = activeEncoders.begin(); iter != activeEncoders.end(); ++iter)
+    configureEncoder(encoders[*iter]);
+
+  // The cache follows the real framebuffer, so a copy of it is of no
+  // use to anyone else
+  if ((cache != nullptr) && updating)
+    cache->removeUser(this);
+  else if (cache != nullptr)
+    prepareCacheParams();
+}
 
-    encoder = encoders[*iter];
+void EncodeManager::prepareCacheParams()
+{
+  const PixelFormat& pf = conn->client.pf();
 
-    encoder->setCompressLevel(conn->client.compressLevel);
+  int klass;
 
-    if (allowLossy) {
-      encoder->setQualityLevel(conn->client.qualityLevel);
-      encoder->setFineQualityLevel(conn->client.fineQualityLevel,
-                                   conn->client.subsampling);
-    } else {
-      if (conn->client.qualityLevel < encoder->losslessQuality)
-        encoder->setQualityLevel(encoder->losslessQuality);
-      else
-        encoder->setQualityLevel(conn->client.qualityLevel);
-      encoder->setFineQualityLevel(-1, subsampleUndefined);
+  cacheParams.clear();
+
+  // Encoders that depend on earlier rects can't produce anything
+  // another client can use
+  for (klass = 0; klass < encoderTypeMax; klass++) {
+    if (encoders[activeEncoders[klass]]->flags & EncoderOrdered) {
+      cache->removeUser(this);
+      return;
     }
   }
+
+  // Adjusted settings follow this client's connection and change over
+  // time, so nobody else is likely to want what they produce. Such
+  // clients stay out of the cache until they are back at the settings
+  // they asked for.
+  if (qualityController.isAdjusted()) {
+    cache->removeUser(this);
+    return;
+  }
+
+  // The pixel values for the primary colours uniquely identify the
+  // layout of each pixel
+  cacheParams.push_back(pf.bpp);
+  cacheParams.push_back(pf.depth);
+  cacheParams.push_back(pf.isBigEndian());
+  cacheParams.push_back(pf.pixelFromRGB((uint16_t)0xffff, (uint16_t)0, (uint16_t)0));
+  cacheParams.push_back(pf.pixelFromRGB((uint16_t)0, (uint16_t)0xffff, (uint16_t)0));
+  cacheParams.push_back(pf.pixelFromRGB((uint16_t)0, (uint16_t)0, (uint16_t)0xffff));
+
+  cacheParams.push_back(lossyAllowed);
+  cacheParams.insert(cacheParams.end(),
+                     activeEncoders.begin(), activeEncoders.end());
+
+  cacheParams.push_back(qualityController.getCompressLevel());
+  cacheParams.push_back(qualityController.getQualityLevel());
+  cacheParams.push_back(qualityController.getFineQualityLevel());
+  cacheParams.push_back(qualityController.getSubsampling());
+
+  cache->setParams(this, cacheParams);
+}
+
+Encoder* EncodeManager::createEncoder(int klass)
+{
+  switch (klass) {
+  case encoderRaw:
+    return new RawEncoder(conn);
+  case encoderRRE:
+    return new RREEncoder(conn);
+  case encoderHextile:
+    return new HextileEncoder(conn);
+  case encoderTight:
+    return new TightEncoder(conn);
+  case encoderTightJPEG:
+    return new TightJPEGEncoder(conn);
+  case encoderZRLE:
+    return new ZRLEEncoder(conn);
+#ifdef HAVE_ZSTD
+  case encoderZstdRLE:
+    return new ZstdRLEEncoder(conn);
+#endif
+  case encoderJPEG:
+    return new JPEGEncoder(conn);
+  case encoderH264:
+    return new H264Encoder(conn);
+  }
+
+  throw std::logic_error("Unknown encoder class");
+}
+
+void EncodeManager::configureEncoder(Encoder* encoder)
+{
+  int qualityLevel;
+
+  encoder->setCompressLevel(qualityController.getCompressLevel());
+
+  qualityLevel = qualityController.getQualityLevel();
+
+  if (lossyAllowed) {
+    encoder->setQualityLevel(qualityLevel);
+    encoder->setFineQualityLevel(qualityController.getFineQualityLevel(),
+                                 qualityController.getSubsampling());
+  } else {
+    if (qualityLevel < encoder->losslessQuality)
+      encoder->setQualityLevel(encoder->losslessQuality);
+    else
+      encoder->setQualityLevel(qualityLevel);
+    encoder->setFineQualityLevel(-1, subsampleUndefined);
+  }
 }
 
 core::Region EncodeManager::getLosslessRefresh(const core::Region& req,
@@ -653,6 +1060,8 @@ Encoder* EncodeManager::startRect(const core::Rect& rect, int type)
   encoder = encoders[klass];
   conn->writer()->startRect(rect, encoder->encoding);
 
+  encoder->setPosition(rect.tl);
+
   if ((encoder->flags & EncoderLossy) &&
       ((encoder->losslessQuality == -1) ||
        (encoder->getQualityLevel() < encoder->losslessQuality)))
@@ -715,6 +1124,98 @@ void EncodeManager::writeCopyRects(const core::Region& copied,
   pendingRefreshRegion.assign_subtract(copied);
 }
 
+void EncodeManager::writeCachedTiles(core::Region* changed,
+                                     const PixelBuffer* pb,
+                                     TileList* newTiles)
+{
+  core::Rect bounds;
+  core::Region cached;
+  int bytesPerPixel;
+
+  // Anything the client has is in the format it had at the time, so
+  // start over with new hashes whenever something changes. The old
+  // tiles will be evicted eventually, in the same way on both sides.
+  if ((tileCacheGeneration == 0) || (pb->getPF() != tileCachePF) ||
+      (conn->client.pf() != tileCacheClientPF)) {
+    tileCacheGeneration++;
+    tileCachePF = pb->getPF();
+    tileCacheClientPF = conn->client.pf();
+  }
+
+  bytesPerPixel = pb->getPF().bpp/8;
+
+  beforeLength = conn->getOutStream()->length();
+
+  bounds = changed->get_bounding_rect();
+
+  for (int y = bounds.tl.y / CachedTileSize * CachedTileSize;
+       y < bounds.br.y; y += CachedTileSize) {
+    for (int x = bounds.tl.x / CachedTileSize * CachedTileSize;
+         x < bounds.br.x; x += CachedTileSize) {
+      core::Rect tile;
+      const uint8_t* data;
+      int stride;
+      uint64_t hash;
+
+      tile = core::Rect(x, y, x + CachedTileSize, y + CachedTileSize);
+      tile = tile.intersect(pb->getRect());
+
+      // Only tiles that are getting entirely replaced can be looked up
+      if (!isWithin(tile, *changed))
+        continue;
+
+      data = pb->getBuffer(tile, &stride);
+      hash = hashBlock(data, stride * bytesPerPixel,
+                       tile.width() * bytesPerPixel, tile.height());
+      // The client checks the size, so make sure it is always right
+      hash ^= ((uint64_t)tile.width() << 48) ^ ((uint64_t)tile.height() << 32);
+      hash ^= tileCacheGeneration * 0x9E3779B97F4A7C15ULL;
+
+      if (tileCache.lookup(hash) == nullptr) {
+        newTiles->push_back({tile, hash});
+        continue;
+      }
+
+      tileCacheStats.rects++;
+      tileCacheStats.pixels += tile.area();
+      tileCacheStats.equivalent += 12 + tile.area() * (conn->client.pf().bpp/8);
+
+      conn->writer()->writeCachedTile(tile, hash);
+
+      cached.assign_union(tile);
+    }
+  }
+
+  tileCacheStats.bytes += conn->getOutStream()->length() - beforeLength;
+
+  changed->assign_subtract(cached);
+
+  // Only lossless content is ever stored
+  lossyRegion.assign_subtract(cached);
+  pendingRefreshRegion.assign_subtract(cached);
+}
+
+void EncodeManager::writeStoreTiles(const TileList& newTiles)
+{
+  beforeLength = conn->getOutStream()->length();
+
+  for (const std::pair<core::Rect, uint64_t>& tile : newTiles) {
+    // A lossy tile would look different when drawn from the cache,
+    // and video is unlikely to be seen again and would just push out
+    // more useful tiles
+    if (!lossyRegion.intersect(tile.first).is_empty())
+      continue;
+    if (!videoRegion.intersect(tile.first).is_empty())
+      continue;
+
+    tileCache.insert(tile.second);
+
+    conn->writer()->writeStoreTile(tile.first, tile.second);
+  }
+
+  tileCacheStats.bytes += conn->getOutStream()->length() - beforeLength;
+}
+
 void EncodeManager::writeSolidRects(core::Region* changed,
                                     const PixelBuffer* pb)
 {
@@ -832,10 +1333,25 @@ void EncodeManager::findSolidRect(const core::Rect& rect,
 }
 
 void EncodeManager::writeRects(const core::Region& changed,
-                               const PixelBuffer* pb)
+                               const PixelBuffer* pb, bool cacheable)
 {
-  std::vector<core::Rect> rects;
+  std::vector<core::Rect> rects, subRects;
   std::vector<core::Rect>::const_iterator rect;
+  Encoder* encoder;
+  bool sliceVideo, shared;
+  size_t threads;
+
+  // Video goes straight to the lossy encoder, so it can be split in
+  // whatever way suits that encoder best. Encoders that keep state
+  // between rects want the same rects every time though. Without
+  // LastRect the number of rects has already been sent, based on the
+  // normal split, so we have to stick to that.
+  encoder = encoders[activeEncoders[encoderFullColour]];
+  sliceVideo = conn->client.supportsEncoding(pseudoEncodingLastRect) &&
+               lossyAllowed && (encoder->flags & EncoderLossy) &&
+               !(encoder->flags & EncoderOrdered) &&
+               !videoRegion.is_empty();
+  threads = encodeThreadCount();
 
   changed.get_rects(&rects);
   for (rect = rects.begin(); rect != rects.end(); ++rect) {
@@ -845,9 +1361,15 @@ void EncodeManager::writeRects(const core::Region& changed,
     w = rect->width();
     h = rect->height();
 
+    if (sliceVideo && ((w*h) >= SubRectMaxArea) &&
+        isWithin(*rect, videoRegion)) {
+      splitLossyRect(*rect, threads, &subRects);
+      continue;
+    }
+
     // No split necessary?
     if (((w*h) < SubRectMaxArea) && (w < SubRectMaxWidth)) {
-      writeSubRect(*rect, pb);
+      subRects.push_back(*rect);
       continue;
     }
 
@@ -868,10 +1390,207 @@ void EncodeManager::writeRects(const core::Region& changed,
         if (sr.br.x > rect->br.x)
           sr.br.x = rect->br.x;
 
-        writeSubRect(sr, pb);
+        subRects.push_back(sr);
       }
     }
   }
+
+  // Other clients might want the same rects, so make sure they end
+  // up in the cache
+  shared = cacheable && (cache != nullptr) && !updating &&
+           cache->isShared(cacheParams);
+
+  if (startThreadedRects(subRects, shared)) {
+    writeThreadedRects(subRects, pb, shared);
+    return;
+  }
+
+  for (rect = subRects.begin(); rect != subRects.end(); ++rect)
+    writeSubRect(*rect, pb);
+}
+
+size_t EncodeManager::encodeThreadCount()
+{
+  size_t threads;
+
+  if (Server::encodeThreads <= 1)
+    return 1;
+  if (pool->size() == 0)
+    return 1;
+
+  // The thread calling wait() also runs jobs
+  threads = pool->size() + 1;
+  if (threads > (size_t)Server::encodeThreads)
+    threads = Server::encodeThreads;
+
+  return threads;
+}
+
+bool EncodeManager::startThreadedRects(const std::vector<core::Rect>& rects,
+                                       bool shared)
+{
+  std::vector<core::Rect>::const_iterator rect;
+  size_t count, maxJobs;
+  int klass;
+  bool threaded;
+
+  // Encoders that must see every rect in order can't be split up
+  for (klass = 0; klass < encoderTypeMax; klass++) {
+    if (encoders[activeEncoders[klass]]->flags & EncoderOrdered)
+      return false;
+  }
+
+  threaded = encodeThreadCount() > 1;
+
+  // Is there enough work to make it worth it?
+  if (threaded) {
+    count = 0;
+    for (rect = rects.begin(); rect != rects.end(); ++rect) {
+      if (rect->area() >= ThreadedMinArea)
+        count++;
+    }
+    if (count < 2)
+      threaded = false;
+  }
+
+  // Shared rects still need to go through a job, as that is what
+  // makes them independent of this connection
+  if (threaded) {
+    maxJobs = encodeThreadCount();
+  } else if (shared) {
+    maxJobs = 1;
+  } else {
+    return false;
+  }
+
+  while (jobs.size() < maxJobs)
+    jobs.push_back(new EncodeJob(this));
+
+  return true;
+}
+
+void EncodeManager::writeThreadedRects(const std::vector<core::Rect>& rects,
+                                       const PixelBuffer* pb, bool shared)
+{
+  std::vector<EncodeJob*> assigned;
+  std::vector<EncodeJob*> freeJobs;
+  size_t i, next;
+
+  EncodeCache::Data cached;
+
+  assigned.resize(rects.size(), nullptr);
+  freeJobs = jobs;
+
+  next = 0;
+
+  try {
+    for (i = 0; i < rects.size(); i++) {
+      // Keep the workers busy with rects further ahead
+      while (!freeJobs.empty() && (next < rects.size())) {
+        EncodeJob* job;
+
+        if (shared) {
+          if (cache->contains(rects[next], cacheParams)) {
+            next++;
+            continue;
+          }
+        } else if (rects[next].area() < ThreadedMinArea) {
+          next++;
+          continue;
+        }
+
+        job = freeJobs.back();
+        freeJobs.pop_back();
+
+        job->rect = rects[next];
+        job->pb = pb;
+
+        pool->submit(job);
+
+        assigned[next] = job;
+        next++;
+      }
+
+      if (assigned[i] == nullptr) {
+        // Might have been pushed out of the cache since we checked
+        if (!shared || !writeCachedRect(rects[i]))
+          writeSubRect(rects[i], pb);
+        continue;
+      }
+
+      pool->wait(assigned[i]);
+
+      cached = nullptr;
+      if (shared)
+        cached = cache->insert(assigned[i]->rect, cacheParams,
+                               assigned[i]->type,
+                               assigned[i]->output.data(),
+                               assigned[i]->output.length());
+
+      // The cached copy can be sent without copying it again
+      if (cached)
+        writeEncodedRect(assigned[i]->rect, assigned[i]->type, cached);
+      else
+        writeEncodedRect(assigned[i]->rect, assigned[i]->type,
+                         assigned[i]->output.data(),
+                         assigned[i]->output.length());
+
+      freeJobs.push_back(assigned[i]);
+      assigned[i] = nullptr;
+    }
+  } catch (...) {
+    // The jobs reference the framebuffer and our encoders, so we
+    // can't leave them running
+    for (i = 0; i < rects.size(); i++) {
+      if (assigned[i] == nullptr)
+        continue;
+      try {
+        pool->wait(assigned[i]);
+      } catch (...) {
+      }
+    }
+    throw;
+  }
+}
+
+bool EncodeManager::writeCachedRect(const core::Rect& rect)
+{
+  EncodeCache::Data data;
+  int type;
+
+  data = cache->lookupShared(rect, cacheParams, &type);
+  if (!data)
+    return false;
+
+  writeEncodedRect(rect, type, data);
+
+  return true;
+}
+
+void EncodeManager::writeEncodedRect(const core::Rect& rect, int type,
+                                     const uint8_t* data, size_t length)
+{
+  Encoder *encoder;
+
+  encoder = startRect(rect, type);
+  conn->getOutStream()->writeBytesDirect(data, length);
+  endRect();
+
+  // The client's state now follows the data we just sent rather than
+  // our encoder
+  encoder->resetState();
+}
+
+void EncodeManager::writeEncodedRect(const core::Rect& rect, int type,
+                                     const EncodeCache::Data& data)
+{
+  Encoder *encoder;
+
+  encoder = startRect(rect, type);
+  conn->getOutStream()->writeBuffer(data);
+  endRect();
+
+  encoder->resetState();
 }
 
 void EncodeManager::writeSubRect(const core::Rect& rect,
@@ -882,29 +1601,70 @@ void EncodeManager::writeSubRect(const core::Rect& rect,
   Encoder *encoder;
 
   struct RectInfo info;
+  int type;
+
+  ppb = preparePixelBuffer(rect, pb, true,
+                           &offsetPixelBuffer, &convertedPixelBuffer);
+
+  type = analyseSubRect(rect, ppb, &info);
+
+  encoder = startRect(rect, type);
+
+  if (encoder->flags & EncoderUseNativePF)
+    ppb = preparePixelBuffer(rect, pb, false,
+                             &offsetPixelBuffer, &convertedPixelBuffer);
+
+  encoder->writeRect(ppb, info.palette);
+
+  endRect();
+}
+
+int EncodeManager::analyseSubRect(const core::Rect& rect,
+                                  const PixelBuffer* ppb,
+                                  struct RectInfo* info)
+{
+  Encoder *encoder;
+
+  int compressLevel;
   unsigned int divisor, maxColours;
 
   bool useRLE;
   EncoderType type;
 
+  // Video will end up with the lossy encoder anyway, so don't waste
+  // time looking for a palette
+  encoder = encoders[activeEncoders[encoderFullColour]];
+  if (lossyAllowed && (encoder->flags & EncoderLossy) &&
+      isWithin(rect, videoRegion)) {
+    info->rleRuns = 0;
+    info->palette.clear();
+    return encoderFullColour;
+  }
+
   // FIXME: This is roughly the algorithm previously used by the Tight
   //        encoder. It seems a bit backwards though, that higher
   //        compression setting means spending less effort in building
   //        a palette. It might be that they figured the increase in
   //        zlib setting compensated for the loss.
-  if (conn->client.compressLevel == -1)
+  compressLevel = qualityController.getCompressLevel();
+  if (compressLevel == -1)
     divisor = 2 * 8;
   else
-    divisor = conn->client.compressLevel * 8;
+    divisor = compressLevel * 8;
   if (divisor < 4)
     divisor = 4;
 
   maxColours = rect.area()/divisor;
 
-  // Special exception inherited from the Tight encoder
+  // Special exception inherited from the Tight encoder. Areas that
+  // are static or scrolling are probably text or UI elements though,
+  // so try harder to keep those lossless.
   if ((activeEncoders[encoderFullColour] == encoderTightJPEG) ||
-      (activeEncoders[encoderFullColour] == encoderJPEG)) {
-    if ((conn->client.compressLevel != -1) && (conn->client.compressLevel < 2))
+      (activeEncoders[encoderFullColour] == encoderJPEG) ||
+      (activeEncoders[encoderFullColour] == encoderH264)) {
+    if (isWithin(rect, textRegion))
+      maxColours = UINT_MAX;
+    else if ((compressLevel != -1) && (compressLevel < 2))
       maxColours = 24;
     else
       maxColours = 96;
@@ -920,17 +1680,15 @@ void EncodeManager::writeSubRect(const core::Rect& rect,
   if (maxColours > encoder->maxPaletteSize)
     maxColours = encoder->maxPaletteSize;
 
-  ppb = preparePixelBuffer(rect, pb, true);
-
-  if (!analyseRect(ppb, &info, maxColours))
-    info.palette.clear();
+  if (!analyseRect(ppb, info, maxColours))
+    info->palette.clear();
 
   // Different encoders might have different RLE overhead, but
   // here we do a guess at RLE being the better choice if reduces
   // the pixel count by 50%.
-  useRLE = info.rleRuns <= (rect.area() * 2);
+  useRLE = info->rleRuns <= (rect.area() * 2);
 
-  switch (info.palette.size()) {
+  switch (info->palette.size()) {
   case 0:
     type = encoderFullColour;
     break;
@@ -950,14 +1708,7 @@ void EncodeManager::writeSubRect(const core::Rect& rect,
       type = encoderIndexed;
   }
 
-  encoder = startRect(rect, type);
-
-  if (encoder->flags & EncoderUseNativePF)
-    ppb = preparePixelBuffer(rect, pb, false);
-
-  encoder->writeRect(ppb, info.palette);
-
-  endRect();
+  return type;
 }
 
 bool EncodeManager::checkSolidTile(const core::Rect& r,
@@ -1086,22 +1837,23 @@ void EncodeManager::extendSolidAreaByPixel(const core::Rect& r,
 
 PixelBuffer* EncodeManager::preparePixelBuffer(const core::Rect& rect,
                                                const PixelBuffer *pb,
-                                               bool convert)
+                                               bool convert,
+                                               OffsetPixelBuffer* offsetPb,
+                                               ManagedPixelBuffer* convertedPb)
 {
   const uint8_t* buffer;
   int stride;
 
   // Do wo need to convert the data?
   if (convert && conn->client.pf() != pb->getPF()) {
-    convertedPixelBuffer.setPF(conn->client.pf());
-    convertedPixelBuffer.setSize(rect.width(), rect.height());
+    convertedPb->setPF(conn->client.pf());
+    convertedPb->setSize(rect.width(), rect.height());
 
     buffer = pb->getBuffer(rect, &stride);
-    convertedPixelBuffer.imageRect(pb->getPF(),
-                                   convertedPixelBuffer.getRect(),
-                                   buffer, stride);
+    convertedPb->imageRect(pb->getPF(), convertedPb->getRect(),
+                           buffer, stride);
 
-    return &convertedPixelBuffer;
+    return convertedPb;
   }
 
   // Otherwise we still need to shift the coordinates. We have our own
@@ -1109,10 +1861,10 @@ PixelBuffer* EncodeManager::preparePixelBuffer(const core::Rect& rect,
 
   buffer = pb->getBuffer(rect, &stride);
 
-  offsetPixelBuffer.update(pb->getPF(), rect.width(), rect.height(),
-                           buffer, stride);
+  offsetPb->update(pb->getPF(), rect.width(), rect.height(),
+                   buffer, stride);
 
-  return &offsetPixelBuffer;
+  return offsetPb;
 }
 
 bool EncodeManager::analyseRect(const PixelBuffer *pb,
@@ -1154,23 +1906,86 @@ uint8_t* EncodeManager::OffsetPixelBuffer::getBufferRW(const core::Rect& /*r*/,
   throw std::logic_error("Invalid write attempt to OffsetPixelBuffer");
 }
 
+EncodeManager::EncodeJob::EncodeJob(EncodeManager* manager_)
+  : pb(nullptr), type(encoderFullColour), manager(manager_)
+{
+  encoders.resize(encoderClassMax, nullptr);
+}
+
+EncodeManager::EncodeJob::~EncodeJob()
+{
+  for (Encoder* encoder : encoders)
+    delete encoder;
+}
+
+void EncodeManager::EncodeJob::run()
+{
+  PixelBuffer *ppb;
+
+  Encoder *encoder;
+  int klass;
+
+  struct RectInfo info;
+
+  ppb = manager->preparePixelBuffer(rect, pb, true,
+                                    &offsetPixelBuffer,
+                                    &convertedPixelBuffer);
+
+  type = manager->analyseSubRect(rect, ppb, &info);
+
+  // Encoders are created as needed as most clients will only ever
+  // use a few of them
+  klass = manager->activeEncoders[type];
+  if (encoders[klass] == nullptr) {
+    encoders[klass] = manager->createEncoder(klass);
+    encoders[klass]->setOutStream(&output);
+  }
+
+  encoder = encoders[klass];
+
+  manager->configureEncoder(encoder);
+  encoder->setPosition(rect.tl);
+
+  if (encoder->flags & EncoderUseNativePF)
+    ppb = manager->preparePixelBuffer(rect, pb, false,
+                                      &offsetPixelBuffer,
+                                      &convertedPixelBuffer);
+
+  // The rect must not depend on anything sent before it, as the
+  // client might have seen rects from other encoders in between
+  encoder->resetState();
+
+  output.clear();
+  encoder->writeRect(ppb, info.palette);
+}
+
+EncodeManager::UpdateJob::UpdateJob(EncodeManager* manager_)
+  : cb(nullptr), manager(manager_)
+{
+}
+
+void EncodeManager::UpdateJob::run()
+{
+  manager->doUpdate(true, changed, copied, copyDelta,
+                    &manager->snapshot, nullptr);
+}
+
+void EncodeManager::UpdateJob::finished()
+{
+  // Not done from run(), as the update has to be marked as finished
+  // before anyone gets told about it
+  cb->updateFinished(manager);
+}
+
 template<class T>
 inline bool EncodeManager::checkSolidTile(int width, int height,
                                           const T* buffer, int stride,
                                           const T colourValue)
 {
-  int pad;
-
-  pad = stride - width;
-
   while (height--) {
-    int width_ = width;
-    while (width_--) {
-      if (*buffer != colourValue)
-        return false;
-      buffer++;
-    }
-    buffer += pad;
+    if (countPixels(buffer, width, colourValue) != width)
+      return false;
+    buffer += stride;
   }
 
   return true;
@@ -1181,38 +1996,45 @@ inline bool EncodeManager::analyseRect(int width, int height,
                                        const T* buffer, int stride,
                                        struct RectInfo *info, int maxColours)
 {
-  int pad;
-
   T colour;
   int count;
 
   info->rleRuns = 0;
   info->palette.clear();
 
-  pad = stride - width;
-
   // For efficiency, we only update the palette on changes in colour
   colour = buffer[0];
   count = 0;
   while (height--) {
-    int w_ = width;
-    while (w_--) {
-      if (*buffer != colour) {
-        if (!info->palette.insert(colour, count))
-          return false;
-        if (info->palette.size() > maxColours)
-          return false;
-
-        // FIXME: This doesn't account for switching lines
-        info->rleRuns++;
-
-        colour = *buffer;
-        count = 0;
+    int x;
+
+    x = 0;
+    while (x < width) {
+      // Photos rarely have runs longer than a pixel, so avoid the
+      // overhead of a scan unless the run continues
+      if (buffer[x] == colour) {
+        int run;
+
+        run = countPixels(buffer + x, width - x, colour);
+        count += run;
+        x += run;
+        if (x == width)
+          break;
       }
-      buffer++;
-      count++;
+
+      if (!info->palette.insert(colour, count))
+        return false;
+      if (info->palette.size() > maxColours)
+        return false;
+
+      // FIXME: This doesn't account for switching lines
+      info->rleRuns++;
+
+      colour = buffer[x];
+      count = 1;
+      x++;
     }
-    buffer += pad;
+    buffer += stride;
   }
 
   // Make sure the final pixels also get counted
@@ -25,9 +25,16 @@
 #include <stdint.h>
 
 #include <core/Region.h>
+#include <core/ThreadPool.h>
 #include <core/Timer.h>
 
+#include <rdr/MemOutStream.h>
+
+#include <rfb/EncodeCache.h>
 #include <rfb/PixelBuffer.h>
+#include <rfb/QualityController.h>
+#include <rfb/RegionClassifier.h>
+#include <rfb/TileCache.h>
 
 namespace rfb {
 
@@ -41,7 +48,19 @@ namespace rfb {
 
   class EncodeManager : public core::Timer::Callback {
   public:
-    EncodeManager(SConnection* conn);
+    struct UpdateCallback {
+      // updateFinished
+      //   Called from the background thread once an update started
+      //   with startUpdate() is done, successfully or not. The update
+      //   is already marked as done, but the pool is still locked, so
+      //   this must not call back in to the EncodeManager.
+      virtual void updateFinished(EncodeManager* manager) = 0;
+    };
+
+    // All encoding is done using the given pool, or the shared one if
+    // none is given
+    EncodeManager(SConnection* conn, EncodeCache* cache=nullptr,
+                  core::ThreadPool* pool=nullptr);
     ~EncodeManager();
 
     void logStats();
@@ -56,6 +75,11 @@ namespace rfb {
 
     void forceRefresh(const core::Region& req);
 
+    // setNetworkEstimate() tells us the current bandwidth, in bytes
+    // per second, and round trip time, in milliseconds (-1 if
+    // unknown), so that the compression can be adjusted to match
+    void setNetworkEstimate(size_t bandwidth, int rtt);
+
     void writeUpdate(const UpdateInfo& ui, const PixelBuffer* pb,
                      const RenderedCursor* renderedCursor);
 
@@ -64,6 +88,24 @@ namespace rfb {
                               const RenderedCursor* renderedCursor,
                               size_t maxUpdateSize);
 
+    // startUpdate() does the same as writeUpdate(), but on a
+    // background thread. The needed parts of the framebuffer and the
+    // cursor are copied first, so they may change as soon as this
+    // returns. Nothing else may be done with this object or the
+    // connection until finishUpdate() has been called.
+    void startUpdate(const UpdateInfo& ui, const PixelBuffer* pb,
+                     const RenderedCursor* renderedCursor,
+                     UpdateCallback* cb);
+    // finishUpdate() waits for the background update and rethrows any
+    // error it encountered
+    void finishUpdate();
+
+    // isUpdating() returns true from startUpdate() until
+    // finishUpdate(), and isUpdateDone() if finishUpdate() won't have
+    // to wait
+    bool isUpdating() const { return updating; }
+    bool isUpdateDone();
+
   protected:
     void handleTimeout(core::Timer* t) override;
 
@@ -73,6 +115,10 @@ namespace rfb {
                   const PixelBuffer* pb,
                   const RenderedCursor* renderedCursor);
     void prepareEncoders(bool allowLossy);
+    void prepareCacheParams();
+
+    Encoder* createEncoder(int klass);
+    void configureEncoder(Encoder* encoder);
 
     core::Region getLosslessRefresh(const core::Region& req,
                                     size_t maxUpdateSize);
@@ -85,11 +131,19 @@ namespace rfb {
     void writeCopyRects(const core::Region& copied,
                         const core::Point& delta);
     void writeSolidRects(core::Region* changed, const PixelBuffer* pb);
+
+    typedef std::vector<std::pair<core::Rect, uint64_t>> TileList;
+    void writeCachedTiles(core::Region* changed, const PixelBuffer* pb,
+                          TileList* newTiles);
+    void writeStoreTiles(const TileList& newTiles);
     void findSolidRect(const core::Rect& rect, core::Region* changed,
                        const PixelBuffer* pb);
-    void writeRects(const core::Region& changed, const PixelBuffer* pb);
+    void writeRects(const core::Region& changed, const PixelBuffer* pb,
+                    bool cacheable);
 
     void writeSubRect(const core::Rect& rect, const PixelBuffer* pb);
+    int analyseSubRect(const core::Rect& rect, const PixelBuffer* ppb,
+                       struct RectInfo* info);
 
     bool checkSolidTile(const core::Rect& r, const uint8_t* colourValue,
                         const PixelBuffer *pb);
@@ -101,8 +155,25 @@ namespace rfb {
                                 const uint8_t* colourValue,
                                 const PixelBuffer* pb, core::Rect* er);
 
+    class OffsetPixelBuffer;
+    class EncodeJob;
+    class UpdateJob;
+
+    size_t encodeThreadCount();
+    bool startThreadedRects(const std::vector<core::Rect>& rects,
+                            bool shared);
+    void writeThreadedRects(const std::vector<core::Rect>& rects,
+                            const PixelBuffer* pb, bool shared);
+    bool writeCachedRect(const core::Rect& rect);
+    void writeEncodedRect(const core::Rect& rect, int type,
+                          const uint8_t* data, size_t length);
+    void writeEncodedRect(const core::Rect& rect, int type,
+                          const EncodeCache::Data& data);
+
     PixelBuffer* preparePixelBuffer(const core::Rect& rect,
-                                    const PixelBuffer* pb, bool convert);
+                                    const PixelBuffer* pb, bool convert,
+                                    OffsetPixelBuffer* offsetPb,
+                                    ManagedPixelBuffer* convertedPb);
 
     bool analyseRect(const PixelBuffer *pb,
                      struct RectInfo *info, int maxColours);
@@ -123,6 +194,12 @@ namespace rfb {
 
     std::vector<Encoder*> encoders;
     std::vector<int> activeEncoders;
+    bool lossyAllowed;
+
+    EncodeCache* cache;
+    EncodeCache::Params cacheParams;
+
+    core::ThreadPool* pool;
 
     core::Region lossyRegion;
     core::Region recentlyChangedRegion;
@@ -130,6 +207,17 @@ namespace rfb {
 
     core::Timer recentChangeTimer;
 
+    RegionClassifier classifier;
+    core::Region videoRegion;
+    core::Region textRegion;
+
+    QualityController qualityController;
+
+    // What the client has in its tile cache
+    TileCache tileCache;
+    PixelFormat tileCachePF, tileCacheClientPF;
+    uint64_t tileCacheGeneration;
+
     struct EncoderStats {
       unsigned rects;
       unsigned long long bytes;
@@ -140,6 +228,7 @@ namespace rfb {
 
     unsigned updates;
     EncoderStats copyStats;
+    EncoderStats tileCacheStats;
     StatsVector stats;
     int activeType;
     int beforeLength;
@@ -158,6 +247,58 @@ namespace rfb {
 
     OffsetPixelBuffer offsetPixelBuffer;
     ManagedPixelBuffer convertedPixelBuffer;
+
+    // A sub-rect being encoded on a worker thread. Every job has its
+    // own set of encoders so that they don't share any state, and
+    // writes to its own buffer that is then copied to the client in
+    // the correct order. The result does not depend on anything sent
+    // earlier, which also makes it possible to share it with other
+    // clients.
+    class EncodeJob : public core::ThreadPool::Job {
+    public:
+      EncodeJob(EncodeManager* manager);
+      virtual ~EncodeJob();
+
+      void run() override;
+
+      core::Rect rect;
+      const PixelBuffer* pb;
+
+      int type;
+      rdr::MemOutStream output;
+
+    private:
+      EncodeManager* manager;
+
+      std::vector<Encoder*> encoders;
+
+      OffsetPixelBuffer offsetPixelBuffer;
+      ManagedPixelBuffer convertedPixelBuffer;
+    };
+
+    std::vector<EncodeJob*> jobs;
+
+    // An update being written from a copy of the framebuffer
+    class UpdateJob : public core::ThreadPool::Job {
+    public:
+      UpdateJob(EncodeManager* manager);
+
+      void run() override;
+      void finished() override;
+
+      core::Region changed;
+      core::Region copied;
+      core::Point copyDelta;
+
+      UpdateCallback* cb;
+
+    private:
+      EncodeManager* manager;
+    };
+
+    UpdateJob* updateJob;
+    bool updating;
+    ManagedPixelBuffer snapshot;
   };
 
 }
@@ -24,6 +24,7 @@
 #include <rfb/Encoder.h>
 #include <rfb/PixelBuffer.h>
 #include <rfb/Palette.h>
+#include <rfb/SConnection.h>
 
 using namespace rfb;
 
@@ -32,7 +33,7 @@ Encoder::Encoder(SConnection *conn_, int encoding_,
                  unsigned int maxPaletteSize_, int losslessQuality_) :
   encoding(encoding_), flags(flags_),
   maxPaletteSize(maxPaletteSize_), losslessQuality(losslessQuality_),
-  conn(conn_)
+  conn(conn_), outStream(nullptr)
 {
 }
 
@@ -85,3 +86,10 @@ void Encoder::writeSolidRect(const PixelBuffer* pb, const Palette& palette)
 
   writeSolidRect(pb->width(), pb->height(), pb->getPF(), buffer);
 }
+
+rdr::OutStream* Encoder::getOutStream()
+{
+  if (outStream != nullptr)
+    return outStream;
+  return conn->getOutStream();
+}
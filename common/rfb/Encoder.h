@@ -22,6 +22,14 @@
 
 #include <stdint.h>
 
+namespace core {
+  struct Point;
+}
+
+namespace rdr {
+  class OutStream;
+}
+
 namespace rfb {
   class SConnection;
   class PixelBuffer;
@@ -36,6 +44,9 @@ namespace rfb {
     EncoderUseNativePF = 1 << 0,
     // Encoder does not encode pixels perfectly accurate
     EncoderLossy = 1 << 1,
+    // Encoder keeps state between rects that cannot be reset, so all
+    // rects must be encoded in order by the same instance
+    EncoderOrdered = 1 << 2,
   };
 
   class Encoder {
@@ -58,6 +69,22 @@ namespace rfb {
     virtual int getCompressLevel() { return -1; };
     virtual int getQualityLevel() { return -1; };
 
+    // setOutStream() redirects the output of the encoder to a different
+    // stream than the one of the SConnection, e.g. a memory buffer when
+    // encoding on a separate thread. Set to nullptr to restore.
+    void setOutStream(rdr::OutStream* os) { outStream = os; }
+
+    // setPosition() tells the encoder where on the screen the next rect
+    // is, as the PixelBuffer given to writeRect() always starts at 0,0.
+    // Only encoders that keep state for specific areas care about this.
+    virtual void setPosition(const core::Point& /*pos*/) {};
+
+    // resetState() makes the encoder forget any state built up from
+    // previous rects, and makes sure the client is told to do the same
+    // in the next rect. This allows rects to be encoded independently
+    // by multiple instances.
+    virtual void resetState() {};
+
     // writeRect() is the main interface that encodes the given rectangle
     // with data from the PixelBuffer onto the SConnection given at
     // encoder creation.
@@ -89,6 +116,9 @@ namespace rfb {
     // short cut method.
     void writeSolidRect(const PixelBuffer* pb, const Palette& palette);
 
+    // Stream that all rect data should be written to
+    rdr::OutStream* getOutStream();
+
   public:
     const int encoding;
     const enum EncoderFlags flags;
@@ -102,6 +132,9 @@ namespace rfb {
 
   protected:
     SConnection* conn;
+
+  private:
+    rdr::OutStream* outStream;
   };
 }
 
@@ -0,0 +1,206 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdexcept>
+
+#include <core/i18n.h>
+
+#include <rdr/OutStream.h>
+
+#include <rfb/encodings.h>
+#include <rfb/SConnection.h>
+#include <rfb/ServerCore.h>
+#include <rfb/PixelBuffer.h>
+#include <rfb/H264Encoder.h>
+
+using namespace rfb;
+
+// The viewer throws away its oldest stream when it has this many, so
+// we must do the same to stay in sync
+static const size_t MaxContexts = 64;
+
+enum rectFlags {
+  resetContext       = 0x1,
+  resetAllContexts   = 0x2,
+};
+
+H264Encoder::H264Encoder(SConnection* conn_) :
+  Encoder(conn_, encodingH264,
+          (EncoderFlags)(EncoderUseNativePF | EncoderLossy |
+                         EncoderOrdered)),
+  compressLevel(-1), qualityLevel(-1), fineQuality(-1),
+  contextSettings(), pendingReset(false)
+{
+}
+
+H264Encoder::~H264Encoder()
+{
+  resetContexts();
+}
+
+bool H264Encoder::isSupported()
+{
+  if (!conn->client.supportsEncoding(encodingH264))
+    return false;
+
+  return H264EncoderContext::isAvailable();
+}
+
+void H264Encoder::setCompressLevel(int level)
+{
+  compressLevel = level;
+}
+
+void H264Encoder::setQualityLevel(int level)
+{
+  qualityLevel = level;
+}
+
+void H264Encoder::setFineQualityLevel(int quality, int /*subsampling*/)
+{
+  fineQuality = quality;
+}
+
+int H264Encoder::getCompressLevel()
+{
+  return compressLevel;
+}
+
+int H264Encoder::getQualityLevel()
+{
+  return qualityLevel;
+}
+
+void H264Encoder::setPosition(const core::Point& pos)
+{
+  position = pos;
+}
+
+void H264Encoder::resetState()
+{
+  resetContexts();
+  pendingReset = true;
+}
+
+void H264Encoder::writeRect(const PixelBuffer* pb,
+                            const Palette& /*palette*/)
+{
+  H264EncoderContext::Settings settings;
+  H264EncoderContext* ctx;
+  core::Rect rect;
+  uint32_t resetFlags;
+
+  rdr::OutStream* os;
+
+  // The existing streams can't be reconfigured, so start over
+  settings = getSettings();
+  if (settings != contextSettings) {
+    if (!contexts.empty())
+      resetState();
+    contextSettings = settings;
+  }
+
+  rect = pb->getRect().translate(position);
+
+  resetFlags = 0;
+  if (pendingReset) {
+    resetFlags |= resetAllContexts;
+    pendingReset = false;
+  }
+
+  ctx = findContext(rect);
+  if (ctx == nullptr) {
+    if (contexts.size() >= MaxContexts) {
+      delete contexts.front();
+      contexts.pop_front();
+    }
+    ctx = createContext(rect, contextSettings);
+    if (ctx == nullptr)
+      throw std::runtime_error(_("Failed to create H.264 context"));
+    contexts.push_back(ctx);
+  }
+
+  buffer.clear();
+  ctx->encode(pb, &buffer);
+
+  os = getOutStream();
+
+  os->writeU32(buffer.length());
+  os->writeU32(resetFlags);
+  os->writeBytesDirect(buffer.data(), buffer.length());
+}
+
+void H264Encoder::writeSolidRect(int width, int height,
+                                 const PixelFormat& pf,
+                                 const uint8_t* colour)
+{
+  // Solid areas are normally sent with other encodings, so this is
+  // rare enough to not need a short cut
+  Encoder::writeSolidRect(width, height, pf, colour);
+}
+
+H264EncoderContext* H264Encoder::createContext(
+  const core::Rect& r, const H264EncoderContext::Settings& settings)
+{
+  return H264EncoderContext::createContext(r, settings);
+}
+
+H264EncoderContext::Settings H264Encoder::getSettings()
+{
+  H264EncoderContext::Settings settings;
+
+  settings.bitrate = Server::h264Bitrate;
+
+  if (fineQuality != -1)
+    settings.quality = fineQuality;
+  else if (qualityLevel != -1)
+    settings.quality = qualityLevel * 10 + 10;
+  else
+    settings.quality = 90;
+
+  if (compressLevel != -1)
+    settings.effort = compressLevel;
+  else
+    settings.effort = 2;
+
+  // The codec needs a time base, even if updates aren't limited
+  settings.frameRate = Server::frameRate;
+  if (settings.frameRate < 1)
+    settings.frameRate = 1;
+
+  return settings;
+}
+
+void H264Encoder::resetContexts()
+{
+  for (H264EncoderContext* context : contexts)
+    delete context;
+  contexts.clear();
+}
+
+H264EncoderContext* H264Encoder::findContext(const core::Rect& r)
+{
+  for (H264EncoderContext* context : contexts)
+    if (context->isEqualRect(r))
+      return context;
+  return nullptr;
+}
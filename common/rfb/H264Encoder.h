@@ -0,0 +1,82 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+#ifndef __RFB_H264ENCODER_H__
+#define __RFB_H264ENCODER_H__
+
+#include <list>
+
+#include <core/Rect.h>
+
+#include <rdr/MemOutStream.h>
+
+#include <rfb/Encoder.h>
+#include <rfb/H264EncoderContext.h>
+
+namespace rfb {
+
+  // Each rect gets its own H.264 stream, identified by its position
+  // and size, just like the viewer does it. That works well for things
+  // like video players that keep updating the same area.
+
+  class H264Encoder : public Encoder {
+  public:
+    H264Encoder(SConnection* conn);
+    virtual ~H264Encoder();
+
+    bool isSupported() override;
+
+    void setCompressLevel(int level) override;
+    void setQualityLevel(int level) override;
+    void setFineQualityLevel(int quality, int subsampling) override;
+
+    int getCompressLevel() override;
+    int getQualityLevel() override;
+
+    void setPosition(const core::Point& pos) override;
+
+    void resetState() override;
+
+    void writeRect(const PixelBuffer* pb,
+                   const Palette& palette) override;
+    void writeSolidRect(int width, int height, const PixelFormat& pf,
+                        const uint8_t* colour) override;
+
+  protected:
+    // createContext() sets up a new H.264 stream for the given rect
+    virtual H264EncoderContext* createContext(
+      const core::Rect& r, const H264EncoderContext::Settings& settings);
+
+    H264EncoderContext::Settings getSettings();
+
+    void resetContexts();
+    H264EncoderContext* findContext(const core::Rect& r);
+
+    int compressLevel;
+    int qualityLevel;
+    int fineQuality;
+
+    core::Point position;
+
+    std::list<H264EncoderContext*> contexts;
+    H264EncoderContext::Settings contextSettings;
+    bool pendingReset;
+
+    rdr::MemOutStream buffer;
+  };
+}
+#endif
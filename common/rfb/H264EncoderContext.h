@@ -0,0 +1,80 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifndef __RFB_H264ENCODERCONTEXT_H__
+#define __RFB_H264ENCODERCONTEXT_H__
+
+#include <core/Rect.h>
+
+namespace rdr { class OutStream; }
+
+namespace rfb {
+
+  class PixelBuffer;
+
+  class H264EncoderContext {
+    public:
+      struct Settings {
+        // Target bitrate in kbit/s, or 0 for constant quality
+        int bitrate;
+        // Quality on a 0-100 scale, like JPEG
+        int quality;
+        // 0-9, where higher values spend more CPU to save bandwidth
+        int effort;
+        // Expected number of frames per second
+        int frameRate;
+
+        bool operator==(const Settings& other) const {
+          return (bitrate == other.bitrate) &&
+                 (quality == other.quality) &&
+                 (effort == other.effort) &&
+                 (frameRate == other.frameRate);
+        }
+        bool operator!=(const Settings& other) const {
+          return !(*this == other);
+        }
+      };
+
+      // isAvailable() returns true if there is an encoder that can be
+      // used on this system
+      static bool isAvailable();
+
+      static H264EncoderContext* createContext(const core::Rect& r,
+                                               const Settings& settings);
+
+      virtual ~H264EncoderContext() = 0;
+
+      // encode() compresses the contents of the PixelBuffer, which must
+      // have the same size as the context, as the next frame and writes
+      // the resulting H.264 stream to os
+      virtual void encode(const PixelBuffer* /*pb*/,
+                          rdr::OutStream* /*os*/) {}
+
+      inline bool isEqualRect(const core::Rect &r) const { return r == rect; }
+
+    protected:
+      core::Rect rect;
+      Settings settings;
+
+      H264EncoderContext(const core::Rect &r, const Settings& s)
+        : rect(r), settings(s) {}
+  };
+
+}
+
+#endif
@@ -0,0 +1,253 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <core/i18n.h>
+
+#include <rdr/OutStream.h>
+
+#include <rfb/PixelBuffer.h>
+#include <rfb/H264LibavEncoderContext.h>
+
+using namespace rfb;
+
+// Only software encoders, as there might not be any GPU on the server
+static const char* const codecNames[] = {
+  "libx264", "libopenh264",
+};
+
+// libx264 presets to use for the different levels of effort, going
+// from fastest to slowest
+static const char* const presets[] = {
+  "ultrafast", "superfast", "veryfast", "faster", "fast",
+};
+
+// Formats that libswscale can read directly
+static const PixelFormat pfRGBX(32, 24, false, true, 255, 255, 255, 0, 8, 16);
+static const PixelFormat pfBGRX(32, 24, false, true, 255, 255, 255, 16, 8, 0);
+static const PixelFormat pfXRGB(32, 24, false, true, 255, 255, 255, 8, 16, 24);
+static const PixelFormat pfXBGR(32, 24, false, true, 255, 255, 255, 24, 16, 8);
+
+H264LibavEncoderContext::H264LibavEncoderContext(const core::Rect& r,
+                                                 const Settings& s)
+  : H264EncoderContext(r, s), avctx(nullptr), frame(nullptr),
+    packet(nullptr), sws(nullptr), pts(0)
+{
+  const AVCodec *codec;
+  AVDictionary *options;
+  int ret;
+
+  codec = findCodec();
+  if (!codec)
+    throw std::runtime_error(_("Could not find video codec"));
+
+  avctx = avcodec_alloc_context3(codec);
+  if (!avctx)
+    throw std::runtime_error(_("Could not allocate video codec context"));
+
+  try {
+    // 4:2:0 needs an even size, but the viewer will only use the part
+    // that covers the rect
+    avctx->width = (rect.width() + 1) & ~1;
+    avctx->height = (rect.height() + 1) & ~1;
+    avctx->pix_fmt = AV_PIX_FMT_YUV420P;
+    avctx->time_base = { 1, settings.frameRate };
+    avctx->framerate = { settings.frameRate, 1 };
+
+    // Same conversion as the viewer will assume
+    avctx->colorspace = AVCOL_SPC_SMPTE170M;
+    avctx->color_range = AVCOL_RANGE_MPEG;
+
+    // Every frame has to be shown as soon as it arrives, so nothing
+    // can refer to a later frame
+    avctx->max_b_frames = 0;
+
+    options = nullptr;
+
+    if (strcmp(codec->name, "libx264") == 0) {
+      int preset;
+
+      preset = std::min(std::max(settings.effort, 0) / 2,
+                        (int)(sizeof(presets)/sizeof(presets[0])) - 1);
+
+      av_dict_set(&options, "preset", presets[preset], 0);
+      av_dict_set(&options, "tune", "zerolatency", 0);
+
+      if (settings.bitrate == 0) {
+        char crf[16];
+
+        // Roughly the same range as JPEG quality 0-100
+        snprintf(crf, sizeof(crf), "%d", 42 - settings.quality * 24 / 100);
+        av_dict_set(&options, "crf", crf, 0);
+      }
+    }
+
+    if (settings.bitrate != 0) {
+      avctx->bit_rate = settings.bitrate * 1000LL;
+      avctx->rc_max_rate = avctx->bit_rate;
+      // Only room for about one frame, so that we never build up a
+      // backlog in the connection
+      avctx->rc_buffer_size = avctx->bit_rate / settings.frameRate;
+    } else if (strcmp(codec->name, "libx264") != 0) {
+      // No constant quality mode, so make a guess based on the number
+      // of pixels instead
+      avctx->bit_rate = (int64_t)avctx->width * avctx->height *
+                        settings.frameRate * (settings.quality + 10) / 900;
+    }
+
+    ret = avcodec_open2(avctx, codec, &options);
+    av_dict_free(&options);
+    if (ret < 0)
+      throw std::runtime_error(_("Could not open video codec"));
+
+    frame = av_frame_alloc();
+    if (!frame)
+      throw std::runtime_error(_("Could not allocate video frame"));
+
+    frame->format = avctx->pix_fmt;
+    frame->width = avctx->width;
+    frame->height = avctx->height;
+
+    if (av_frame_get_buffer(frame, 0) < 0)
+      throw std::runtime_error(_("Could not allocate video frame"));
+
+    // Any padding is never shown, but should still be initialised
+    memset(frame->data[0], 0, frame->linesize[0] * frame->height);
+    memset(frame->data[1], 128, frame->linesize[1] * frame->height / 2);
+    memset(frame->data[2], 128, frame->linesize[2] * frame->height / 2);
+
+    packet = av_packet_alloc();
+    if (!packet)
+      throw std::runtime_error(_("Could not allocate video packet"));
+  } catch (...) {
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&avctx);
+    throw;
+  }
+}
+
+H264LibavEncoderContext::~H264LibavEncoderContext()
+{
+  av_packet_free(&packet);
+  av_frame_free(&frame);
+  avcodec_free_context(&avctx);
+  sws_freeContext(sws);
+}
+
+bool H264LibavEncoderContext::isAvailable()
+{
+  static bool available = findCodec() != nullptr;
+  return available;
+}
+
+const AVCodec* H264LibavEncoderContext::findCodec()
+{
+  for (const char* name : codecNames) {
+    const AVCodec* codec;
+
+    codec = avcodec_find_encoder_by_name(name);
+    if (codec != nullptr)
+      return codec;
+  }
+
+  return nullptr;
+}
+
+void H264LibavEncoderContext::encode(const PixelBuffer* pb,
+                                     rdr::OutStream* os)
+{
+  const uint8_t* buffer;
+  int stride;
+
+  AVPixelFormat srcFormat;
+  const uint8_t* srcData[4] = {};
+  int srcLinesize[4] = {};
+
+  int ret;
+
+  assert(pb->width() == rect.width());
+  assert(pb->height() == rect.height());
+
+  buffer = pb->getBuffer(pb->getRect(), &stride);
+
+  if (pfRGBX == pb->getPF())
+    srcFormat = AV_PIX_FMT_RGB0;
+  else if (pfBGRX == pb->getPF())
+    srcFormat = AV_PIX_FMT_BGR0;
+  else if (pfXRGB == pb->getPF())
+    srcFormat = AV_PIX_FMT_0RGB;
+  else if (pfXBGR == pb->getPF())
+    srcFormat = AV_PIX_FMT_0BGR;
+  else
+    srcFormat = AV_PIX_FMT_NONE;
+
+  if (srcFormat != AV_PIX_FMT_NONE) {
+    srcData[0] = buffer;
+    srcLinesize[0] = stride * 4;
+  } else {
+    rgbBuffer.resize(rect.area() * 3);
+    pb->getPF().rgbFromBuffer(rgbBuffer.data(), buffer,
+                              rect.width(), stride, rect.height());
+
+    srcFormat = AV_PIX_FMT_RGB24;
+    srcData[0] = rgbBuffer.data();
+    srcLinesize[0] = rect.width() * 3;
+  }
+
+  sws = sws_getCachedContext(sws, rect.width(), rect.height(), srcFormat,
+                             rect.width(), rect.height(),
+                             AV_PIX_FMT_YUV420P, SWS_POINT,
+                             nullptr, nullptr, nullptr);
+  if (!sws)
+    throw std::runtime_error(_("Could not create video scaling context"));
+
+  // The codec might still be holding on to the previous frame
+  if (av_frame_make_writable(frame) < 0)
+    throw std::runtime_error(_("Could not allocate video frame"));
+
+  sws_scale(sws, srcData, srcLinesize, 0, rect.height(),
+            frame->data, frame->linesize);
+
+  frame->pts = pts++;
+
+  if (avcodec_send_frame(avctx, frame) < 0)
+    throw std::runtime_error(_("Could not encode video frame"));
+
+  while (true) {
+    ret = avcodec_receive_packet(avctx, packet);
+    if ((ret == AVERROR(EAGAIN)) || (ret == AVERROR_EOF))
+      break;
+    if (ret < 0)
+      throw std::runtime_error(_("Could not encode video frame"));
+
+    os->writeBytes(packet->data, packet->size);
+
+    av_packet_unref(packet);
+  }
+}
@@ -0,0 +1,54 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifndef __RFB_H264LIBAVENCODER_H__
+#define __RFB_H264LIBAVENCODER_H__
+
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+}
+
+#include <rfb/H264EncoderContext.h>
+
+namespace rfb {
+  class H264LibavEncoderContext : public H264EncoderContext {
+    public:
+      H264LibavEncoderContext(const core::Rect &r,
+                              const Settings& settings);
+      ~H264LibavEncoderContext();
+
+      static bool isAvailable();
+
+      void encode(const PixelBuffer* pb, rdr::OutStream* os) override;
+
+    private:
+      static const AVCodec* findCodec();
+
+      AVCodecContext *avctx;
+      AVFrame* frame;
+      AVPacket* packet;
+      SwsContext* sws;
+      int64_t pts;
+      std::vector<uint8_t> rgbBuffer;
+  };
+}
+
+#endif
@@ -0,0 +1,608 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+
+#include <core/ImplSelector.h>
+#include <core/LogWriter.h>
+#include <core/cpu.h>
+
+#include <rfb/IndexPack.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_SSSE3
+#define HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace rfb;
+
+static core::LogWriter vlog("IndexPack");
+
+// The vector implementations handle as many whole vectors as they
+// can, which always covers a multiple of eight indices and hence whole
+// bytes, and then leave the rest to the generic code
+
+struct GenericPack {
+  static void pack(const uint8_t* in, uint8_t* out, int width, int bits)
+  {
+    int perByte;
+
+    perByte = 8 / bits;
+
+    for (int x = 0; x < width; x += perByte) {
+      uint8_t byte;
+
+      byte = 0;
+      for (int i = 0; i < perByte; i++) {
+        byte <<= bits;
+        if (x + i < width)
+          byte |= in[x + i];
+      }
+
+      *out++ = byte;
+    }
+  }
+
+  static void unpack(const uint8_t* in, uint8_t* out, int width,
+                     int bits)
+  {
+    int perByte;
+    uint8_t mask;
+
+    perByte = 8 / bits;
+    mask = (1 << bits) - 1;
+
+    for (int x = 0; x < width; x++) {
+      int shift;
+
+      shift = 8 - bits * (x % perByte + 1);
+      out[x] = (in[x / perByte] >> shift) & mask;
+    }
+  }
+};
+
+#ifdef HAVE_SSSE3
+
+struct SSSE3Pack {
+  static void pack(const uint8_t* in, uint8_t* out, int width, int bits)
+  {
+    int x;
+
+    switch (bits) {
+    case 1:
+      x = pack1(in, out, width);
+      break;
+    case 2:
+      x = pack2(in, out, width);
+      break;
+    default:
+      x = pack4(in, out, width);
+    }
+
+    GenericPack::pack(in + x, out + x * bits / 8, width - x, bits);
+  }
+
+  // Reversing each group of eight lets movemask put the first index
+  // in the most significant bit
+  __attribute__((target("ssse3")))
+  static int pack1(const uint8_t* in, uint8_t* out, int width)
+  {
+    __m128i reverse;
+    int x;
+
+    reverse = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15,
+                           0, 1, 2, 3, 4, 5, 6, 7);
+
+    for (x = 0; x + 16 <= width; x += 16) {
+      __m128i v;
+      int bits;
+
+      v = _mm_loadu_si128((const __m128i*)(in + x));
+      v = _mm_shuffle_epi8(v, reverse);
+      bits = _mm_movemask_epi8(_mm_slli_epi16(v, 7));
+
+      out[x / 8] = bits;
+      out[x / 8 + 1] = bits >> 8;
+    }
+
+    return x;
+  }
+
+  // Multiplying and adding neighbours shifts them in to place, first
+  // as pairs and then as pairs of pairs
+  __attribute__((target("ssse3")))
+  static int pack2(const uint8_t* in, uint8_t* out, int width)
+  {
+    __m128i pairs, quads;
+    int x;
+
+    pairs = _mm_set1_epi16(0x0104);
+    quads = _mm_set1_epi32(0x00010010);
+
+    for (x = 0; x + 64 <= width; x += 64) {
+      __m128i v[4];
+
+      for (int i = 0; i < 4; i++) {
+        v[i] = _mm_loadu_si128((const __m128i*)(in + x + i * 16));
+        v[i] = _mm_madd_epi16(_mm_maddubs_epi16(v[i], pairs), quads);
+      }
+
+      _mm_storeu_si128((__m128i*)(out + x / 4),
+                       _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]),
+                                        _mm_packs_epi32(v[2], v[3])));
+    }
+
+    return x;
+  }
+
+  __attribute__((target("ssse3")))
+  static int pack4(const uint8_t* in, uint8_t* out, int width)
+  {
+    __m128i pairs;
+    int x;
+
+    pairs = _mm_set1_epi16(0x0110);
+
+    for (x = 0; x + 32 <= width; x += 32) {
+      __m128i a, b;
+
+      a = _mm_loadu_si128((const __m128i*)(in + x));
+      b = _mm_loadu_si128((const __m128i*)(in + x + 16));
+
+      a = _mm_maddubs_epi16(a, pairs);
+      b = _mm_maddubs_epi16(b, pairs);
+
+      _mm_storeu_si128((__m128i*)(out + x / 2), _mm_packus_epi16(a, b));
+    }
+
+    return x;
+  }
+
+  static void unpack(const uint8_t* in, uint8_t* out, int width,
+                     int bits)
+  {
+    int x;
+
+    switch (bits) {
+    case 1:
+      x = unpack1(in, out, width);
+      break;
+    case 2:
+      x = unpack2(in, out, width);
+      break;
+    default:
+      x = unpack4(in, out, width);
+    }
+
+    GenericPack::unpack(in + x * bits / 8, out + x, width - x, bits);
+  }
+
+  __attribute__((target("ssse3")))
+  static int unpack1(const uint8_t* in, uint8_t* out, int width)
+  {
+    __m128i spread, mask, one;
+    int x;
+
+    spread = _mm_set_epi8(1, 1, 1, 1, 1, 1, 1, 1,
+                          0, 0, 0, 0, 0, 0, 0, 0);
+    mask = _mm_set_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40,
+                        (char)0x80, 0x01, 0x02, 0x04, 0x08, 0x10,
+                        0x20, 0x40, (char)0x80);
+    one = _mm_set1_epi8(1);
+
+    for (x = 0; x + 16 <= width; x += 16) {
+      __m128i v;
+
+      v = _mm_cvtsi32_si128(in[x / 8] | in[x / 8 + 1] << 8);
+      v = _mm_shuffle_epi8(v, spread);
+      v = _mm_cmpeq_epi8(_mm_and_si128(v, mask), mask);
+
+      _mm_storeu_si128((__m128i*)(out + x), _mm_and_si128(v, one));
+    }
+
+    return x;
+  }
+
+  __attribute__((target("ssse3")))
+  static int unpack2(const uint8_t* in, uint8_t* out, int width)
+  {
+    __m128i mask;
+    int x;
+
+    mask = _mm_set1_epi8(0x03);
+
+    for (x = 0; x + 64 <= width; x += 64) {
+      __m128i v, a, b, c, d, ab, cd;
+
+      v = _mm_loadu_si128((const __m128i*)(in + x / 4));
+
+      a = _mm_and_si128(_mm_srli_epi16(v, 6), mask);
+      b = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+      c = _mm_and_si128(_mm_srli_epi16(v, 2), mask);
+      d = _mm_and_si128(v, mask);
+
+      ab = _mm_unpacklo_epi8(a, b);
+      cd = _mm_unpacklo_epi8(c, d);
+      _mm_storeu_si128((__m128i*)(out + x), _mm_unpacklo_epi16(ab, cd));
+      _mm_storeu_si128((__m128i*)(out + x + 16),
+                       _mm_unpackhi_epi16(ab, cd));
+
+      ab = _mm_unpackhi_epi8(a, b);
+      cd = _mm_unpackhi_epi8(c, d);
+      _mm_storeu_si128((__m128i*)(out + x + 32),
+                       _mm_unpacklo_epi16(ab, cd));
+      _mm_storeu_si128((__m128i*)(out + x + 48),
+                       _mm_unpackhi_epi16(ab, cd));
+    }
+
+    return x;
+  }
+
+  __attribute__((target("ssse3")))
+  static int unpack4(const uint8_t* in, uint8_t* out, int width)
+  {
+    __m128i mask;
+    int x;
+
+    mask = _mm_set1_epi8(0x0f);
+
+    for (x = 0; x + 32 <= width; x += 32) {
+      __m128i v, high, low;
+
+      v = _mm_loadu_si128((const __m128i*)(in + x / 2));
+
+      high = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+      low = _mm_and_si128(v, mask);
+
+      _mm_storeu_si128((__m128i*)(out + x), _mm_unpacklo_epi8(high, low));
+      _mm_storeu_si128((__m128i*)(out + x + 16),
+                       _mm_unpackhi_epi8(high, low));
+    }
+
+    return x;
+  }
+};
+
+#endif
+
+#ifdef HAVE_AVX2
+
+struct AVX2Pack {
+  // ZRLE tiles are at most 64 pixels wide, which isn't enough for a
+  // whole 256-bit vector of 2-bit indices, so those are left to the
+  // SSSE3 code together with anything else that remains
+  static void pack(const uint8_t* in, uint8_t* out, int width, int bits)
+  {
+    int x;
+
+    switch (bits) {
+    case 1:
+      x = pack1(in, out, width);
+      break;
+    case 4:
+      x = pack4(in, out, width);
+      break;
+    default:
+      x = 0;
+    }
+
+    SSSE3Pack::pack(in + x, out + x * bits / 8, width - x, bits);
+  }
+
+  __attribute__((target("avx2")))
+  static int pack1(const uint8_t* in, uint8_t* out, int width)
+  {
+    __m256i reverse;
+    int x;
+
+    reverse = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15,
+                              0, 1, 2, 3, 4, 5, 6, 7,
+                              8, 9, 10, 11, 12, 13, 14, 15,
+                              0, 1, 2, 3, 4, 5, 6, 7);
+
+    for (x = 0; x + 32 <= width; x += 32) {
+      __m256i v;
+      uint32_t bits;
+
+      v = _mm256_loadu_si256((const __m256i*)(in + x));
+      v = _mm256_shuffle_epi8(v, reverse);
+      bits = _mm256_movemask_epi8(_mm256_slli_epi16(v, 7));
+
+      out[x / 8] = bits;
+      out[x / 8 + 1] = bits >> 8;
+      out[x / 8 + 2] = bits >> 16;
+      out[x / 8 + 3] = bits >> 24;
+    }
+
+    return x;
+  }
+
+  __attribute__((target("avx2")))
+  static int pack4(const uint8_t* in, uint8_t* out, int width)
+  {
+    __m256i pairs;
+    int x;
+
+    pairs = _mm256_set1_epi16(0x0110);
+
+    for (x = 0; x + 64 <= width; x += 64) {
+      __m256i a, b, packed;
+
+      a = _mm256_loadu_si256((const __m256i*)(in + x));
+      b = _mm256_loadu_si256((const __m256i*)(in + x + 32));
+
+      a = _mm256_maddubs_epi16(a, pairs);
+      b = _mm256_maddubs_epi16(b, pairs);
+
+      // Packing works on each 128-bit half separately, so the result
+      // needs to be put back in order
+      packed = _mm256_packus_epi16(a, b);
+      packed = _mm256_permute4x64_epi64(packed, 0xd8);
+
+      _mm256_storeu_si256((__m256i*)(out + x / 2), packed);
+    }
+
+    return x;
+  }
+
+  // Nothing to gain from wider vectors here
+  static void unpack(const uint8_t* in, uint8_t* out, int width,
+                     int bits)
+  {
+    SSSE3Pack::unpack(in, out, width, bits);
+  }
+};
+
+#endif
+
+#ifdef HAVE_NEON
+
+struct NEONPack {
+  static void pack(const uint8_t* in, uint8_t* out, int width, int bits)
+  {
+    int x;
+
+    switch (bits) {
+    case 1:
+      x = pack1(in, out, width);
+      break;
+    case 2:
+      x = pack2(in, out, width);
+      break;
+    default:
+      x = pack4(in, out, width);
+    }
+
+    GenericPack::pack(in + x, out + x * bits / 8, width - x, bits);
+  }
+
+  // Each index is shifted in to its bit, and then pairwise adds
+  // combine each group of eight
+  static int pack1(const uint8_t* in, uint8_t* out, int width)
+  {
+    static const int8_t shifts[16] = { 7, 6, 5, 4, 3, 2, 1, 0,
+                                       7, 6, 5, 4, 3, 2, 1, 0 };
+
+    int8x16_t shift;
+    int x;
+
+    shift = vld1q_s8(shifts);
+
+    for (x = 0; x + 16 <= width; x += 16) {
+      uint8x16_t v;
+
+      v = vshlq_u8(vld1q_u8(in + x), shift);
+      v = vpaddq_u8(v, v);
+      v = vpaddq_u8(v, v);
+      v = vpaddq_u8(v, v);
+
+      out[x / 8] = vgetq_lane_u8(v, 0);
+      out[x / 8 + 1] = vgetq_lane_u8(v, 1);
+    }
+
+    return x;
+  }
+
+  // De-interleaving loads give us vectors with the indices that end
+  // up in the same position in each byte
+  static int pack2(const uint8_t* in, uint8_t* out, int width)
+  {
+    int x;
+
+    for (x = 0; x + 64 <= width; x += 64) {
+      uint8x16x4_t v;
+      uint8x16_t high, low;
+
+      v = vld4q_u8(in + x);
+
+      high = vsliq_n_u8(v.val[1], v.val[0], 2);
+      low = vsliq_n_u8(v.val[3], v.val[2], 2);
+
+      vst1q_u8(out + x / 4, vsliq_n_u8(low, high, 4));
+    }
+
+    return x;
+  }
+
+  static int pack4(const uint8_t* in, uint8_t* out, int width)
+  {
+    int x;
+
+    for (x = 0; x + 32 <= width; x += 32) {
+      uint8x16x2_t v;
+
+      v = vld2q_u8(in + x);
+      vst1q_u8(out + x / 2, vsliq_n_u8(v.val[1], v.val[0], 4));
+    }
+
+    return x;
+  }
+
+  static void unpack(const uint8_t* in, uint8_t* out, int width,
+                     int bits)
+  {
+    int x;
+
+    switch (bits) {
+    case 1:
+      x = unpack1(in, out, width);
+      break;
+    case 2:
+      x = unpack2(in, out, width);
+      break;
+    default:
+      x = unpack4(in, out, width);
+    }
+
+    GenericPack::unpack(in + x * bits / 8, out + x, width - x, bits);
+  }
+
+  static int unpack1(const uint8_t* in, uint8_t* out, int width)
+  {
+    static const uint8_t masks[16] = { 0x80, 0x40, 0x20, 0x10,
+                                       0x08, 0x04, 0x02, 0x01,
+                                       0x80, 0x40, 0x20, 0x10,
+                                       0x08, 0x04, 0x02, 0x01 };
+
+    uint8x16_t mask, one;
+    int x;
+
+    mask = vld1q_u8(masks);
+    one = vdupq_n_u8(1);
+
+    for (x = 0; x + 16 <= width; x += 16) {
+      uint8x16_t v;
+
+      v = vcombine_u8(vdup_n_u8(in[x / 8]), vdup_n_u8(in[x / 8 + 1]));
+      vst1q_u8(out + x, vandq_u8(vtstq_u8(v, mask), one));
+    }
+
+    return x;
+  }
+
+  // Interleaving stores put everything back in order
+  static int unpack2(const uint8_t* in, uint8_t* out, int width)
+  {
+    uint8x16_t mask;
+    int x;
+
+    mask = vdupq_n_u8(0x03);
+
+    for (x = 0; x + 64 <= width; x += 64) {
+      uint8x16_t v;
+      uint8x16x4_t r;
+
+      v = vld1q_u8(in + x / 4);
+
+      r.val[0] = vshrq_n_u8(v, 6);
+      r.val[1] = vandq_u8(vshrq_n_u8(v, 4), mask);
+      r.val[2] = vandq_u8(vshrq_n_u8(v, 2), mask);
+      r.val[3] = vandq_u8(v, mask);
+
+      vst4q_u8(out + x, r);
+    }
+
+    return x;
+  }
+
+  static int unpack4(const uint8_t* in, uint8_t* out, int width)
+  {
+    uint8x16_t mask;
+    int x;
+
+    mask = vdupq_n_u8(0x0f);
+
+    for (x = 0; x + 32 <= width; x += 32) {
+      uint8x16_t v;
+      uint8x16x2_t r;
+
+      v = vld1q_u8(in + x / 2);
+
+      r.val[0] = vshrq_n_u8(v, 4);
+      r.val[1] = vandq_u8(v, mask);
+
+      vst2q_u8(out + x, r);
+    }
+
+    return x;
+  }
+};
+
+#endif
+
+struct IndexPackImpl {
+  const char* name;
+  void (*pack)(const uint8_t*, uint8_t*, int, int);
+  void (*unpack)(const uint8_t*, uint8_t*, int, int);
+  bool (*supported)();
+};
+
+#define IMPL(name, packer, supported) \
+  { name, packer::pack, packer::unpack, supported }
+
+// Best implementation first
+static const IndexPackImpl impls[] = {
+#ifdef HAVE_AVX2
+  IMPL("avx2", AVX2Pack, core::cpuSupportsAVX2),
+#endif
+#ifdef HAVE_SSSE3
+  IMPL("ssse3", SSSE3Pack, core::cpuSupportsSSSE3),
+#endif
+#ifdef HAVE_NEON
+  IMPL("neon", NEONPack, nullptr),
+#endif
+  IMPL("generic", GenericPack, nullptr),
+};
+
+#undef IMPL
+
+static core::ImplSelector<IndexPackImpl> selector(impls, &vlog);
+
+void rfb::packIndexRow(const uint8_t* in, uint8_t* out, int width,
+                       int bits)
+{
+  assert((bits == 1) || (bits == 2) || (bits == 4));
+  selector.get()->pack(in, out, width, bits);
+}
+
+void rfb::unpackIndexRow(const uint8_t* in, uint8_t* out, int width,
+                         int bits)
+{
+  assert((bits == 1) || (bits == 2) || (bits == 4));
+  selector.get()->unpack(in, out, width, bits);
+}
+
+const char* rfb::indexPackImpl()
+{
+  return selector.name();
+}
+
+bool rfb::setIndexPackImpl(const char* name)
+{
+  return selector.set(name);
+}
@@ -0,0 +1,51 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// Row functions for packing palette indices in to fewer bits, as
+// used by ZRLE
+//
+
+#ifndef __RFB_INDEXPACK_H__
+#define __RFB_INDEXPACK_H__
+
+#include <stdint.h>
+
+namespace rfb {
+
+  // packIndexRow() packs a row of palette indices using the given
+  // number of bits (1, 2 or 4) per index, with the first index in the
+  // most significant bits. The indices must fit in that many bits, and
+  // any bits left over in the last byte are set to zero.
+  void packIndexRow(const uint8_t* in, uint8_t* out, int width,
+                    int bits);
+
+  // unpackIndexRow() does the reverse of packIndexRow()
+  void unpackIndexRow(const uint8_t* in, uint8_t* out, int width,
+                      int bits);
+
+  // indexPackImpl() returns the name of the implementation that is
+  // currently used. The best one available on this CPU is picked
+  // automatically, but setIndexPackImpl() can be used to force a
+  // specific one. It returns false if it isn't supported.
+  const char* indexPackImpl();
+  bool setIndexPackImpl(const char* name);
+
+}
+
+#endif
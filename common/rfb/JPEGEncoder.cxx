@@ -78,7 +78,7 @@ void JPEGEncoder::writeRect(const PixelBuffer* pb,
   jc.clear();
   jc.compress(buffer, stride, pb->getRect(), pb->getPF());
 
-  os = conn->getOutStream();
+  os = getOutStream();
 
   data = jc.data();
   len = jc.length();
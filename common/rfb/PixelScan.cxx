@@ -0,0 +1,244 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <core/ImplSelector.h>
+#include <core/LogWriter.h>
+#include <core/cpu.h>
+
+#include <rfb/PixelScan.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__)
+#define HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace rfb;
+
+static core::LogWriter vlog("PixelScan");
+
+// Each implementation compares as many whole vectors as it can, and
+// then leaves the remaining pixels to countTail()
+
+template<class T>
+static inline int countTail(const T* buffer, int start, int width,
+                            T colour)
+{
+  int x;
+
+  for (x = start; x < width; x++) {
+    if (buffer[x] != colour)
+      break;
+  }
+
+  return x;
+}
+
+struct GenericScan {
+  template<class T>
+  static int count(const T* buffer, int width, T colour)
+  {
+    return countTail(buffer, 0, width, colour);
+  }
+};
+
+#ifdef HAVE_SSE2
+
+struct SSE2Scan {
+  static inline __m128i splat(uint8_t c) { return _mm_set1_epi8(c); }
+  static inline __m128i splat(uint16_t c) { return _mm_set1_epi16(c); }
+  static inline __m128i splat(uint32_t c) { return _mm_set1_epi32(c); }
+
+  template<class T>
+  static int count(const T* buffer, int width, T colour)
+  {
+    const int N = 16 / sizeof(T);
+
+    __m128i c;
+    int x;
+
+    c = splat(colour);
+
+    for (x = 0; x + N <= width; x += N) {
+      __m128i v;
+      unsigned differs;
+
+      v = _mm_loadu_si128((const __m128i*)(buffer + x));
+      differs = _mm_movemask_epi8(_mm_cmpeq_epi8(v, c)) ^ 0xffff;
+      if (differs != 0)
+        return x + __builtin_ctz(differs) / sizeof(T);
+    }
+
+    return countTail(buffer, x, width, colour);
+  }
+};
+
+#endif
+
+#ifdef HAVE_AVX2
+
+struct AVX2Scan {
+  __attribute__((target("avx2")))
+  static inline __m256i splat(uint8_t c) { return _mm256_set1_epi8(c); }
+  __attribute__((target("avx2")))
+  static inline __m256i splat(uint16_t c) { return _mm256_set1_epi16(c); }
+  __attribute__((target("avx2")))
+  static inline __m256i splat(uint32_t c) { return _mm256_set1_epi32(c); }
+
+  template<class T>
+  __attribute__((target("avx2")))
+  static int count(const T* buffer, int width, T colour)
+  {
+    const int N = 32 / sizeof(T);
+
+    __m256i c;
+    int x;
+
+    c = splat(colour);
+
+    for (x = 0; x + N <= width; x += N) {
+      __m256i v;
+      uint32_t differs;
+
+      v = _mm256_loadu_si256((const __m256i*)(buffer + x));
+      differs = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, c));
+      if (differs != 0)
+        return x + __builtin_ctz(differs) / sizeof(T);
+    }
+
+    return countTail(buffer, x, width, colour);
+  }
+};
+
+#endif
+
+#ifdef HAVE_NEON
+
+struct NEONScan {
+  static inline uint8x16_t splat(uint8_t c)
+  {
+    return vdupq_n_u8(c);
+  }
+  static inline uint8x16_t splat(uint16_t c)
+  {
+    return vreinterpretq_u8_u16(vdupq_n_u16(c));
+  }
+  static inline uint8x16_t splat(uint32_t c)
+  {
+    return vreinterpretq_u8_u32(vdupq_n_u32(c));
+  }
+
+  template<class T>
+  static int count(const T* buffer, int width, T colour)
+  {
+    const int N = 16 / sizeof(T);
+
+    uint8x16_t c;
+    int x;
+
+    c = splat(colour);
+
+    for (x = 0; x + N <= width; x += N) {
+      uint8x16_t v;
+      uint8x8_t narrowed;
+      uint64_t differs;
+
+      v = vld1q_u8((const uint8_t*)(buffer + x));
+      v = vceqq_u8(v, c);
+
+      // NEON has no movemask, but narrowing gives us four bits per
+      // byte which works just as well
+      narrowed = vshrn_n_u16(vreinterpretq_u16_u8(v), 4);
+      differs = ~vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+      if (differs != 0)
+        return x + __builtin_ctzll(differs) / 4 / sizeof(T);
+    }
+
+    return countTail(buffer, x, width, colour);
+  }
+};
+
+#endif
+
+struct PixelScanImpl {
+  const char* name;
+  int (*count8)(const uint8_t*, int, uint8_t);
+  int (*count16)(const uint16_t*, int, uint16_t);
+  int (*count32)(const uint32_t*, int, uint32_t);
+  bool (*supported)();
+};
+
+#define IMPL(name, scan, supported) \
+  { name, scan::count<uint8_t>, scan::count<uint16_t>, \
+    scan::count<uint32_t>, supported }
+
+// Best implementation first
+static const PixelScanImpl impls[] = {
+#ifdef HAVE_AVX2
+  IMPL("avx2", AVX2Scan, core::cpuSupportsAVX2),
+#endif
+#ifdef HAVE_SSE2
+  IMPL("sse2", SSE2Scan, nullptr),
+#endif
+#ifdef HAVE_NEON
+  IMPL("neon", NEONScan, nullptr),
+#endif
+  IMPL("generic", GenericScan, nullptr),
+};
+
+#undef IMPL
+
+static core::ImplSelector<PixelScanImpl> selector(impls, &vlog);
+
+int rfb::countPixels(const uint8_t* buffer, int width, uint8_t colour)
+{
+  return selector.get()->count8(buffer, width, colour);
+}
+
+int rfb::countPixels(const uint16_t* buffer, int width, uint16_t colour)
+{
+  return selector.get()->count16(buffer, width, colour);
+}
+
+int rfb::countPixels(const uint32_t* buffer, int width, uint32_t colour)
+{
+  return selector.get()->count32(buffer, width, colour);
+}
+
+const char* rfb::pixelScanImpl()
+{
+  return selector.name();
+}
+
+bool rfb::setPixelScanImpl(const char* name)
+{
+  return selector.set(name);
+}
@@ -0,0 +1,42 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifndef __RFB_PIXELSCAN_H__
+#define __RFB_PIXELSCAN_H__
+
+#include <stdint.h>
+
+namespace rfb {
+
+  // countPixels() returns how many pixels at the start of the row
+  // have the given colour, i.e. the length of the initial run. It
+  // returns width if the entire row is that colour.
+  int countPixels(const uint8_t* buffer, int width, uint8_t colour);
+  int countPixels(const uint16_t* buffer, int width, uint16_t colour);
+  int countPixels(const uint32_t* buffer, int width, uint32_t colour);
+
+  // pixelScanImpl() returns the name of the implementation that
+  // countPixels() currently uses. The best one available on this CPU
+  // is picked automatically, but setPixelScanImpl() can be used to
+  // force a specific one. It returns false if it isn't supported.
+  const char* pixelScanImpl();
+  bool setPixelScanImpl(const char* name);
+
+}
+
+#endif
@@ -0,0 +1,261 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <algorithm>
+
+#include <core/LogWriter.h>
+#include <core/time.h>
+
+#include <rfb/ClientParams.h>
+#include <rfb/QualityController.h>
+
+using namespace rfb;
+
+static core::LogWriter vlog("QualityController");
+
+// How far we may move away from what the client asked for
+static const int MaxCompressOffset = 2;
+static const int MaxQualityDrop = 3;
+
+// Shortest time we look at before making a change, in milliseconds.
+// It also has to cover a few round trips so that the effect of the
+// previous change is visible.
+static const unsigned MinPeriod = 1000;
+static const unsigned MinUpdates = 4;
+
+QualityController::QualityController()
+  : clientCompressLevel(-1), clientQualityLevel(-1),
+    clientFineQualityLevel(-1), clientSubsampling(subsampleUndefined),
+    compressOffset(0), qualityDrop(0), subsampled(false),
+    bandwidth(0), rtt(-1), periodStart(), periodUpdates(0),
+    periodBytes(0), periodEncodeTime(0)
+{
+}
+
+QualityController::~QualityController()
+{
+}
+
+void QualityController::setClientSettings(int compressLevel,
+                                          int qualityLevel,
+                                          int fineQualityLevel,
+                                          int subsampling)
+{
+  if ((compressLevel == clientCompressLevel) &&
+      (qualityLevel == clientQualityLevel) &&
+      (fineQualityLevel == clientFineQualityLevel) &&
+      (subsampling == clientSubsampling))
+    return;
+
+  clientCompressLevel = compressLevel;
+  clientQualityLevel = qualityLevel;
+  clientFineQualityLevel = fineQualityLevel;
+  clientSubsampling = subsampling;
+
+  compressOffset = 0;
+  qualityDrop = 0;
+  subsampled = false;
+
+  periodUpdates = 0;
+}
+
+void QualityController::setNetwork(size_t bandwidth_, int rtt_)
+{
+  bandwidth = bandwidth_;
+  rtt = rtt_;
+}
+
+void QualityController::update(size_t bytes, unsigned encodeTime,
+                               int frameTime, const struct timeval* now)
+{
+  unsigned period, sendTime, averageEncodeTime;
+
+  if (periodUpdates == 0) {
+    periodStart = *now;
+    periodBytes = 0;
+    periodEncodeTime = 0;
+  }
+
+  periodUpdates++;
+  periodBytes += bytes;
+  periodEncodeTime += encodeTime;
+
+  period = MinPeriod;
+  if ((rtt > 0) && ((unsigned)rtt * 4 > period))
+    period = rtt * 4;
+
+  if ((periodUpdates < MinUpdates) ||
+      (core::msBetween(&periodStart, now) < period))
+    return;
+
+  if ((bandwidth == 0) || (frameTime <= 0)) {
+    periodUpdates = 0;
+    return;
+  }
+
+  sendTime = (unsigned long long)periodBytes * 1000 /
+             bandwidth / periodUpdates;
+  averageEncodeTime = periodEncodeTime / 1000 / periodUpdates;
+
+  adjust(sendTime, averageEncodeTime, frameTime);
+
+  periodUpdates = 0;
+}
+
+int QualityController::getCompressLevel() const
+{
+  if (clientCompressLevel == -1)
+    return -1;
+
+  return std::min(std::max(clientCompressLevel + compressOffset, 0), 9);
+}
+
+int QualityController::getQualityLevel() const
+{
+  if (clientQualityLevel == -1)
+    return -1;
+
+  return std::max(clientQualityLevel - qualityDrop, 0);
+}
+
+int QualityController::getFineQualityLevel() const
+{
+  if (clientFineQualityLevel == -1)
+    return -1;
+
+  return std::max(clientFineQualityLevel - qualityDrop * 10, 1);
+}
+
+int QualityController::getSubsampling() const
+{
+  if (!subsampled)
+    return clientSubsampling;
+
+  switch (clientSubsampling) {
+  case subsampleNone:
+    return subsample2X;
+  case subsample2X:
+    return subsample4X;
+  }
+
+  return clientSubsampling;
+}
+
+bool QualityController::isAdjusted() const
+{
+  return (getCompressLevel() != clientCompressLevel) ||
+         (getQualityLevel() != clientQualityLevel) ||
+         (getFineQualityLevel() != clientFineQualityLevel) ||
+         (getSubsampling() != clientSubsampling);
+}
+
+void QualityController::adjust(unsigned sendTime, unsigned encodeTime,
+                               int frameTime)
+{
+  int oldCompress, oldQuality, oldSubsampling;
+
+  oldCompress = getCompressLevel();
+  oldQuality = getQualityLevel();
+  oldSubsampling = getSubsampling();
+
+  // Only one step at a time, so that we can see the effect before
+  // going any further
+  if (sendTime > (unsigned)frameTime) {
+    // The link can't keep up, so we need to send less. More effort
+    // on compression is preferred as long as there is time for it,
+    // as it doesn't affect the quality.
+    if (canRaiseCompression() && (encodeTime < (unsigned)frameTime / 2))
+      compressOffset++;
+    else if (canLowerQuality())
+      qualityDrop++;
+    else if (canSubsample())
+      subsampled = true;
+  } else if (encodeTime > (unsigned)frameTime / 2) {
+    // Plenty of bandwidth, but we are spending too much time on
+    // compression
+    if (canLowerCompression())
+      compressOffset--;
+  } else if ((sendTime < (unsigned)frameTime / 4) &&
+             (encodeTime < (unsigned)frameTime / 4)) {
+    // Lots of headroom, so go back towards what the client asked for,
+    // undoing the most noticeable changes first
+    if (subsampled)
+      subsampled = false;
+    else if (qualityDrop > 0)
+      qualityDrop--;
+    else if (compressOffset > 0)
+      compressOffset--;
+    else if (compressOffset < 0)
+      compressOffset++;
+  }
+
+  if ((getCompressLevel() != oldCompress) ||
+      (getQualityLevel() != oldQuality) ||
+      (getSubsampling() != oldSubsampling))
+    vlog.debug("Adjusted to compression %d, quality %d, subsampling %d "
+               "(send %u ms, encode %u ms, frame %d ms)",
+               getCompressLevel(), getQualityLevel(), getSubsampling(),
+               sendTime, encodeTime, frameTime);
+}
+
+bool QualityController::canRaiseCompression() const
+{
+  if (clientCompressLevel == -1)
+    return false;
+
+  return (compressOffset < MaxCompressOffset) &&
+         (clientCompressLevel + compressOffset < 9);
+}
+
+bool QualityController::canLowerCompression() const
+{
+  if (clientCompressLevel == -1)
+    return false;
+
+  return (compressOffset > -MaxCompressOffset) &&
+         (clientCompressLevel + compressOffset > 0);
+}
+
+bool QualityController::canLowerQuality() const
+{
+  if ((clientQualityLevel == -1) && (clientFineQualityLevel == -1))
+    return false;
+
+  if (qualityDrop >= MaxQualityDrop)
+    return false;
+
+  if ((clientQualityLevel != -1) && (getQualityLevel() == 0))
+    return false;
+  if ((clientFineQualityLevel != -1) && (getFineQualityLevel() == 1))
+    return false;
+
+  return true;
+}
+
+bool QualityController::canSubsample() const
+{
+  if (subsampled)
+    return false;
+
+  return (clientSubsampling == subsampleNone) ||
+         (clientSubsampling == subsample2X);
+}
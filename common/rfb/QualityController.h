@@ -0,0 +1,91 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// QualityController adjusts the compression level and image quality
+// for a client based on how long updates take to encode and to send.
+// The client's settings are the starting point, and the quality is
+// never raised above what the client asked for.
+//
+
+#ifndef __RFB_QUALITYCONTROLLER_H__
+#define __RFB_QUALITYCONTROLLER_H__
+
+#include <stddef.h>
+#include <sys/time.h>
+
+namespace rfb {
+
+  class QualityController {
+  public:
+    QualityController();
+    ~QualityController();
+
+    // setClientSettings() sets what the client has asked for. Any
+    // adjustments are discarded if this differs from before.
+    void setClientSettings(int compressLevel, int qualityLevel,
+                           int fineQualityLevel, int subsampling);
+
+    // setNetwork() sets the current estimates for the connection, with
+    // the bandwidth in bytes per second and the round trip time in
+    // milliseconds, or -1 if it isn't known
+    void setNetwork(size_t bandwidth, int rtt);
+
+    // update() records an update of the given size that took
+    // encodeTime microseconds to encode. frameTime is how many
+    // milliseconds there are for each update.
+    void update(size_t bytes, unsigned encodeTime, int frameTime,
+                const struct timeval* now);
+
+    // Settings that should currently be used
+    int getCompressLevel() const;
+    int getQualityLevel() const;
+    int getFineQualityLevel() const;
+    int getSubsampling() const;
+
+    // isAdjusted() returns true if the settings currently differ from
+    // what the client asked for
+    bool isAdjusted() const;
+
+  private:
+    void adjust(unsigned sendTime, unsigned encodeTime, int frameTime);
+
+    bool canRaiseCompression() const;
+    bool canLowerCompression() const;
+    bool canLowerQuality() const;
+    bool canSubsample() const;
+
+    int clientCompressLevel, clientQualityLevel;
+    int clientFineQualityLevel, clientSubsampling;
+
+    int compressOffset;
+    int qualityDrop;
+    bool subsampled;
+
+    size_t bandwidth;
+    int rtt;
+
+    struct timeval periodStart;
+    unsigned periodUpdates;
+    size_t periodBytes;
+    unsigned long long periodEncodeTime;
+  };
+
+}
+
+#endif
@@ -0,0 +1,240 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sys/time.h>
+
+#include <algorithm>
+#include <bitset>
+
+#include <rfb/RegionClassifier.h>
+
+using namespace rfb;
+
+// Size of each tile, in pixels
+static const int TileSize = 64;
+
+// Length of each time slot, in milliseconds
+static const int SlotLength = 100;
+
+// A tile is video if most of it was replaced in this many of the
+// slots covered by VideoMask, i.e. at least 6 fps for 1.6 seconds
+static const uint32_t VideoMask = 0xffff;
+static const size_t VideoMinSlots = 10;
+
+// A tile is static if it wasn't touched in any of the slots covered
+// by StaticMask, i.e. the last 3 seconds not counting the current slot
+static const uint32_t StaticMask = 0x7ffffffe;
+
+// A tile is scrolling if anything was copied to it in any of the
+// slots covered by ScrollMask, i.e. the last second
+static const uint32_t ScrollMask = 0x3ff;
+
+RegionClassifier::RegionClassifier()
+  : width(0), height(0), tileColumns(0), tileRows(0), lastSlot(0)
+{
+}
+
+RegionClassifier::~RegionClassifier()
+{
+}
+
+void RegionClassifier::setSize(int width_, int height_)
+{
+  if ((width_ == width) && (height_ == height))
+    return;
+
+  width = width_;
+  height = height_;
+
+  tileColumns = (width + TileSize - 1) / TileSize;
+  tileRows = (height + TileSize - 1) / TileSize;
+
+  tiles.assign(tileColumns * tileRows, {0, 0, 0});
+  coverage.assign(tileColumns * tileRows, 0);
+}
+
+void RegionClassifier::update(const core::Region& changed,
+                              const core::Region& copied,
+                              const struct timeval* now)
+{
+  std::vector<core::Rect> rects;
+  std::vector<core::Rect>::iterator i;
+
+  advance(slotAt(now));
+
+  // Small changes, like text being typed, shouldn't be mistaken for
+  // video, so we need to know how much of each tile was replaced
+  changed.get_rects(&rects);
+  for (i = rects.begin(); i != rects.end(); i++) {
+    core::Rect r;
+
+    r = i->intersect({0, 0, width, height});
+    if (r.is_empty())
+      continue;
+
+    for (int y = r.tl.y / TileSize; y <= (r.br.y - 1) / TileSize; y++) {
+      for (int x = r.tl.x / TileSize; x <= (r.br.x - 1) / TileSize; x++) {
+        int index;
+
+        index = y * tileColumns + x;
+        coverage[index] += r.intersect(tileRect(index)).area();
+      }
+    }
+  }
+
+  for (size_t index = 0; index < tiles.size(); index++) {
+    if (coverage[index] == 0)
+      continue;
+
+    tiles[index].touched |= 1;
+    if (coverage[index] * 2 >= tileRect(index).area())
+      tiles[index].replaced |= 1;
+
+    coverage[index] = 0;
+  }
+
+  // The area uncovered by scrolling will be next to where things
+  // were copied, so include the surrounding tiles
+  copied.get_rects(&rects);
+  for (i = rects.begin(); i != rects.end(); i++) {
+    core::Rect r;
+
+    r = {i->tl.x - TileSize, i->tl.y - TileSize,
+         i->br.x + TileSize, i->br.y + TileSize};
+    r = r.intersect({0, 0, width, height});
+    if (r.is_empty())
+      continue;
+
+    for (int y = r.tl.y / TileSize; y <= (r.br.y - 1) / TileSize; y++) {
+      for (int x = r.tl.x / TileSize; x <= (r.br.x - 1) / TileSize; x++)
+        tiles[y * tileColumns + x].copied |= 1;
+    }
+  }
+}
+
+core::Region RegionClassifier::getRegion(ContentClass type,
+                                         const struct timeval* now) const
+{
+  core::Region region;
+  uint64_t slot;
+  unsigned age;
+
+  slot = slotAt(now);
+  if (slot < lastSlot)
+    age = 0;
+  else if ((slot - lastSlot) > 32)
+    age = 32;
+  else
+    age = slot - lastSlot;
+
+  // Collect runs of tiles on each row to keep the number of region
+  // operations down
+  for (int y = 0; y < tileRows; y++) {
+    int start;
+
+    start = -1;
+    for (int x = 0; x <= tileColumns; x++) {
+      bool match;
+
+      match = false;
+      if (x < tileColumns)
+        match = classify(tiles[y * tileColumns + x], age) == type;
+
+      if (match && (start == -1)) {
+        start = x;
+      } else if (!match && (start != -1)) {
+        region.assign_union({{start * TileSize, y * TileSize,
+                              std::min(x * TileSize, width),
+                              std::min((y + 1) * TileSize, height)}});
+        start = -1;
+      }
+    }
+  }
+
+  return region;
+}
+
+uint64_t RegionClassifier::slotAt(const struct timeval* now)
+{
+  return ((uint64_t)now->tv_sec * 1000 + now->tv_usec / 1000) / SlotLength;
+}
+
+void RegionClassifier::advance(uint64_t slot)
+{
+  uint64_t age;
+
+  // Time going backwards, so just keep adding to the current slot
+  if (slot <= lastSlot)
+    return;
+
+  age = slot - lastSlot;
+  lastSlot = slot;
+
+  for (TileHistory& tile : tiles) {
+    if (age >= 32) {
+      tile = {0, 0, 0};
+      continue;
+    }
+
+    tile.touched <<= age;
+    tile.replaced <<= age;
+    tile.copied <<= age;
+  }
+}
+
+ContentClass RegionClassifier::classify(const TileHistory& tile,
+                                        unsigned age) const
+{
+  uint32_t touched, replaced, copied;
+
+  if (age >= 32) {
+    touched = replaced = copied = 0;
+  } else {
+    touched = tile.touched << age;
+    replaced = tile.replaced << age;
+    copied = tile.copied << age;
+  }
+
+  // Scrolling replaces a lot, so check that first
+  if (copied & ScrollMask)
+    return contentScrolling;
+
+  if (std::bitset<32>(replaced & VideoMask).count() >= VideoMinSlots)
+    return contentVideo;
+
+  if ((touched & StaticMask) == 0)
+    return contentStatic;
+
+  return contentActive;
+}
+
+core::Rect RegionClassifier::tileRect(int index) const
+{
+  core::Rect r;
+
+  r.tl.x = index % tileColumns * TileSize;
+  r.tl.y = index / tileColumns * TileSize;
+  r.br.x = r.tl.x + TileSize;
+  r.br.y = r.tl.y + TileSize;
+
+  return r.intersect({0, 0, width, height});
+}
@@ -0,0 +1,90 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// RegionClassifier keeps track of how often each part of the screen
+// changes, in order to guess what kind of content is there. This
+// allows picking an encoder without having to analyse every rect.
+//
+
+#ifndef __RFB_REGIONCLASSIFIER_H__
+#define __RFB_REGIONCLASSIFIER_H__
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <core/Region.h>
+
+struct timeval;
+
+namespace rfb {
+
+  enum ContentClass {
+    // Hasn't changed in a while, e.g. a document being read
+    contentStatic,
+    // Changes now and then, e.g. text being typed
+    contentActive,
+    // Recently moved using CopyRect, e.g. a page being scrolled
+    contentScrolling,
+    // Mostly replaced many times per second, e.g. a video
+    contentVideo,
+  };
+
+  class RegionClassifier {
+  public:
+    RegionClassifier();
+    ~RegionClassifier();
+
+    // setSize() must be called when the framebuffer changes size. All
+    // history is lost if the size is different from before.
+    void setSize(int width, int height);
+
+    // update() records the changes of an update sent at the given time
+    void update(const core::Region& changed, const core::Region& copied,
+                const struct timeval* now);
+
+    // getRegion() returns the areas that currently have the given class
+    core::Region getRegion(ContentClass type,
+                           const struct timeval* now) const;
+
+  private:
+    struct TileHistory {
+      // One bit per time slot, with the current slot in the lowest bit
+      uint32_t touched;
+      uint32_t replaced;
+      uint32_t copied;
+    };
+
+    static uint64_t slotAt(const struct timeval* now);
+    void advance(uint64_t slot);
+    ContentClass classify(const TileHistory& tile, unsigned age) const;
+
+    core::Rect tileRect(int index) const;
+
+    int width, height;
+    int tileColumns, tileRows;
+
+    uint64_t lastSlot;
+    std::vector<TileHistory> tiles;
+    std::vector<int> coverage;
+  };
+
+}
+
+#endif
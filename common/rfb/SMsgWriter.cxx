@@ -417,6 +417,24 @@ void SMsgWriter::writeCopyRect(const core::Rect& r, int srcX, int srcY)
   endRect();
 }
 
+void SMsgWriter::writeCachedTile(const core::Rect& r, uint64_t hash)
+{
+  startRect(r, pseudoEncodingTileCache);
+  os->writeU8(0);
+  os->writeU32(hash >> 32);
+  os->writeU32(hash);
+  endRect();
+}
+
+void SMsgWriter::writeStoreTile(const core::Rect& r, uint64_t hash)
+{
+  startRect(r, pseudoEncodingTileCache);
+  os->writeU8(1);
+  os->writeU32(hash >> 32);
+  os->writeU32(hash);
+  endRect();
+}
+
 void SMsgWriter::startRect(const core::Rect& r, int encoding)
 {
   if (++nRectsInUpdate > nRectsInHeader && nRectsInHeader)
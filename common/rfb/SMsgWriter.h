@@ -118,6 +118,12 @@ namespace rfb {
     // There is no explicit encoder for CopyRect rects.
     void writeCopyRect(const core::Rect& r, int srcX, int srcY);
 
+    // Nor for the tile cache. writeCachedTile() draws a tile that the
+    // client already has, and writeStoreTile() makes the client save
+    // what it currently has in the rect.
+    void writeCachedTile(const core::Rect& r, uint64_t hash);
+    void writeStoreTile(const core::Rect& r, uint64_t hash);
+
     // Encoders should call these to mark the start and stop of individual
     // rects.
     void startRect(const core::Rect& r, int enc);
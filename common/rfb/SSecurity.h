@@ -40,6 +40,9 @@
 // getType() should return the secType value corresponding to the SSecurity
 // implementation.
 //
+// allowLargeMessages() is called once the client has said that it can
+// receive larger messages than the security type normally sends.
+//
 
 #ifndef __RFB_SSECURITY_H__
 #define __RFB_SSECURITY_H__
@@ -65,6 +68,8 @@ namespace rfb {
 
     virtual AccessRights getAccessRights() const { return AccessDefault; }
 
+    virtual void allowLargeMessages() {}
+
   protected:
     SConnection* sc;
   };
@@ -671,6 +671,12 @@ void SSecurityRSAAES::verifyPass()
   throw auth_error(_("Authentication failed"));
 }
 
+void SSecurityRSAAES::allowLargeMessages()
+{
+  if (raos)
+    raos->setMaxMessageSize(rdr::AESOutStream::MaxMessageSize);
+}
+
 const char* SSecurityRSAAES::getUserName() const
 {
   return username;
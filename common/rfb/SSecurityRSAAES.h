@@ -53,6 +53,7 @@ namespace rfb {
     {
       return accessRights;
     }
+    void allowLargeMessages() override;
 
     static core::StringParameter keyFile;
     static core::BoolParameter requireUsername;
@@ -72,6 +72,12 @@ core::StringParameter SSecurityTLS::X509_KeyFile(
   _("Path to the private key of the server's X.509 certificate"),
   "");
 
+core::BoolParameter SSecurityTLS::KernelTLS(
+  "KernelTLS",
+  _("Let the kernel handle the encryption once a TLS connection has "
+    "been set up (Linux only)"),
+  false);
+
 static core::LogWriter vlog("TLS");
 
 SSecurityTLS::SSecurityTLS(SConnection* sc_, bool _anon)
@@ -185,6 +191,9 @@ bool SSecurityTLS::processMsg()
   vlog.debug("TLS handshake completed with %s",
              gnutls_session_get_desc(session));
 
+  if (KernelTLS)
+    tlssock->enableKernelTLS();
+
   sc->setStreams(&tlssock->inStream(), &tlssock->outStream());
 
   return true;
@@ -57,6 +57,7 @@ namespace rfb {
 
     static core::StringParameter X509_CertFile;
     static core::StringParameter X509_KeyFile;
+    static core::BoolParameter KernelTLS;
 
   protected:
     void shutdown();
@@ -0,0 +1,228 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+#include <rfb/BlockCompare.h>
+#include <rfb/PixelBuffer.h>
+#include <rfb/ScrollDetector.h>
+
+using namespace rfb;
+
+// Anything smaller than this isn't worth the effort
+static const int MinScrollSize = 64;
+
+// How many unique lines must agree on the distance before we trust it
+static const int MinVotes = 8;
+
+// Columns are expensive to hash, so only every few rows are included.
+// A bad guess only costs some bandwidth, as everything is compared
+// again after the copy.
+static const int ColumnSampling = 4;
+
+template<class T>
+static void hashColumnData(const T* data, int stride,
+                           int width, int height, uint64_t* hashes)
+{
+  // FNV-1a, but one pixel at a time rather than one byte
+  for (int x = 0; x < width; x++)
+    hashes[x] = 0xcbf29ce484222325ULL;
+
+  for (int y = 0; y < height; y += ColumnSampling) {
+    for (int x = 0; x < width; x++)
+      hashes[x] = (hashes[x] ^ data[x]) * 0x100000001b3ULL;
+    data += stride * ColumnSampling;
+  }
+}
+
+ScrollDetector::ScrollDetector()
+{
+}
+
+ScrollDetector::~ScrollDetector()
+{
+}
+
+bool ScrollDetector::detect(const PixelBuffer* oldFb,
+                            const PixelBuffer* newFb,
+                            const core::Rect& rect,
+                            core::Rect* dest, core::Point* delta)
+{
+  int shift, start, end;
+
+  assert(oldFb->getPF() == newFb->getPF());
+  assert(rect.enclosed_by(oldFb->getRect()));
+  assert(rect.enclosed_by(newFb->getRect()));
+
+  if ((rect.width() < MinScrollSize) || (rect.height() < MinScrollSize))
+    return false;
+
+  // Vertical scrolling is by far the most common, so check that first
+
+  hashRows(oldFb, rect, &oldHashes);
+  hashRows(newFb, rect, &newHashes);
+
+  if (findShift(&shift, &start, &end)) {
+    *dest = {rect.tl.x, rect.tl.y + start, rect.br.x, rect.tl.y + end};
+    *delta = {0, shift};
+    return true;
+  }
+
+  hashColumns(oldFb, rect, &oldHashes);
+  hashColumns(newFb, rect, &newHashes);
+
+  if (findShift(&shift, &start, &end)) {
+    *dest = {rect.tl.x + start, rect.tl.y, rect.tl.x + end, rect.br.y};
+    *delta = {shift, 0};
+    return true;
+  }
+
+  return false;
+}
+
+void ScrollDetector::hashRows(const PixelBuffer* pb,
+                              const core::Rect& rect,
+                              std::vector<uint64_t>* hashes)
+{
+  const uint8_t* data;
+  int stride, bytesPerPixel;
+
+  data = pb->getBuffer(rect, &stride);
+  bytesPerPixel = pb->getPF().bpp/8;
+
+  hashes->resize(rect.height());
+  for (int y = 0; y < rect.height(); y++) {
+    (*hashes)[y] = hashBlock(data, stride * bytesPerPixel,
+                             rect.width() * bytesPerPixel, 1);
+    data += stride * bytesPerPixel;
+  }
+}
+
+void ScrollDetector::hashColumns(const PixelBuffer* pb,
+                                 const core::Rect& rect,
+                                 std::vector<uint64_t>* hashes)
+{
+  const uint8_t* data;
+  int stride;
+
+  data = pb->getBuffer(rect, &stride);
+
+  hashes->resize(rect.width());
+
+  switch (pb->getPF().bpp) {
+  case 32:
+    hashColumnData((const uint32_t*)data, stride,
+                   rect.width(), rect.height(), hashes->data());
+    break;
+  case 16:
+    hashColumnData((const uint16_t*)data, stride,
+                   rect.width(), rect.height(), hashes->data());
+    break;
+  default:
+    hashColumnData((const uint8_t*)data, stride,
+                   rect.width(), rect.height(), hashes->data());
+  }
+}
+
+bool ScrollDetector::findShift(int* shift, int* start, int* end)
+{
+  std::unordered_map<uint64_t, int> lines;
+  std::map<int, int> votes;
+  int count, bestShift, bestVotes, first, last;
+
+  assert(oldHashes.size() == newHashes.size());
+
+  count = oldHashes.size();
+
+  // Only lines that are unique can tell us where they came from, so
+  // any repeated ones are marked as such
+  for (int i = 0; i < count; i++) {
+    std::unordered_map<uint64_t, int>::iterator iter;
+
+    iter = lines.find(oldHashes[i]);
+    if (iter == lines.end())
+      lines[oldHashes[i]] = i;
+    else
+      iter->second = -1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    std::unordered_map<uint64_t, int>::iterator iter;
+
+    if (newHashes[i] == oldHashes[i])
+      continue;
+
+    iter = lines.find(newHashes[i]);
+    if ((iter == lines.end()) || (iter->second == -1))
+      continue;
+
+    votes[i - iter->second]++;
+  }
+
+  bestShift = 0;
+  bestVotes = 0;
+  for (const std::pair<const int, int>& vote : votes) {
+    if (vote.second > bestVotes) {
+      bestShift = vote.first;
+      bestVotes = vote.second;
+    }
+  }
+
+  if (bestVotes < MinVotes)
+    return false;
+
+  // Repeated lines (e.g. empty space) also move, so find the longest
+  // stretch where everything matches with this distance
+  first = std::max(0, bestShift);
+  last = count + std::min(0, bestShift);
+
+  *start = *end = 0;
+  for (int i = first; i < last; i++) {
+    int j;
+
+    if (newHashes[i] != oldHashes[i - bestShift])
+      continue;
+
+    for (j = i + 1; j < last; j++) {
+      if (newHashes[j] != oldHashes[j - bestShift])
+        break;
+    }
+
+    if ((j - i) > (*end - *start)) {
+      *start = i;
+      *end = j;
+    }
+
+    i = j;
+  }
+
+  if ((*end - *start) < MinScrollSize)
+    return false;
+
+  *shift = bestShift;
+
+  return true;
+}
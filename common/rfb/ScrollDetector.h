@@ -0,0 +1,65 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// ScrollDetector tries to find content that has moved between two
+// versions of the framebuffer, for when there are no hints about
+// CopyRect from the system. It compares hashes of each row (or
+// column) to find the most likely distance things have moved.
+//
+
+#ifndef __RFB_SCROLLDETECTOR_H__
+#define __RFB_SCROLLDETECTOR_H__
+
+#include <stdint.h>
+
+#include <vector>
+
+#include <core/Rect.h>
+
+namespace rfb {
+
+  class PixelBuffer;
+
+  class ScrollDetector {
+  public:
+    ScrollDetector();
+    ~ScrollDetector();
+
+    // detect() looks for content inside rect that has moved from
+    // oldFb to newFb. Returns true if a large enough area was found,
+    // in which case dest is where it ended up and delta is how far it
+    // moved. Both buffers must have the same size and pixel format.
+    bool detect(const PixelBuffer* oldFb, const PixelBuffer* newFb,
+                const core::Rect& rect,
+                core::Rect* dest, core::Point* delta);
+
+  private:
+    void hashRows(const PixelBuffer* pb, const core::Rect& rect,
+                  std::vector<uint64_t>* hashes);
+    void hashColumns(const PixelBuffer* pb, const core::Rect& rect,
+                     std::vector<uint64_t>* hashes);
+
+    bool findShift(int* shift, int* start, int* end);
+
+    std::vector<uint64_t> oldHashes, newHashes;
+  };
+
+}
+
+#endif
@@ -27,6 +27,7 @@
 #include <list>
 
 namespace core {
+  class BoolParameter;
   class EnumListParameter;
   class StringParameter;
 }
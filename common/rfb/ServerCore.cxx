@@ -56,10 +56,60 @@ core::IntParameter rfb::Server::compareFB
  _("Perform pixel comparison on framebuffer to reduce unnecessary "
    "updates (0: never, 1: always, 2: auto)"),
  2, 0, 2);
+core::EnumParameter rfb::Server::compareMethod
+("CompareMethod",
+ _("How to detect unchanged areas when comparing the framebuffer "
+   "(Copy: keep a full copy, Hash: keep a hash of each tile)"),
+ {"Copy", "Hash"}, "Copy");
+core::IntParameter rfb::Server::compareThreads
+("CompareThreads",
+ _("The maximum number of threads used to compare each update "
+   "(0 or 1 disables threaded comparison)"),
+ 4, 0, INT_MAX);
+core::BoolParameter rfb::Server::detectScroll
+("DetectScroll",
+ _("Look for scrolled content when comparing the framebuffer, so that "
+   "it can be sent as a copy (only with CompareMethod=Copy)"),
+ false);
+core::IntParameter rfb::Server::coalesceRects
+("CoalesceRects",
+ _("Merge nearby changes into larger rects once an update has more "
+   "than this many rects (0 disables merging)"),
+ 256, 0, INT_MAX);
+core::IntParameter rfb::Server::coalesceArea
+("CoalesceArea",
+ _("The largest rect, in pixels, that nearby changes may be merged "
+   "into"),
+ 65536, 0, INT_MAX);
 core::IntParameter rfb::Server::frameRate
 ("FrameRate",
  _("The maximum number of updates per second sent to each client"),
  60, 0, INT_MAX);
+core::IntParameter rfb::Server::encodeThreads
+("EncodeThreads",
+ _("The maximum number of threads used to encode each update to a "
+   "client (0 or 1 disables threaded encoding)"),
+ 1, 0, INT_MAX);
+core::BoolParameter rfb::Server::adaptiveQuality
+("AdaptiveQuality",
+ _("Lower the compression level and image quality used for a client "
+   "when updates can't be encoded or sent fast enough"),
+ false);
+core::IntParameter rfb::Server::h264Bitrate
+("H264Bitrate",
+ _("The target bitrate in kbit/s for each area encoded using H.264 "
+   "(0 means a constant quality based on the client's quality level)"),
+ 0, 0, INT_MAX);
+core::BoolParameter rfb::Server::zeroCopy
+("ZeroCopy",
+ _("Let the kernel send large updates shared between clients without "
+   "copying them (Linux only)"),
+ false);
+core::EnumParameter rfb::Server::zlibImpl
+("ZlibImpl",
+ _("Which zlib implementation to compress updates with (Auto picks "
+   "the fastest one available)"),
+ {"Auto", "zlib", "zlib-ng"}, "Auto");
 core::BoolParameter rfb::Server::protocol3_3
 ("Protocol3.3",
  _("Always use protocol version 3.3 for backwards compatibility with "
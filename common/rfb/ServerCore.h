@@ -36,7 +36,17 @@ namespace rfb {
     static core::IntParameter maxConnectionTime;
     static core::IntParameter maxIdleTime;
     static core::IntParameter compareFB;
+    static core::EnumParameter compareMethod;
+    static core::IntParameter compareThreads;
+    static core::BoolParameter detectScroll;
+    static core::IntParameter coalesceRects;
+    static core::IntParameter coalesceArea;
     static core::IntParameter frameRate;
+    static core::IntParameter encodeThreads;
+    static core::BoolParameter adaptiveQuality;
+    static core::IntParameter h264Bitrate;
+    static core::BoolParameter zeroCopy;
+    static core::EnumParameter zlibImpl;
     static core::BoolParameter protocol3_3;
     static core::BoolParameter alwaysShared;
     static core::BoolParameter neverShared;
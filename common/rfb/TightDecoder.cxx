@@ -24,7 +24,9 @@
 #endif
 
 #include <assert.h>
+#include <string.h>
 
+#include <algorithm>
 #include <vector>
 
 #include <core/i18n.h>
@@ -40,6 +42,7 @@
 #include <rfb/PixelBuffer.h>
 #include <rfb/TightConstants.h>
 #include <rfb/TightDecoder.h>
+#include <rfb/TightFilter.h>
 
 using namespace rfb;
 
@@ -435,89 +438,66 @@ void TightDecoder::decodeRect(const core::Rect& r, const uint8_t* buffer,
   }
 
   // Time to decode the actual data
-  bool directDecode;
+  const PixelFormat& dstPF = pb->getPF();
 
   uint8_t* outbuf;
   int stride;
 
-  if (pb->getPF() == pf) {
-    // Decode directly into the framebuffer (fast path)
-    directDecode = true;
-  } else {
-    // Decode into an intermediate buffer and use pixel translation
-    directDecode = false;
-  }
-
-  if (directDecode)
-    outbuf = pb->getBufferRW(r, &stride);
-  else {
-    outbuf = new uint8_t[r.area() * (pf.bpp/8)];
-    stride = r.width();
-  }
-
   if (palSize == 0) {
     // Truecolor data
     if (useGradient) {
+      // The filter works on RGB values, so the result can be converted
+      // straight in to the framebuffer
+      outbuf = pb->getBufferRW(r, &stride);
       if (pf.is888())
-        FilterGradient24(bufptr, pf, (uint32_t*)outbuf, stride, r);
-      else {
-        switch (pf.bpp) {
-        case 8:
-          assert(false);
-          break;
-        case 16:
-          FilterGradient(bufptr, pf, (uint16_t*)outbuf, stride, r);
-          break;
-        case 32:
-          FilterGradient(bufptr, pf, (uint32_t*)outbuf, stride, r);
-          break;
-        }
-      }
-    } else {
+        FilterGradient24(bufptr, dstPF, outbuf, stride, r);
+      else
+        FilterGradient(bufptr, pf, dstPF, outbuf, stride, r);
+      pb->commitBufferRW(r);
+    } else if (pf.is888()) {
       // Copy
-      uint8_t* ptr = outbuf;
+      uint8_t* ptr;
       const uint8_t* srcPtr = bufptr;
       int w = r.width();
       int h = r.height();
-      if (pf.is888()) {
-        while (h > 0) {
-          pf.bufferFromRGB(ptr, srcPtr, w);
-          ptr += stride * pf.bpp/8;
-          srcPtr += w * 3;
-          h--;
-        }
-      } else {
-        while (h > 0) {
-          memcpy(ptr, srcPtr, w * pf.bpp/8);
-          ptr += stride * pf.bpp/8;
-          srcPtr += w * pf.bpp/8;
-          h--;
-        }
+
+      ptr = pb->getBufferRW(r, &stride);
+      while (h > 0) {
+        dstPF.bufferFromRGB(ptr, srcPtr, w);
+        ptr += stride * dstPF.bpp/8;
+        srcPtr += w * 3;
+        h--;
       }
+      pb->commitBufferRW(r);
+    } else {
+      // Copy
+      pb->imageRect(pf, r, bufptr);
     }
   } else {
     // Indexed color
-    switch (pf.bpp) {
+    uint8_t dstPalette[256 * 4];
+
+    // Convert the palette rather than every pixel, so that the
+    // pixels can be written straight in to the framebuffer
+    memset(dstPalette, 0, sizeof(dstPalette));
+    dstPF.bufferFromBuffer(dstPalette, pf, palette, palSize);
+
+    outbuf = pb->getBufferRW(r, &stride);
+    switch (dstPF.bpp) {
     case 8:
-      FilterPalette((const uint8_t*)palette, palSize,
+      FilterPalette((const uint8_t*)dstPalette, palSize,
                     bufptr, (uint8_t*)outbuf, stride, r);
       break;
     case 16:
-      FilterPalette((const uint16_t*)palette, palSize,
+      FilterPalette((const uint16_t*)dstPalette, palSize,
                     bufptr, (uint16_t*)outbuf, stride, r);
       break;
     case 32:
-      FilterPalette((const uint32_t*)palette, palSize,
+      FilterPalette((const uint32_t*)dstPalette, palSize,
                     bufptr, (uint32_t*)outbuf, stride, r);
       break;
     }
-  }
-
-  if (directDecode)
     pb->commitBufferRW(r);
-  else {
-    pb->imageRect(pf, r, outbuf);
-    delete [] outbuf;
   }
 
   delete [] netbuf;
@@ -544,101 +524,58 @@ uint32_t TightDecoder::readCompact(rdr::InStream* is)
 
 void
 TightDecoder::FilterGradient24(const uint8_t *inbuf,
-                               const PixelFormat& pf, uint32_t* outbuf,
+                               const PixelFormat& pf, uint8_t* outbuf,
                                int stride, const core::Rect& r)
 {
-  int x, y, c;
-  uint8_t prevRow[TIGHT_MAX_WIDTH*3];
-  uint8_t thisRow[TIGHT_MAX_WIDTH*3];
-  uint8_t pix[3]; 
-  int est[3]; 
-
-  memset(prevRow, 0, sizeof(prevRow));
+  int y;
+  uint8_t rows[2][TIGHT_MAX_WIDTH*3];
+  uint8_t *prevRow, *thisRow;
 
   // Set up shortcut variables
   int rectHeight = r.height();
   int rectWidth = r.width();
 
-  for (y = 0; y < rectHeight; y++) {
-    for (x = 0; x < rectWidth; x++) {
-      /* First pixel in a row */
-      if (x == 0) {
-        for (c = 0; c < 3; c++) {
-          pix[c] = inbuf[y*rectWidth*3+c] + prevRow[c];
-          thisRow[c] = pix[c];
-        }
-        pf.bufferFromRGB((uint8_t*)&outbuf[y*stride], pix, 1);
-        continue;
-      }
+  prevRow = rows[0];
+  thisRow = rows[1];
 
-      for (c = 0; c < 3; c++) {
-        est[c] = prevRow[x*3+c] + pix[c] - prevRow[(x-1)*3+c];
-        if (est[c] > 0xff) {
-          est[c] = 0xff;
-        } else if (est[c] < 0) {
-          est[c] = 0;
-        }
-        pix[c] = inbuf[(y*rectWidth+x)*3+c] + est[c];
-        thisRow[x*3+c] = pix[c];
-      }
-      pf.bufferFromRGB((uint8_t*)&outbuf[y*stride+x], pix, 1);
-    }
+  memset(prevRow, 0, rectWidth*3);
+
+  for (y = 0; y < rectHeight; y++) {
+    decodeGradientRow(&inbuf[y*rectWidth*3], prevRow, thisRow, rectWidth);
+    pf.bufferFromRGB(&outbuf[y*stride*(pf.bpp/8)], thisRow, rectWidth);
 
-    memcpy(prevRow, thisRow, sizeof(prevRow));
+    std::swap(prevRow, thisRow);
   }
 }
 
-template<class T>
 void TightDecoder::FilterGradient(const uint8_t* inbuf,
-                                  const PixelFormat& pf, T* outbuf,
-                                  int stride, const core::Rect& r)
+                                  const PixelFormat& srcPF,
+                                  const PixelFormat& dstPF,
+                                  uint8_t* outbuf, int stride,
+                                  const core::Rect& r)
 {
-  int x, y, c;
-  static uint8_t prevRow[TIGHT_MAX_WIDTH*3];
-  static uint8_t thisRow[TIGHT_MAX_WIDTH*3];
-  uint8_t pix[3]; 
-  int est[3]; 
-
-  memset(prevRow, 0, sizeof(prevRow));
+  int y;
+  uint8_t diffRow[TIGHT_MAX_WIDTH*3];
+  uint8_t rows[2][TIGHT_MAX_WIDTH*3];
+  uint8_t *prevRow, *thisRow;
 
   // Set up shortcut variables
   int rectHeight = r.height();
   int rectWidth = r.width();
 
-  for (y = 0; y < rectHeight; y++) {
-    for (x = 0; x < rectWidth; x++) {
-      /* First pixel in a row */
-      if (x == 0) {
-        pf.rgbFromBuffer(pix, &inbuf[y*rectWidth], 1);
-        for (c = 0; c < 3; c++)
-          pix[c] += prevRow[c];
-
-        memcpy(thisRow, pix, sizeof(pix));
-
-        pf.bufferFromRGB((uint8_t*)&outbuf[y*stride], pix, 1);
+  prevRow = rows[0];
+  thisRow = rows[1];
 
-        continue;
-      }
-
-      for (c = 0; c < 3; c++) {
-        est[c] = prevRow[x*3+c] + pix[c] - prevRow[(x-1)*3+c];
-        if (est[c] > 255) {
-          est[c] = 255;
-        } else if (est[c] < 0) {
-          est[c] = 0;
-        }
-      }
+  memset(prevRow, 0, rectWidth*3);
 
-      pf.rgbFromBuffer(pix, &inbuf[y*rectWidth+x], 1);
-      for (c = 0; c < 3; c++)
-        pix[c] += est[c];
-
-      memcpy(&thisRow[x*3], pix, sizeof(pix));
-
-      pf.bufferFromRGB((uint8_t*)&outbuf[y*stride+x], pix, 1);
-    }
+  for (y = 0; y < rectHeight; y++) {
+    srcPF.rgbFromBuffer(diffRow, &inbuf[y*rectWidth*(srcPF.bpp/8)],
+                        rectWidth);
+    decodeGradientRow(diffRow, prevRow, thisRow, rectWidth);
+    dstPF.bufferFromRGB(&outbuf[y*stride*(dstPF.bpp/8)], thisRow,
+                        rectWidth);
 
-    memcpy(prevRow, thisRow, sizeof(prevRow));
+    std::swap(prevRow, thisRow);
   }
 }
 
@@ -647,37 +584,22 @@ void TightDecoder::FilterPalette(const T* palette, int palSize,
                                  const uint8_t* inbuf, T* outbuf,
                                  int stride, const core::Rect& r)
 {
-  // Indexed color
-  int x, h = r.height(), w = r.width(), b, pad = stride - w;
-  T* ptr = outbuf;
-  uint8_t bits;
-  const uint8_t* srcPtr = inbuf;
+  int h = r.height(), w = r.width();
+
   if (palSize <= 2) {
     // 2-color palette
     while (h > 0) {
-      for (x = 0; x < w / 8; x++) {
-        bits = *srcPtr++;
-        for (b = 7; b >= 0; b--) {
-          *ptr++ = palette[bits >> b & 1];
-        }
-      }
-      if (w % 8 != 0) {
-        bits = *srcPtr++;
-        for (b = 7; b >= 8 - w % 8; b--) {
-          *ptr++ = palette[bits >> b & 1];
-        }
-      }
-      ptr += pad;
+      expandMonoRow(inbuf, palette, outbuf, w);
+      inbuf += (w + 7) / 8;
+      outbuf += stride;
       h--;
     }
   } else {
     // 256-color palette
     while (h > 0) {
-      T *endOfRow = ptr + w;
-      while (ptr < endOfRow) {
-        *ptr++ = palette[*srcPtr++];
-      }
-      ptr += pad;
+      expandPaletteRow(inbuf, palette, outbuf, w);
+      inbuf += w;
+      outbuf += stride;
       h--;
     }
   }
@@ -46,11 +46,11 @@ namespace rfb {
     uint32_t readCompact(rdr::InStream* is);
 
     void FilterGradient24(const uint8_t* inbuf, const PixelFormat& pf,
-                          uint32_t* outbuf, int stride, const core::Rect& r);
+                          uint8_t* outbuf, int stride, const core::Rect& r);
 
-    template<class T>
-    void FilterGradient(const uint8_t* inbuf, const PixelFormat& pf,
-                        T* outbuf, int stride, const core::Rect& r);
+    void FilterGradient(const uint8_t* inbuf, const PixelFormat& srcPF,
+                        const PixelFormat& dstPF, uint8_t* outbuf,
+                        int stride, const core::Rect& r);
 
     template<class T>
     void FilterPalette(const T* palette, int palSize,
@@ -63,7 +63,7 @@ static const TightConf conf[10] = {
 };
 
 TightEncoder::TightEncoder(SConnection* conn_) :
-  Encoder(conn_, encodingTight, EncoderPlain, 256)
+  Encoder(conn_, encodingTight, EncoderPlain, 256), pendingResets(0)
 {
   setCompressLevel(-1);
 }
@@ -87,6 +87,11 @@ void TightEncoder::setCompressLevel(int level)
   rawZlibLevel = conf[level].rawZlibLevel;
 }
 
+void TightEncoder::resetState()
+{
+  pendingResets = (1 << 4) - 1;
+}
+
 void TightEncoder::writeRect(const PixelBuffer* pb, const Palette& palette)
 {
   assert(pb->width() <= TIGHT_MAX_WIDTH);
@@ -114,7 +119,7 @@ void TightEncoder::writeSolidRect(int width, int /*height*/,
 
   assert(width <= TIGHT_MAX_WIDTH);
 
-  os = conn->getOutStream();
+  os = getOutStream();
 
   os->writeU8(tightFill << 4);
   writePixels(colour, pf, 1, os);
@@ -175,9 +180,9 @@ void TightEncoder::writeFullColourRect(const PixelBuffer* pb)
   const uint8_t* buffer;
   int stride, h;
 
-  os = conn->getOutStream();
+  os = getOutStream();
 
-  os->writeU8(streamId << 4);
+  os->writeU8(streamId << 4 | checkStreamReset(streamId));
 
   // Set up compression
   if ((pb->getPF().bpp != 32) || !pb->getPF().is888())
@@ -243,12 +248,25 @@ void TightEncoder::writeCompact(rdr::OutStream* os, uint32_t value)
   }
 }
 
+uint8_t TightEncoder::checkStreamReset(int streamId)
+{
+  // The client resets its stream as soon as it sees the flag, even if
+  // the rect turns out to be too small to be compressed
+  if (!(pendingResets & (1 << streamId)))
+    return 0;
+
+  zlibStreams[streamId].reset();
+  pendingResets &= ~(1 << streamId);
+
+  return 1 << streamId;
+}
+
 rdr::OutStream* TightEncoder::getZlibOutStream(int streamId, int level, size_t length)
 {
   // Minimum amount of data to be compressed. This value should not be
   // changed, doing so will break compatibility with existing clients.
   if (length < 12)
-    return conn->getOutStream();
+    return getOutStream();
 
   assert(streamId >= 0);
   assert(streamId < 4);
@@ -273,10 +291,10 @@ void TightEncoder::flushZlibOutStream(rdr::OutStream* os_)
   zos->flush();
   zos->setUnderlying(nullptr);
 
-  os = conn->getOutStream();
+  os = getOutStream();
 
   writeCompact(os, memStream.length());
-  os->writeBytes(memStream.data(), memStream.length());
+  os->writeBytesDirect(memStream.data(), memStream.length());
   memStream.clear();
 }
 
@@ -296,9 +314,10 @@ void TightEncoder::writeMonoRect(int width, int height,
 
   assert(palette.size() == 2);
 
-  os = conn->getOutStream();
+  os = getOutStream();
 
-  os->writeU8((streamId | tightExplicitFilter) << 4);
+  os->writeU8((streamId | tightExplicitFilter) << 4 |
+              checkStreamReset(streamId));
   os->writeU8(tightFilterPalette);
 
   // Write the palette
@@ -383,9 +402,10 @@ void TightEncoder::writeIndexedRect(int width, int height,
   assert(palette.size() > 0);
   assert(palette.size() <= 256);
 
-  os = conn->getOutStream();
+  os = getOutStream();
 
-  os->writeU8((streamId | tightExplicitFilter) << 4);
+  os->writeU8((streamId | tightExplicitFilter) << 4 |
+              checkStreamReset(streamId));
   os->writeU8(tightFilterPalette);
 
   // Write the palette
@@ -35,6 +35,8 @@ namespace rfb {
 
     void setCompressLevel(int level) override;
 
+    void resetState() override;
+
     void writeRect(const PixelBuffer* pb,
                    const Palette& palette) override;
     void writeSolidRect(int width, int height, const PixelFormat& pf,
@@ -50,6 +52,7 @@ namespace rfb {
 
     void writeCompact(rdr::OutStream* os, uint32_t value);
 
+    uint8_t checkStreamReset(int streamId);
     rdr::OutStream* getZlibOutStream(int streamId, int level, size_t length);
     void flushZlibOutStream(rdr::OutStream* os);
 
@@ -68,6 +71,9 @@ namespace rfb {
     rdr::MemOutStream memStream;
 
     int idxZlibLevel, monoZlibLevel, rawZlibLevel;
+
+    // Streams that need to be reset the next time they are used
+    unsigned pendingResets;
   };
 
 }
@@ -0,0 +1,449 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <core/ImplSelector.h>
+#include <core/LogWriter.h>
+#include <core/cpu.h>
+
+#include <rfb/TightFilter.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_SSE41
+#define HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace rfb;
+
+static core::LogWriter vlog("TightFilter");
+
+// The vector implementations handle as many whole pixels, or groups
+// of pixels, as they can and then leave the rest to the generic code.
+// Only 32 bpp has vector versions of the palette functions, as that
+// is what the viewer normally uses.
+
+struct GenericFilter {
+  static void gradient(const uint8_t* in, const uint8_t* prevRow,
+                       uint8_t* out, int width)
+  {
+    int left[3] = { 0, 0, 0 };
+    int upperLeft[3] = { 0, 0, 0 };
+
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < 3; c++) {
+        int est;
+
+        est = prevRow[c] + left[c] - upperLeft[c];
+        if (est > 255)
+          est = 255;
+        else if (est < 0)
+          est = 0;
+
+        out[c] = in[c] + est;
+
+        left[c] = out[c];
+        upperLeft[c] = prevRow[c];
+      }
+
+      in += 3;
+      prevRow += 3;
+      out += 3;
+    }
+  }
+
+  template<class T>
+  static void mono(const uint8_t* in, const T* palette, T* out,
+                   int width)
+  {
+    int x, b;
+    uint8_t bits;
+
+    for (x = 0; x < width / 8; x++) {
+      bits = *in++;
+      for (b = 7; b >= 0; b--)
+        *out++ = palette[bits >> b & 1];
+    }
+
+    if (width % 8 != 0) {
+      bits = *in++;
+      for (b = 7; b >= 8 - width % 8; b--)
+        *out++ = palette[bits >> b & 1];
+    }
+  }
+
+  template<class T>
+  static void palette(const uint8_t* in, const T* palette, T* out,
+                      int width)
+  {
+    for (int x = 0; x < width; x++)
+      out[x] = palette[in[x]];
+  }
+};
+
+#ifdef HAVE_SSE41
+
+// Pixels are three bytes, so they need to be moved via an integer to
+// avoid reading or writing past the end of the row. Building the
+// integer in a register avoids a stall when it is then loaded in to
+// a vector register.
+static inline __m128i load3(const uint8_t* ptr)
+{
+  return _mm_cvtsi32_si128(ptr[0] | ptr[1] << 8 | ptr[2] << 16);
+}
+
+static inline void store3(uint8_t* ptr, __m128i pix)
+{
+  uint32_t v;
+
+  v = _mm_cvtsi128_si32(pix);
+  memcpy(ptr, &v, 3);
+}
+
+struct SSE41Filter {
+  // Each pixel depends on the one to its left, so all we can do is
+  // handle the three components of each pixel in parallel
+  __attribute__((target("sse4.1")))
+  static void gradient(const uint8_t* in, const uint8_t* prevRow,
+                       uint8_t* out, int width)
+  {
+    __m128i left, upperLeft;
+
+    left = upperLeft = _mm_setzero_si128();
+
+    for (int x = 0; x < width; x++) {
+      __m128i up, est, pix;
+
+      up = _mm_cvtepu8_epi16(load3(prevRow));
+
+      est = _mm_sub_epi16(_mm_add_epi16(up, left), upperLeft);
+      // Saturating when narrowing gives us the clamping for free
+      est = _mm_packus_epi16(est, est);
+
+      pix = _mm_add_epi8(load3(in), est);
+      store3(out, pix);
+
+      left = _mm_cvtepu8_epi16(pix);
+      upperLeft = up;
+
+      in += 3;
+      prevRow += 3;
+      out += 3;
+    }
+  }
+
+  template<class T>
+  static void mono(const uint8_t* in, const T* palette, T* out,
+                   int width)
+  {
+    GenericFilter::mono(in, palette, out, width);
+  }
+
+  __attribute__((target("sse4.1")))
+  static void mono(const uint8_t* in, const uint32_t* palette,
+                   uint32_t* out, int width)
+  {
+    __m128i high, low, c0, c1;
+    int x;
+
+    high = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+    low = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+
+    c0 = _mm_set1_epi32(palette[0]);
+    c1 = _mm_set1_epi32(palette[1]);
+
+    for (x = 0; x + 8 <= width; x += 8) {
+      __m128i bits, sel;
+
+      bits = _mm_set1_epi32(*in++);
+
+      sel = _mm_cmpeq_epi32(_mm_and_si128(bits, high), high);
+      _mm_storeu_si128((__m128i*)(out + x), _mm_blendv_epi8(c0, c1, sel));
+
+      sel = _mm_cmpeq_epi32(_mm_and_si128(bits, low), low);
+      _mm_storeu_si128((__m128i*)(out + x + 4),
+                       _mm_blendv_epi8(c0, c1, sel));
+    }
+
+    GenericFilter::mono(in, palette, out + x, width - x);
+  }
+
+  template<class T>
+  static void palette(const uint8_t* in, const T* palette, T* out,
+                      int width)
+  {
+    GenericFilter::palette(in, palette, out, width);
+  }
+};
+
+#endif
+
+#ifdef HAVE_AVX2
+
+struct AVX2Filter {
+  // Nothing to gain from wider vectors here
+  static void gradient(const uint8_t* in, const uint8_t* prevRow,
+                       uint8_t* out, int width)
+  {
+    SSE41Filter::gradient(in, prevRow, out, width);
+  }
+
+  template<class T>
+  static void mono(const uint8_t* in, const T* palette, T* out,
+                   int width)
+  {
+    GenericFilter::mono(in, palette, out, width);
+  }
+
+  __attribute__((target("avx2")))
+  static void mono(const uint8_t* in, const uint32_t* palette,
+                   uint32_t* out, int width)
+  {
+    __m256i mask, c0, c1;
+    int x;
+
+    mask = _mm256_set_epi32(0x01, 0x02, 0x04, 0x08,
+                            0x10, 0x20, 0x40, 0x80);
+
+    c0 = _mm256_set1_epi32(palette[0]);
+    c1 = _mm256_set1_epi32(palette[1]);
+
+    for (x = 0; x + 8 <= width; x += 8) {
+      __m256i bits, sel;
+
+      bits = _mm256_set1_epi32(*in++);
+      sel = _mm256_cmpeq_epi32(_mm256_and_si256(bits, mask), mask);
+      _mm256_storeu_si256((__m256i*)(out + x),
+                          _mm256_blendv_epi8(c0, c1, sel));
+    }
+
+    GenericFilter::mono(in, palette, out + x, width - x);
+  }
+
+  template<class T>
+  static void palette(const uint8_t* in, const T* palette, T* out,
+                      int width)
+  {
+    GenericFilter::palette(in, palette, out, width);
+  }
+
+  __attribute__((target("avx2")))
+  static void palette(const uint8_t* in, const uint32_t* palette,
+                      uint32_t* out, int width)
+  {
+    int x;
+
+    for (x = 0; x + 8 <= width; x += 8) {
+      __m256i index;
+
+      index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(in + x)));
+      _mm256_storeu_si256((__m256i*)(out + x),
+                          _mm256_i32gather_epi32((const int*)palette,
+                                                 index, 4));
+    }
+
+    GenericFilter::palette(in + x, palette, out + x, width - x);
+  }
+};
+
+#endif
+
+#ifdef HAVE_NEON
+
+static inline uint8x8_t load3(const uint8_t* ptr)
+{
+  return vcreate_u8(ptr[0] | ptr[1] << 8 | ptr[2] << 16);
+}
+
+static inline void store3(uint8_t* ptr, uint8x8_t pix)
+{
+  uint32_t v;
+
+  v = vget_lane_u32(vreinterpret_u32_u8(pix), 0);
+  memcpy(ptr, &v, 3);
+}
+
+struct NEONFilter {
+  static void gradient(const uint8_t* in, const uint8_t* prevRow,
+                       uint8_t* out, int width)
+  {
+    int16x8_t left, upperLeft;
+
+    left = upperLeft = vdupq_n_s16(0);
+
+    for (int x = 0; x < width; x++) {
+      int16x8_t up, est;
+      uint8x8_t pix;
+
+      up = vreinterpretq_s16_u16(vmovl_u8(load3(prevRow)));
+
+      est = vsubq_s16(vaddq_s16(up, left), upperLeft);
+
+      pix = vadd_u8(load3(in), vqmovun_s16(est));
+      store3(out, pix);
+
+      left = vreinterpretq_s16_u16(vmovl_u8(pix));
+      upperLeft = up;
+
+      in += 3;
+      prevRow += 3;
+      out += 3;
+    }
+  }
+
+  template<class T>
+  static void mono(const uint8_t* in, const T* palette, T* out,
+                   int width)
+  {
+    GenericFilter::mono(in, palette, out, width);
+  }
+
+  static void mono(const uint8_t* in, const uint32_t* palette,
+                   uint32_t* out, int width)
+  {
+    static const uint32_t highBits[4] = { 0x80, 0x40, 0x20, 0x10 };
+    static const uint32_t lowBits[4] = { 0x08, 0x04, 0x02, 0x01 };
+
+    uint32x4_t high, low, c0, c1;
+    int x;
+
+    high = vld1q_u32(highBits);
+    low = vld1q_u32(lowBits);
+
+    c0 = vdupq_n_u32(palette[0]);
+    c1 = vdupq_n_u32(palette[1]);
+
+    for (x = 0; x + 8 <= width; x += 8) {
+      uint32x4_t bits;
+
+      bits = vdupq_n_u32(*in++);
+
+      vst1q_u32(out + x, vbslq_u32(vtstq_u32(bits, high), c1, c0));
+      vst1q_u32(out + x + 4, vbslq_u32(vtstq_u32(bits, low), c1, c0));
+    }
+
+    GenericFilter::mono(in, palette, out + x, width - x);
+  }
+
+  template<class T>
+  static void palette(const uint8_t* in, const T* palette, T* out,
+                      int width)
+  {
+    GenericFilter::palette(in, palette, out, width);
+  }
+};
+
+#endif
+
+struct TightFilterImpl {
+  const char* name;
+  void (*gradient)(const uint8_t*, const uint8_t*, uint8_t*, int);
+  void (*mono8)(const uint8_t*, const uint8_t*, uint8_t*, int);
+  void (*mono16)(const uint8_t*, const uint16_t*, uint16_t*, int);
+  void (*mono32)(const uint8_t*, const uint32_t*, uint32_t*, int);
+  void (*palette8)(const uint8_t*, const uint8_t*, uint8_t*, int);
+  void (*palette16)(const uint8_t*, const uint16_t*, uint16_t*, int);
+  void (*palette32)(const uint8_t*, const uint32_t*, uint32_t*, int);
+  bool (*supported)();
+};
+
+#define IMPL(name, filter, supported) \
+  { name, filter::gradient, \
+    filter::mono, filter::mono, filter::mono, \
+    filter::palette, filter::palette, filter::palette, \
+    supported }
+
+// Best implementation first
+static const TightFilterImpl impls[] = {
+#ifdef HAVE_AVX2
+  IMPL("avx2", AVX2Filter, core::cpuSupportsAVX2),
+#endif
+#ifdef HAVE_SSE41
+  IMPL("sse4.1", SSE41Filter, core::cpuSupportsSSE41),
+#endif
+#ifdef HAVE_NEON
+  IMPL("neon", NEONFilter, nullptr),
+#endif
+  IMPL("generic", GenericFilter, nullptr),
+};
+
+#undef IMPL
+
+static core::ImplSelector<TightFilterImpl> selector(impls, &vlog);
+
+void rfb::decodeGradientRow(const uint8_t* in, const uint8_t* prevRow,
+                            uint8_t* out, int width)
+{
+  selector.get()->gradient(in, prevRow, out, width);
+}
+
+void rfb::expandMonoRow(const uint8_t* in, const uint8_t* palette,
+                        uint8_t* out, int width)
+{
+  selector.get()->mono8(in, palette, out, width);
+}
+
+void rfb::expandMonoRow(const uint8_t* in, const uint16_t* palette,
+                        uint16_t* out, int width)
+{
+  selector.get()->mono16(in, palette, out, width);
+}
+
+void rfb::expandMonoRow(const uint8_t* in, const uint32_t* palette,
+                        uint32_t* out, int width)
+{
+  selector.get()->mono32(in, palette, out, width);
+}
+
+void rfb::expandPaletteRow(const uint8_t* in, const uint8_t* palette,
+                           uint8_t* out, int width)
+{
+  selector.get()->palette8(in, palette, out, width);
+}
+
+void rfb::expandPaletteRow(const uint8_t* in, const uint16_t* palette,
+                           uint16_t* out, int width)
+{
+  selector.get()->palette16(in, palette, out, width);
+}
+
+void rfb::expandPaletteRow(const uint8_t* in, const uint32_t* palette,
+                           uint32_t* out, int width)
+{
+  selector.get()->palette32(in, palette, out, width);
+}
+
+const char* rfb::tightFilterImpl()
+{
+  return selector.name();
+}
+
+bool rfb::setTightFilterImpl(const char* name)
+{
+  return selector.set(name);
+}
@@ -0,0 +1,63 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// Row functions for undoing the Tight filters when decoding
+//
+
+#ifndef __RFB_TIGHTFILTER_H__
+#define __RFB_TIGHTFILTER_H__
+
+#include <stdint.h>
+
+namespace rfb {
+
+  // decodeGradientRow() undoes the gradient filter for a row of RGB
+  // data. prevRow is the decoded row above, which should be all
+  // zeroes for the first row.
+  void decodeGradientRow(const uint8_t* in, const uint8_t* prevRow,
+                         uint8_t* out, int width);
+
+  // expandMonoRow() turns a row of bits in to pixels, with the most
+  // significant bit first. The palette must have two entries.
+  void expandMonoRow(const uint8_t* in, const uint8_t* palette,
+                     uint8_t* out, int width);
+  void expandMonoRow(const uint8_t* in, const uint16_t* palette,
+                     uint16_t* out, int width);
+  void expandMonoRow(const uint8_t* in, const uint32_t* palette,
+                     uint32_t* out, int width);
+
+  // expandPaletteRow() turns a row of palette indices in to pixels.
+  // The palette must have 256 entries, even if not all are used.
+  void expandPaletteRow(const uint8_t* in, const uint8_t* palette,
+                        uint8_t* out, int width);
+  void expandPaletteRow(const uint8_t* in, const uint16_t* palette,
+                        uint16_t* out, int width);
+  void expandPaletteRow(const uint8_t* in, const uint32_t* palette,
+                        uint32_t* out, int width);
+
+  // tightFilterImpl() returns the name of the implementation that is
+  // currently used. The best one available on this CPU is picked
+  // automatically, but setTightFilterImpl() can be used to force a
+  // specific one. It returns false if it isn't supported.
+  const char* tightFilterImpl();
+  bool setTightFilterImpl(const char* name);
+
+}
+
+#endif
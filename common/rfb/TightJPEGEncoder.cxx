@@ -91,12 +91,12 @@ void TightJPEGEncoder::writeRect(const PixelBuffer* pb,
   jc.clear();
   jc.compress(buffer, stride, pb->getRect(), pb->getPF());
 
-  os = conn->getOutStream();
+  os = getOutStream();
 
   os->writeU8(tightJpeg << 4);
 
   writeCompact(jc.length(), os);
-  os->writeBytes(jc.data(), jc.length());
+  os->writeBytesDirect(jc.data(), jc.length());
 }
 
 void TightJPEGEncoder::writeSolidRect(int width, int height,
@@ -0,0 +1,81 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <assert.h>
+
+#include <rfb/TileCache.h>
+
+using namespace rfb;
+
+const size_t TileCache::MaxTiles;
+
+TileCache::TileCache()
+{
+}
+
+TileCache::~TileCache()
+{
+}
+
+TileCache::Tile* TileCache::lookup(uint64_t hash)
+{
+  std::unordered_map<uint64_t, Entry>::iterator iter;
+
+  iter = tiles.find(hash);
+  if (iter == tiles.end())
+    return nullptr;
+
+  order.splice(order.begin(), order, iter->second.position);
+
+  return &iter->second.tile;
+}
+
+TileCache::Tile* TileCache::insert(uint64_t hash)
+{
+  Tile* tile;
+
+  tile = lookup(hash);
+  if (tile != nullptr)
+    return tile;
+
+  if (order.size() >= MaxTiles) {
+    tiles.erase(order.back());
+    order.pop_back();
+  }
+
+  order.push_front(hash);
+
+  Entry& entry = tiles[hash];
+  entry.position = order.begin();
+  entry.tile.width = 0;
+  entry.tile.height = 0;
+
+  assert(order.size() == tiles.size());
+
+  return &entry.tile;
+}
+
+void TileCache::clear()
+{
+  order.clear();
+  tiles.clear();
+}
@@ -0,0 +1,82 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+//
+// TileCache is a bounded store of tiles, identified by a hash of their
+// contents. The viewer keeps the pixels of each tile, whilst the
+// server uses the same class without any pixels to keep track of what
+// the viewer has. Both sides must therefore evict tiles in exactly the
+// same way.
+//
+
+#ifndef __RFB_TILECACHE_H__
+#define __RFB_TILECACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include <rfb/PixelFormat.h>
+
+namespace rfb {
+
+  class TileCache {
+  public:
+    // This is part of the protocol, as the server must know when the
+    // viewer throws away tiles
+    static const size_t MaxTiles = 2048;
+
+    struct Tile {
+      int width, height;
+      PixelFormat pf;
+      std::vector<uint8_t> data;
+    };
+
+    TileCache();
+    ~TileCache();
+
+    // lookup() returns the tile with the given hash, or nullptr if
+    // there is none. The tile is marked as the most recently used.
+    Tile* lookup(uint64_t hash);
+
+    // insert() returns a new or existing tile for the given hash, to
+    // be filled in by the caller. The least recently used tile is
+    // evicted if the cache is full.
+    Tile* insert(uint64_t hash);
+
+    void clear();
+
+    size_t size() const { return order.size(); }
+
+  private:
+    struct Entry {
+      std::list<uint64_t>::iterator position;
+      Tile tile;
+    };
+
+    // Most recently used first
+    std::list<uint64_t> order;
+    std::unordered_map<uint64_t, Entry> tiles;
+  };
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <core/i18n.h>
+#include <core/string.h>
+
+#include <rdr/MemInStream.h>
+#include <rdr/OutStream.h>
+
+#include <rfb/Exception.h>
+#include <rfb/PixelBuffer.h>
+#include <rfb/TileCacheDecoder.h>
+
+using namespace rfb;
+
+enum tileCacheOps {
+  tileCacheDraw    = 0,
+  tileCacheStore   = 1,
+};
+
+TileCacheDecoder::TileCacheDecoder() : Decoder(DecoderOrdered)
+{
+}
+
+TileCacheDecoder::~TileCacheDecoder()
+{
+}
+
+bool TileCacheDecoder::readRect(const core::Rect& /*r*/,
+                                rdr::InStream* is,
+                                const ServerParams& /*server*/,
+                                rdr::OutStream* os)
+{
+  uint8_t op;
+
+  if (!is->hasData(1 + 8))
+    return false;
+
+  op = is->readU8();
+  if ((op != tileCacheDraw) && (op != tileCacheStore))
+    throw protocol_error(core::format(_("Unknown tile cache operation %d"),
+                                      (int)op));
+
+  os->writeU8(op);
+  os->copyBytes(is, 8);
+
+  return true;
+}
+
+void TileCacheDecoder::decodeRect(const core::Rect& r,
+                                  const uint8_t* buffer,
+                                  size_t buflen,
+                                  const ServerParams& /*server*/,
+                                  ModifiablePixelBuffer* pb)
+{
+  rdr::MemInStream is(buffer, buflen);
+  uint8_t op;
+  uint64_t hash;
+  TileCache::Tile* tile;
+
+  op = is.readU8();
+  hash = (uint64_t)is.readU32() << 32;
+  hash |= is.readU32();
+
+  if (op == tileCacheStore) {
+    tile = cache.insert(hash);
+
+    tile->width = r.width();
+    tile->height = r.height();
+    tile->pf = pb->getPF();
+    tile->data.resize(r.area() * (pb->getPF().bpp/8));
+    pb->getImage(tile->data.data(), r);
+
+    return;
+  }
+
+  tile = cache.lookup(hash);
+  if (tile == nullptr)
+    throw protocol_error(_("Unknown cached tile"));
+  if ((tile->width != r.width()) || (tile->height != r.height()))
+    throw protocol_error(_("Cached tile has the wrong size"));
+
+  pb->imageRect(tile->pf, r, tile->data.data());
+}
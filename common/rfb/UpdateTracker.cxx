@@ -25,6 +25,9 @@
 #include <config.h>
 #endif
 
+#include <algorithm>
+#include <vector>
+
 #include <core/LogWriter.h>
 
 #include <rfb/UpdateTracker.h>
@@ -33,6 +36,10 @@ using namespace rfb;
 
 static core::LogWriter vlog("UpdateTracker");
 
+// Rough cost of sending an extra rect, counted in pixels. This covers
+// the rect header and the per rect work in the encoders.
+static const int RectOverhead = 256;
+
 
 // -=- ClippingUpdateTracker
 
@@ -68,7 +75,9 @@ void ClippingUpdateTracker::add_copied(const core::Region& dest,
 
 // SimpleUpdateTracker
 
-SimpleUpdateTracker::SimpleUpdateTracker() {
+SimpleUpdateTracker::SimpleUpdateTracker()
+  : coalesceRects(0), coalesceArea(0), coalescedRects(0)
+{
 }
 
 SimpleUpdateTracker::~SimpleUpdateTracker() {
@@ -77,6 +86,11 @@ SimpleUpdateTracker::~SimpleUpdateTracker() {
 void SimpleUpdateTracker::add_changed(const core::Region& region)
 {
   changed.assign_union(region);
+
+  // Don't keep coalescing if it didn't help much the last time
+  if ((coalesceRects > 0) &&
+      (changed.numRects() > std::max(coalesceRects, coalescedRects * 2)))
+    coalesce();
 }
 
 void SimpleUpdateTracker::add_copied(const core::Region& dest,
@@ -133,6 +147,70 @@ void SimpleUpdateTracker::subtract(const core::Region& region)
 {
   copied.assign_subtract(region);
   changed.assign_subtract(region);
+
+  if (coalescedRects > changed.numRects())
+    coalescedRects = changed.numRects();
+}
+
+void SimpleUpdateTracker::setCoalescing(int maxRects, int maxArea)
+{
+  coalesceRects = maxRects;
+  coalesceArea = maxArea;
+}
+
+void SimpleUpdateTracker::coalesce()
+{
+  std::vector<core::Rect> rects, boxes;
+  std::vector<size_t> open;
+
+  changed.get_rects(&rects);
+
+  // The rects come top to bottom, so each one only needs to be checked
+  // against the boxes that are still close enough above it
+  for (const core::Rect& r : rects) {
+    size_t best;
+    int bestExtra;
+
+    best = boxes.size();
+    bestExtra = RectOverhead;
+
+    for (size_t n = 0; n < open.size(); ) {
+      const core::Rect& box = boxes[open[n]];
+      core::Rect merged;
+      int extra;
+
+      if ((r.tl.y - box.br.y) * box.width() > RectOverhead) {
+        open[n] = open.back();
+        open.pop_back();
+        continue;
+      }
+
+      merged = box.union_boundary(r);
+      extra = merged.area() - box.area() - r.area();
+      if ((merged.area() <= coalesceArea) && (extra <= bestExtra)) {
+        best = open[n];
+        bestExtra = extra;
+      }
+
+      n++;
+    }
+
+    if (best == boxes.size()) {
+      open.push_back(boxes.size());
+      boxes.push_back(r);
+    } else {
+      boxes[best] = boxes[best].union_boundary(r);
+    }
+  }
+
+  changed.clear();
+  for (const core::Rect& box : boxes)
+    changed.assign_union(box);
+
+  coalescedRects = changed.numRects();
+
+  vlog.debug("Coalesced %d rects into %d", (int)rects.size(),
+             coalescedRects);
 }
 
 void SimpleUpdateTracker::getUpdateInfo(UpdateInfo* info,
@@ -77,6 +77,11 @@ namespace rfb {
                     const core::Point& delta) override;
     virtual void subtract(const core::Region& region);
 
+    // Merge nearby changes into larger rects once the changed region
+    // has more than maxRects rects, as long as no merged rect is
+    // larger than maxArea. A maxRects of 0 disables this.
+    void setCoalescing(int maxRects, int maxArea);
+
     // Fill the supplied UpdateInfo structure with update information
     // FIXME: Provide getUpdateInfo() with no clipping, for better efficiency.
     virtual void getUpdateInfo(UpdateInfo* info,
@@ -90,11 +95,17 @@ namespace rfb {
 
     virtual bool is_empty() const {return changed.is_empty() && copied.is_empty();}
 
-    virtual void clear() {changed.clear(); copied.clear();};
+    virtual void clear() {changed.clear(); copied.clear(); coalescedRects = 0;};
   protected:
+    void coalesce();
+
     core::Region changed;
     core::Region copied;
     core::Point copy_delta;
+
+    int coalesceRects;
+    int coalesceArea;
+    int coalescedRects;
   };
 
 }
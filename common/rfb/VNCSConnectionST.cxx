@@ -73,18 +73,29 @@ VNCSConnectionST::VNCSConnectionST(VNCServerST* server_, network::Socket *s,
     fenceDataLen(0), fenceData(nullptr), congestionTimer(this),
     losslessTimer(this), server(server_),
     updateRenderedCursor(false), removeRenderedCursor(false),
-    continuousUpdates(false), encodeManager(this), idleTimer(this),
+    continuousUpdates(false),
+    encodeManager(this, server_->getEncodeCache()), idleTimer(this),
     pointerEventTime(0), clientHasCursor(false)
 {
   socketTimer.start(core::secsToMillis(LOGIN_GRACE_TIME));
 
   setStreams(&sock->inStream(), &sock->outStream());
   peerEndpoint = sock->getPeerEndpoint();
+
+  if (Server::zeroCopy && !sock->outStream().setZeroCopy(true))
+    vlog.debug("Zero copy sending not supported for %s",
+               peerEndpoint.c_str());
 }
 
 
 VNCSConnectionST::~VNCSConnectionST()
 {
+  // Don't leave a background thread using us
+  try {
+    finishUpdate();
+  } catch (std::exception&) {
+  }
+
   // If we reach here then VNCServerST is deleting us!
   if (!closeReason.empty())
     vlog.info(_("Closing %s: %s"), peerEndpoint.c_str(),
@@ -121,6 +132,12 @@ bool VNCSConnectionST::accessCheck(AccessRights ar) const
 
 void VNCSConnectionST::close(const char* reason)
 {
+  // Whatever went wrong with the update doesn't matter now
+  try {
+    finishUpdate();
+  } catch (std::exception&) {
+  }
+
   SConnection::close(reason);
 
   // Log the reason for the close
@@ -179,6 +196,8 @@ void VNCSConnectionST::processSocketReadEvent()
   }
 
   try {
+    finishUpdate();
+
     inProcessMessages = true;
 
     // Get the underlying transport to build large packets if we send
@@ -219,6 +238,8 @@ void VNCSConnectionST::processSocketWriteEvent()
 {
   if (state() == RFBSTATE_CLOSING) return;
   try {
+    finishUpdate();
+
     sock->outStream().flush();
     // Flushing the socket might release an update that was previously
     // delayed because of congestion.
@@ -232,6 +253,7 @@ void VNCSConnectionST::processSocketWriteEvent()
 void VNCSConnectionST::pixelBufferChange()
 {
   try {
+    finishUpdate();
     if (state() != RFBSTATE_NORMAL)
       return;
     if (client.width() && client.height() &&
@@ -291,6 +313,7 @@ void VNCSConnectionST::writeFramebufferUpdateOrClose()
 void VNCSConnectionST::screenLayoutChangeOrClose(uint16_t reason)
 {
   try {
+    finishUpdate();
     screenLayoutChange(reason);
     writeFramebufferUpdate();
   } catch(std::exception& e) {
@@ -301,6 +324,7 @@ void VNCSConnectionST::screenLayoutChangeOrClose(uint16_t reason)
 void VNCSConnectionST::bellOrClose()
 {
   try {
+    finishUpdate();
     if (state() == RFBSTATE_NORMAL) writer()->writeBell();
   } catch(std::exception& e) {
     close(e.what());
@@ -310,6 +334,7 @@ void VNCSConnectionST::bellOrClose()
 void VNCSConnectionST::setDesktopNameOrClose(const char *name)
 {
   try {
+    finishUpdate();
     setDesktopName(name);
     writeFramebufferUpdate();
   } catch(std::exception& e) {
@@ -320,6 +345,7 @@ void VNCSConnectionST::setDesktopNameOrClose(const char *name)
 void VNCSConnectionST::setCursorOrClose()
 {
   try {
+    finishUpdate();
     setCursor();
     writeFramebufferUpdate();
   } catch(std::exception& e) {
@@ -330,6 +356,7 @@ void VNCSConnectionST::setCursorOrClose()
 void VNCSConnectionST::setLEDStateOrClose(unsigned int state)
 {
   try {
+    finishUpdate();
     setLEDState(state);
     writeFramebufferUpdate();
   } catch(std::exception& e) {
@@ -340,6 +367,7 @@ void VNCSConnectionST::setLEDStateOrClose(unsigned int state)
 void VNCSConnectionST::requestClipboardOrClose()
 {
   try {
+    finishUpdate();
     if (state() != RFBSTATE_NORMAL) return;
     requestClipboard();
   } catch(std::exception& e) {
@@ -350,6 +378,7 @@ void VNCSConnectionST::requestClipboardOrClose()
 void VNCSConnectionST::announceClipboardOrClose(bool available)
 {
   try {
+    finishUpdate();
     if (state() != RFBSTATE_NORMAL) return;
     announceClipboard(available);
   } catch(std::exception& e) {
@@ -360,6 +389,7 @@ void VNCSConnectionST::announceClipboardOrClose(bool available)
 void VNCSConnectionST::sendClipboardDataOrClose(const char* data)
 {
   try {
+    finishUpdate();
     if (state() != RFBSTATE_NORMAL) return;
     sendClipboardData(data);
   } catch(std::exception& e) {
@@ -367,6 +397,21 @@ void VNCSConnectionST::sendClipboardDataOrClose(const char* data)
   }
 }
 
+void VNCSConnectionST::finishUpdateOrClose()
+{
+  try {
+    if (!encodeManager.isUpdating() || !encodeManager.isUpdateDone())
+      return;
+
+    finishUpdate();
+
+    // Things might have changed whilst we were busy
+    writeFramebufferUpdate();
+  } catch(std::exception& e) {
+    close(e.what());
+  }
+}
+
 void VNCSConnectionST::desktopReadyOrClose()
 {
   try {
@@ -411,7 +456,12 @@ void VNCSConnectionST::renderedCursorChange()
 
 void VNCSConnectionST::cursorPositionChange()
 {
-  setCursorPos();
+  try {
+    finishUpdate();
+    setCursorPos();
+  } catch(std::exception& e) {
+    close(e.what());
+  }
 }
 
 // needRenderedCursor() returns true if this client needs the server-side
@@ -862,6 +912,13 @@ void VNCSConnectionST::handleTimeout(core::Timer* t)
     close(_("Idle for too long"));
 }
 
+void VNCSConnectionST::updateFinished(EncodeManager* /*manager*/)
+{
+  // Called from the background thread, so the server does the rest
+  // once it gets around to it
+  server->notifyUpdateFinished();
+}
+
 bool VNCSConnectionST::isShiftPressed()
 {
     std::map<uint32_t, uint32_t>::const_iterator iter;
@@ -924,6 +981,14 @@ bool VNCSConnectionST::isCongested()
 
 void VNCSConnectionST::writeFramebufferUpdate()
 {
+  // Still busy with the previous update. We'll get another chance
+  // once that is done.
+  if (encodeManager.isUpdating())
+    return;
+
+  // Applies to the changes that arrive until the next update
+  updates.setCoalescing(Server::coalesceRects, Server::coalesceArea);
+
   congestion.updatePosition(sock->outStream().length());
 
   // We're in the middle of processing a command that's supposed to be
@@ -961,6 +1026,24 @@ void VNCSConnectionST::writeFramebufferUpdate()
   // Then real data (if possible)
   writeDataUpdate();
 
+  // A background update is wrapped up in finishUpdate() instead
+  if (encodeManager.isUpdating())
+    return;
+
+  getOutStream()->cork(false);
+
+  congestion.updatePosition(sock->outStream().length());
+}
+
+void VNCSConnectionST::finishUpdate()
+{
+  if (!encodeManager.isUpdating())
+    return;
+
+  encodeManager.finishUpdate();
+
+  writeRTTPing();
+
   getOutStream()->cork(false);
 
   congestion.updatePosition(sock->outStream().length());
@@ -1078,9 +1161,16 @@ void VNCSConnectionST::writeDataUpdate()
 
   writeRTTPing();
 
-  encodeManager.writeUpdate(ui, server->getPixelBuffer(), cursor);
+  encodeManager.setNetworkEstimate(congestion.getBandwidth(),
+                                   congestion.getRTT());
 
-  writeRTTPing();
+  if (server->useBackgroundUpdates()) {
+    // The rest is done by finishUpdate() once it is ready
+    encodeManager.startUpdate(ui, server->getPixelBuffer(), cursor, this);
+  } else {
+    encodeManager.writeUpdate(ui, server->getPixelBuffer(), cursor);
+    writeRTTPing();
+  }
 
   // The request might be for just part of the screen, so we cannot
   // just clear the entire update tracker.
@@ -39,7 +39,8 @@ namespace rfb {
   class VNCServerST;
 
   class VNCSConnectionST : private SConnection,
-                           public core::Timer::Callback {
+                           public core::Timer::Callback,
+                           public EncodeManager::UpdateCallback {
   public:
     VNCSConnectionST(VNCServerST* server_, network::Socket* s, bool reverse,
                      AccessRights ar);
@@ -86,6 +87,10 @@ namespace rfb {
     void sendClipboardDataOrClose(const char* data);
     void desktopReadyOrClose();
 
+    // finishUpdateOrClose() completes an update that was encoded in the
+    // background, if it is done, and then sends any further updates.
+    void finishUpdateOrClose();
+
     // The following methods never throw exceptions
 
     // getComparerState() returns if this client would like the framebuffer
@@ -103,6 +108,10 @@ namespace rfb {
     // it will arrange for the new cursor position to be sent to the client.
     void cursorPositionChange();
 
+    // isUpdating() returns true if an update is being encoded in the
+    // background, in which case the socket must be left alone.
+    bool isUpdating() { return encodeManager.isUpdating(); }
+
     // needRenderedCursor() returns true if this client needs the server-side
     // rendered cursor.  This may be because it does not support local cursor
     // or because the current cursor position has not been set by this client.
@@ -150,6 +159,9 @@ namespace rfb {
     // Timer callbacks
     void handleTimeout(core::Timer* t) override;
 
+    // EncodeManager callbacks
+    void updateFinished(EncodeManager* manager) override;
+
     // Internal methods
 
     bool isShiftPressed();
@@ -166,6 +178,11 @@ namespace rfb {
     void writeDataUpdate();
     void writeLosslessRefresh();
 
+    // finishUpdate() must be called before anything touches the
+    // connection, in case an update is being written in the background.
+    // It waits for it if it isn't done yet.
+    void finishUpdate();
+
     void screenLayoutChange(uint16_t reason);
     void setCursor();
     void setCursorPos();
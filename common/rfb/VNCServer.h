@@ -73,6 +73,22 @@ namespace rfb {
     //   mode and needs this callback to flush the buffer.
     virtual void processSocketWriteEvent(network::Socket* sock) = 0;
 
+    // enableBackgroundUpdates() lets updates be encoded and written on
+    //   background threads, so that they don't hold up the caller. The
+    //   returned file descriptor becomes readable whenever
+    //   processBackgroundUpdates() needs to be called. Returns -1 if
+    //   background updates aren't possible.
+    virtual int enableBackgroundUpdates() = 0;
+
+    // processBackgroundUpdates() finishes off any updates that are
+    //   done in the background.
+    virtual void processBackgroundUpdates() = 0;
+
+    // isSocketBusy() returns true if a background update is currently
+    //   writing to the Socket. Its streams must not be touched until
+    //   it is done.
+    virtual bool isSocketBusy(network::Socket* sock) = 0;
+
     // blockUpdates()/unblockUpdates() tells the server that the pixel buffer
     // is currently in flux and may not be accessed. The attributes of the
     // pixel buffer may still be accessed, but not the frame buffer itself.
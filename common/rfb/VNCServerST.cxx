@@ -53,13 +53,21 @@
 #endif
 
 #include <assert.h>
+#include <errno.h>
 #include <stdlib.h>
+#include <string.h>
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include <core/LogWriter.h>
+#include <core/ThreadPool.h>
 #include <core/i18n.h>
 #include <core/time.h>
 
 #include <rdr/FdOutStream.h>
+#include <rdr/ZlibBackend.h>
 
 #include <network/Socket.h>
 
@@ -96,6 +104,8 @@ VNCServerST::VNCServerST(const char* name_, SDesktop* desktop_)
     idleTimer(this), disconnectTimer(this), connectTimer(this),
     msc(0), queuedMsc(0), frameTimer(this)
 {
+  notifyFds[0] = notifyFds[1] = -1;
+
   slog.debug("Creating single-threaded server %s", name.c_str());
 
   desktop_->init(this);
@@ -132,7 +142,16 @@ VNCServerST::~VNCServerST()
     comparer->logStats();
   delete comparer;
 
+  encodeCache.logStats();
+
   delete cursor;
+
+#ifndef WIN32
+  if (notifyFds[0] != -1) {
+    ::close(notifyFds[0]);
+    ::close(notifyFds[1]);
+  }
+#endif
 }
 
 
@@ -162,6 +181,14 @@ bool VNCServerST::addSocket(network::Socket* sock, bool outgoing, AccessRights a
 
   connectionsLog.info(_("Accepted: %s"), sock->getPeerEndpoint());
 
+  // The client's compression streams are set up right away, so this
+  // only affects new clients
+  if (rfb::Server::zlibImpl == "Auto")
+    rdr::setZlibImpl(nullptr);
+  else if (!rdr::setZlibImpl(rfb::Server::zlibImpl.getValueStr().c_str()))
+    slog.error(_("The %s zlib implementation is not available"),
+               rfb::Server::zlibImpl.getValueStr().c_str());
+
   try {
     VNCSConnectionST* client = new VNCSConnectionST(this, sock, outgoing, accessRights);
     clients.push_front(client);
@@ -204,6 +231,7 @@ void VNCServerST::removeSocket(network::Socket* sock) {
 
       if (comparer)
         comparer->logStats();
+      encodeCache.logStats();
 
       // Adjust the exit timers
       if (authClientCount() == 0) {
@@ -245,6 +273,74 @@ void VNCServerST::processSocketWriteEvent(network::Socket* sock)
   throw std::invalid_argument("Invalid Socket in VNCServerST");
 }
 
+int VNCServerST::enableBackgroundUpdates()
+{
+#ifdef WIN32
+  return -1;
+#else
+  if (notifyFds[0] != -1)
+    return notifyFds[0];
+
+  // Without any worker threads, the update would only get done once
+  // we start waiting for it
+  if (core::ThreadPool::shared()->size() == 0) {
+    slog.info("No worker threads available for background updates");
+    return -1;
+  }
+
+  if (pipe(notifyFds) < 0) {
+    slog.error("Failed to create notification pipe: %s", strerror(errno));
+    notifyFds[0] = notifyFds[1] = -1;
+    return -1;
+  }
+
+  // A full pipe means that a wake up is already pending
+  fcntl(notifyFds[0], F_SETFL, fcntl(notifyFds[0], F_GETFL) | O_NONBLOCK);
+  fcntl(notifyFds[1], F_SETFL, fcntl(notifyFds[1], F_GETFL) | O_NONBLOCK);
+
+  slog.debug("Encoding updates in the background");
+
+  return notifyFds[0];
+#endif
+}
+
+void VNCServerST::processBackgroundUpdates()
+{
+  std::list<VNCSConnectionST*>::iterator ci;
+
+#ifndef WIN32
+  char buf[64];
+
+  // Several updates can share one wake up, so we just check everyone
+  while (read(notifyFds[0], buf, sizeof(buf)) > 0)
+    ;
+#endif
+
+  for (ci = clients.begin(); ci != clients.end(); ++ci)
+    (*ci)->finishUpdateOrClose();
+}
+
+bool VNCServerST::isSocketBusy(network::Socket* sock)
+{
+  std::list<VNCSConnectionST*>::iterator ci;
+  for (ci = clients.begin(); ci != clients.end(); ci++) {
+    if ((*ci)->getSock() == sock)
+      return (*ci)->isUpdating();
+  }
+  return false;
+}
+
+void VNCServerST::notifyUpdateFinished()
+{
+#ifndef WIN32
+  char c = 0;
+
+  if (write(notifyFds[1], &c, 1) < 0) {
+    // Can't log from here, and a full pipe is fine anyway
+  }
+#endif
+}
+
 void VNCServerST::blockUpdates()
 {
   blockCounter++;
@@ -285,6 +381,9 @@ void VNCServerST::setPixelBuffer(PixelBuffer* pb_, const ScreenSet& layout)
   delete comparer;
   comparer = nullptr;
 
+  encodeCache.logStats();
+  encodeCache.clear();
+
   if (!pb) {
     screenLayout = ScreenSet();
 
@@ -466,6 +565,7 @@ void VNCServerST::add_changed(const core::Region& region)
     return;
 
   comparer->add_changed(region);
+  encodeCache.invalidate(region);
   startFrameClock();
 }
 
@@ -476,6 +576,7 @@ void VNCServerST::add_copied(const core::Region& dest,
     return;
 
   comparer->add_copied(dest, delta);
+  encodeCache.invalidate(dest);
   startFrameClock();
 }
 
@@ -914,6 +1015,16 @@ void VNCServerST::writeUpdate()
 
   pb->grabRegion(toCheck);
 
+  if (rfb::Server::compareMethod == "Hash")
+    comparer->setMethod(ComparingUpdateTracker::CompareHash);
+  else
+    comparer->setMethod(ComparingUpdateTracker::CompareCopy);
+
+  comparer->setThreads(rfb::Server::compareThreads);
+  comparer->setScrollDetection(rfb::Server::detectScroll);
+  comparer->setCoalescing(rfb::Server::coalesceRects,
+                          rfb::Server::coalesceArea);
+
   if (getComparerState())
     comparer->enable();
   else
@@ -26,11 +26,14 @@
 
 #include <sys/time.h>
 
+#include <list>
+
 #include <core/Timer.h>
 
 #include <rfb/VNCServer.h>
 #include <rfb/Blacklist.h>
 #include <rfb/Cursor.h>
+#include <rfb/EncodeCache.h>
 #include <rfb/ScreenSet.h>
 
 namespace rfb {
@@ -78,6 +81,10 @@ namespace rfb {
     //   Flush pending data from the Socket on to the network.
     void processSocketWriteEvent(network::Socket* sock) override;
 
+    int enableBackgroundUpdates() override;
+    void processBackgroundUpdates() override;
+    bool isSocketBusy(network::Socket* sock) override;
+
     void blockUpdates() override;
     void unblockUpdates() override;
     uint64_t getMsc() override;
@@ -87,6 +94,9 @@ namespace rfb {
     void setScreenLayout(const ScreenSet& layout) override;
     const PixelBuffer* getPixelBuffer() const override { return pb; }
 
+    // Encoded rects that can be shared between clients
+    EncodeCache* getEncodeCache() { return &encodeCache; }
+
     void requestClipboard() override;
     void announceClipboard(bool available) override;
     void sendClipboardData(const char* data) override;
@@ -156,6 +166,14 @@ namespace rfb {
     // side rendered cursor buffer
     const RenderedCursor* getRenderedCursor();
 
+    // useBackgroundUpdates() returns true if clients should encode
+    // their updates in the background
+    bool useBackgroundUpdates() const { return notifyFds[0] != -1; }
+
+    // notifyUpdateFinished() is called from the background thread when
+    // an update is done. It is safe to call from any thread.
+    void notifyUpdateFinished();
+
   protected:
 
     // Timer callbacks
@@ -199,6 +217,7 @@ namespace rfb {
     time_t pointerClientTime;
 
     ComparingUpdateTracker* comparer;
+    EncodeCache encodeCache;
 
     core::Point cursorPos;
     Cursor* cursor;
@@ -213,6 +232,9 @@ namespace rfb {
 
     uint64_t msc, queuedMsc;
     core::Timer frameTimer;
+
+    // Wakes up the main thread when a background update is done
+    int notifyFds[2];
   };
 
 };
@@ -31,7 +31,9 @@
 
 #include <rfb/Exception.h>
 #include <rfb/ServerParams.h>
+#include <rfb/IndexPack.h>
 #include <rfb/PixelBuffer.h>
+#include <rfb/TightFilter.h>
 #include <rfb/ZRLEDecoder.h>
 
 using namespace rfb;
@@ -55,7 +57,7 @@ static inline uint32_t readOpaque24B(rdr::InStream* is)
 }
 
 template<class T>
-static inline T readPixel(rdr::ZlibInStream* zis)
+static inline T readPixel(rdr::InStream* zis)
 {
   if (sizeof(T) == 1)
     return zis->readOpaque8();
@@ -65,7 +67,7 @@ static inline T readPixel(rdr::ZlibInStream* zis)
     return zis->readOpaque32();
 }
 
-static inline void zlibHasData(rdr::ZlibInStream* zis, size_t length)
+static inline void zlibHasData(rdr::InStream* zis, size_t length)
 {
   if (!zis->hasData(length))
     throw protocol_error(_("Failed to decode ZRLE rectangle"));
@@ -122,9 +124,11 @@ void ZRLEDecoder::zrleDecode(const core::Rect& r, rdr::InStream* is,
                              ModifiablePixelBuffer* pb)
 {
   int length = is->readU32();
-  zis.setUnderlying(is, length);
+  rdr::InStream* zis = beginData(is, length);
   core::Rect t;
   T buf[64 * 64];
+  // Big enough for any index, so they never need to be checked
+  T palette[256] = {};
 
   Pixel maxPixel = pf.pixelFromRGB((uint16_t)-1, (uint16_t)-1, (uint16_t)-1);
   bool fitsInLS3Bytes = maxPixel < (1<<24);
@@ -144,24 +148,23 @@ void ZRLEDecoder::zrleDecode(const core::Rect& r, rdr::InStream* is,
 
       t.br.x = std::min(r.br.x, t.tl.x + 64);
 
-      zlibHasData(&zis, 1);
-      int mode = zis.readU8();
+      zlibHasData(zis, 1);
+      int mode = zis->readU8();
       bool rle = mode & 128;
       int palSize = mode & 127;
-      T palette[128];
 
       if (isLowCPixel || isHighCPixel)
-        zlibHasData(&zis, 3 * palSize);
+        zlibHasData(zis, 3 * palSize);
       else
-        zlibHasData(&zis, sizeof(T) * palSize);
+        zlibHasData(zis, sizeof(T) * palSize);
 
       for (int i = 0; i < palSize; i++) {
         if (isLowCPixel)
-          palette[i] = readOpaque24A(&zis);
+          palette[i] = readOpaque24A(zis);
         else if (isHighCPixel)
-          palette[i] = readOpaque24B(&zis);
+          palette[i] = readOpaque24B(zis);
         else
-          palette[i] = readPixel<T>(&zis);
+          palette[i] = readPixel<T>(zis);
       }
 
       if (palSize == 1) {
@@ -176,19 +179,19 @@ void ZRLEDecoder::zrleDecode(const core::Rect& r, rdr::InStream* is,
           // raw
 
           if (isLowCPixel || isHighCPixel)
-            zlibHasData(&zis, 3 * t.area());
+            zlibHasData(zis, 3 * t.area());
           else
-            zlibHasData(&zis, sizeof(T) * t.area());
+            zlibHasData(zis, sizeof(T) * t.area());
 
           if (isLowCPixel || isHighCPixel) {
             for (T* ptr = buf; ptr < buf+t.area(); ptr++) {
               if (isLowCPixel)
-                *ptr = readOpaque24A(&zis);
+                *ptr = readOpaque24A(zis);
               else
-                *ptr = readOpaque24B(&zis);
+                *ptr = readOpaque24B(zis);
             }
           } else {
-            zis.readBytes((uint8_t*)buf, t.area() * sizeof(T));
+            zis->readBytes((uint8_t*)buf, t.area() * sizeof(T));
           }
 
         } else {
@@ -196,24 +199,27 @@ void ZRLEDecoder::zrleDecode(const core::Rect& r, rdr::InStream* is,
           // packed pixels
           int bppp = ((palSize > 16) ? 8 :
                       ((palSize > 4) ? 4 : ((palSize > 2) ? 2 : 1)));
+          int rowBytes = (t.width() * bppp + 7) / 8;
 
           T* ptr = buf;
 
           for (int i = 0; i < t.height(); i++) {
-            T* eol = ptr + t.width();
-            uint8_t byte = 0;
-            uint8_t nbits = 0;
-
-            while (ptr < eol) {
-              if (nbits == 0) {
-                zlibHasData(&zis, 1);
-                byte = zis.readU8();
-                nbits = 8;
-              }
-              nbits -= bppp;
-              uint8_t index = (byte >> nbits) & ((1 << bppp) - 1) & 127;
-              *ptr++ = palette[index];
+            uint8_t packed[64];
+            uint8_t indices[64];
+
+            zlibHasData(zis, rowBytes);
+            zis->readBytes(packed, rowBytes);
+
+            if (bppp == 1)
+              expandMonoRow(packed, palette, ptr, t.width());
+            else if (bppp == 8)
+              expandPaletteRow(packed, palette, ptr, t.width());
+            else {
+              unpackIndexRow(packed, indices, t.width(), bppp);
+              expandPaletteRow(indices, palette, ptr, t.width());
             }
+
+            ptr += t.width();
           }
         }
 
@@ -228,20 +234,20 @@ void ZRLEDecoder::zrleDecode(const core::Rect& r, rdr::InStream* is,
           while (ptr < end) {
             T pix;
             if (isLowCPixel || isHighCPixel)
-              zlibHasData(&zis, 3);
+              zlibHasData(zis, 3);
             else
-              zlibHasData(&zis, sizeof(T));
+              zlibHasData(zis, sizeof(T));
             if (isLowCPixel)
-              pix = readOpaque24A(&zis);
+              pix = readOpaque24A(zis);
             else if (isHighCPixel)
-              pix = readOpaque24B(&zis);
+              pix = readOpaque24B(zis);
             else
-              pix = readPixel<T>(&zis);
+              pix = readPixel<T>(zis);
             int len = 1;
             int b;
             do {
-              zlibHasData(&zis, 1);
-              b = zis.readU8();
+              zlibHasData(zis, 1);
+              b = zis->readU8();
               len += b;
             } while (b == 255);
 
@@ -259,14 +265,14 @@ void ZRLEDecoder::zrleDecode(const core::Rect& r, rdr::InStream* is,
           T* ptr = buf;
           T* end = ptr + t.area();
           while (ptr < end) {
-            zlibHasData(&zis, 1);
-            int index = zis.readU8();
+            zlibHasData(zis, 1);
+            int index = zis->readU8();
             int len = 1;
             if (index & 128) {
               int b;
               do {
-                zlibHasData(&zis, 1);
-                b = zis.readU8();
+                zlibHasData(zis, 1);
+                b = zis->readU8();
                 len += b;
               } while (b == 255);
 
@@ -288,6 +294,17 @@ void ZRLEDecoder::zrleDecode(const core::Rect& r, rdr::InStream* is,
     }
   }
 
-  zis.flushUnderlying();
-  zis.setUnderlying(nullptr, 0);
+  endData();
+}
+
+rdr::InStream* ZRLEDecoder::beginData(rdr::InStream* is, size_t length)
+{
+  zlibStream.setUnderlying(is, length);
+  return &zlibStream;
+}
+
+void ZRLEDecoder::endData()
+{
+  zlibStream.flushUnderlying();
+  zlibStream.setUnderlying(nullptr, 0);
 }
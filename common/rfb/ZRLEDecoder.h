@@ -37,13 +37,19 @@ namespace rfb {
                     size_t buflen, const ServerParams& server,
                     ModifiablePixelBuffer* pb) override;
 
+  protected:
+    // Variants only differ in how the data is compressed, so they just
+    // need to provide a different stream to read the tiles from
+    virtual rdr::InStream* beginData(rdr::InStream* is, size_t length);
+    virtual void endData();
+
   private:
     template<class T>
     void zrleDecode(const core::Rect& r, rdr::InStream* is,
                     const PixelFormat& pf, ModifiablePixelBuffer* pb);
 
   private:
-    rdr::ZlibInStream zis;
+    rdr::ZlibInStream zlibStream;
   };
 }
 #endif
@@ -27,8 +27,10 @@
 
 #include <rdr/OutStream.h>
 #include <rfb/encodings.h>
+#include <rfb/IndexPack.h>
 #include <rfb/Palette.h>
 #include <rfb/PixelBuffer.h>
+#include <rfb/PixelScan.h>
 #include <rfb/SConnection.h>
 #include <rfb/ZRLEEncoder.h>
 
@@ -41,30 +43,42 @@ core::IntParameter zlibLevel("ZlibLevel",
                              -1, -1, -1);
 
 ZRLEEncoder::ZRLEEncoder(SConnection* conn_)
-  : Encoder(conn_, encodingZRLE, EncoderPlain, 127),
-  zos(nullptr, 2), mos(129*1024)
+  : Encoder(conn_, encodingZRLE, EncoderOrdered, 127),
+  zos(nullptr), mos(129*1024), zlibStream(nullptr)
 {
   if (zlibLevel != -1) {
     vlog.info(_("Warning: The ZlibLevel option is deprecated and is "
                 "ignored by the server. The compression level can be "
                 "set by the client instead."));
   }
-  zos.setUnderlying(&mos);
+  zlibStream = new rdr::ZlibOutStream(nullptr, 2);
+  zlibStream->setUnderlying(&mos);
+  zos = zlibStream;
+}
+
+ZRLEEncoder::ZRLEEncoder(SConnection* conn_, int encoding_,
+                         rdr::OutStream* zos_)
+  : Encoder(conn_, encoding_, EncoderOrdered, 127),
+  zos(zos_), mos(129*1024), zlibStream(nullptr)
+{
 }
 
 ZRLEEncoder::~ZRLEEncoder()
 {
-  zos.setUnderlying(nullptr);
+  if (zlibStream != nullptr) {
+    zlibStream->setUnderlying(nullptr);
+    delete zlibStream;
+  }
 }
 
 bool ZRLEEncoder::isSupported()
 {
-  return conn->client.supportsEncoding(encodingZRLE);
+  return conn->client.supportsEncoding(encoding);
 }
 
 void ZRLEEncoder::setCompressLevel(int level)
 {
-  zos.setCompressionLevel(level);
+  zlibStream->setCompressionLevel(level);
 }
 
 void ZRLEEncoder::writeRect(const PixelBuffer* pb, const Palette& palette)
@@ -101,12 +115,12 @@ void ZRLEEncoder::writeRect(const PixelBuffer* pb, const Palette& palette)
     }
   }
 
-  zos.flush();
+  zos->flush();
 
-  os = conn->getOutStream();
+  os = getOutStream();
 
   os->writeU32(mos.length());
-  os->writeBytes(mos.data(), mos.length());
+  os->writeBytesDirect(mos.data(), mos.length());
 
   mos.clear();
 }
@@ -122,16 +136,16 @@ void ZRLEEncoder::writeSolidRect(int width, int height,
   tiles = ((width + 63)/64) * ((height + 63)/64);
 
   while (tiles--) {
-    zos.writeU8(1);
+    zos->writeU8(1);
     writePixels(colour, pf, 1);
   }
 
-  zos.flush();
+  zos->flush();
 
-  os = conn->getOutStream();
+  os = getOutStream();
 
   os->writeU32(mos.length());
-  os->writeBytes(mos.data(), mos.length());
+  os->writeBytesDirect(mos.data(), mos.length());
 
   mos.clear();
 }
@@ -200,7 +214,7 @@ void ZRLEEncoder::writeRawTile(const core::Rect& tile,
 
   buffer = pb->getBuffer(tile, &stride);
 
-  zos.writeU8(0); // Empty palette (i.e. raw pixels)
+  zos->writeU8(0); // Empty palette (i.e. raw pixels)
 
   w = tile.width();
   h = tile.height();
@@ -236,6 +250,22 @@ void ZRLEEncoder::writePalette(const PixelFormat& pf, const Palette& palette)
   writePixels(buffer, pf, palette.size());
 }
 
+inline void ZRLEEncoder::writePaletteRun(uint8_t index, int runLength)
+{
+  if (runLength == 1) {
+    zos->writeU8(index);
+    return;
+  }
+
+  zos->writeU8(index | 0x80);
+
+  while (runLength > 255) {
+    zos->writeU8(255);
+    runLength -= 255;
+  }
+  zos->writeU8(runLength - 1);
+}
+
 void ZRLEEncoder::writePixels(const uint8_t* buffer, const PixelFormat& pf,
                               unsigned int count)
 {
@@ -246,7 +276,7 @@ void ZRLEEncoder::writePixels(const uint8_t* buffer, const PixelFormat& pf,
   pf.bufferFromPixel(pixBuf, maxPixel);
 
   if ((pf.bpp != 32) || ((pixBuf[0] != 0) && (pixBuf[3] != 0))) {
-    zos.writeBytes(buffer, count * (pf.bpp/8));
+    zos->writeBytes(buffer, count * (pf.bpp/8));
     return;
   }
 
@@ -254,7 +284,7 @@ void ZRLEEncoder::writePixels(const uint8_t* buffer, const PixelFormat& pf,
     buffer++;
 
   while (count--) {
-    zos.writeBytes(buffer, 3);
+    zos->writeBytes(buffer, 3);
     buffer += 4;
   }
 }
@@ -270,40 +300,41 @@ void ZRLEEncoder::writePaletteTile(int width, int height,
   };
 
   int bppp;
-  int pad;
 
   assert(palette.size() > 1);
   assert(palette.size() <= 16);
 
-  zos.writeU8(palette.size());
+  zos->writeU8(palette.size());
   writePalette(pf, palette);
 
   bppp = bitsPerPackedPixel[palette.size()-1];
-  pad = stride - width;
 
   for (int i = 0; i < height; i++) {
-    int w;
-
-    uint8_t nbits = 0;
-    uint8_t byte = 0;
-
-    w = width;
-    while (w--) {
-      T pix = *buffer++;
-      uint8_t index = palette.lookup(pix);
-      byte = (byte << bppp) | index;
-      nbits += bppp;
-      if (nbits >= 8) {
-        zos.writeU8(byte);
-        nbits = 0;
-      }
-    }
-    if (nbits > 0) {
-      byte <<= 8 - nbits;
-      zos.writeU8(byte);
+    uint8_t indices[64];
+    uint8_t packed[32];
+    int x;
+
+    assert(width <= 64);
+
+    // Neighbouring pixels are often the same, so look up each run
+    // once rather than every pixel
+    x = 0;
+    while (x < width) {
+      T pix;
+      uint8_t index;
+
+      pix = buffer[x];
+      index = palette.lookup(pix);
+
+      do {
+        indices[x++] = index;
+      } while ((x < width) && (buffer[x] == pix));
     }
 
-    buffer += pad;
+    packIndexRow(indices, packed, width, bppp);
+    zos->writeBytes(packed, (width * bppp + 7) / 8);
+
+    buffer += stride;
   }
 }
 
@@ -313,56 +344,48 @@ void ZRLEEncoder::writePaletteRLETile(int width, int height,
                                       const PixelFormat& pf,
                                       const Palette& palette)
 {
-  int pad;
-
   T prevColour;
   int runLength;
 
   assert(palette.size() > 1);
   assert(palette.size() <= 127);
 
-  zos.writeU8(palette.size() | 0x80);
+  zos->writeU8(palette.size() | 0x80);
   writePalette(pf, palette);
 
-  pad = stride - width;
-
   prevColour = *buffer;
   runLength = 0;
 
+  // Runs carry on from one row to the next
   while (height--) {
-    int w = width;
-    while (w--) {
-      if (prevColour != *buffer) {
-        if (runLength == 1)
-          zos.writeU8(palette.lookup(prevColour));
-        else {
-          zos.writeU8(palette.lookup(prevColour) | 0x80);
-
-          while (runLength > 255) {
-            zos.writeU8(255);
-            runLength -= 255;
-          }
-          zos.writeU8(runLength - 1);
-        }
-
-        prevColour = *buffer;
+    int x, start;
+
+    x = start = 0;
+    while (x < width) {
+      if (buffer[x] != prevColour) {
+        writePaletteRun(palette.lookup(prevColour), runLength);
+
+        prevColour = buffer[x];
         runLength = 0;
+        start = x;
+      } else if (x - start == 8) {
+        int run;
+
+        // Most runs are short, so it's only worth using the vector
+        // code once it looks like this one is going to be long
+        run = countPixels(buffer + x, width - x, prevColour);
+        runLength += run;
+        x += run;
+
+        continue;
       }
 
       runLength++;
-      buffer++;
+      x++;
     }
-    buffer += pad;
-  }
-  if (runLength == 1)
-    zos.writeU8(palette.lookup(prevColour));
-  else {
-    zos.writeU8(palette.lookup(prevColour) | 0x80);
-
-    while (runLength > 255) {
-      zos.writeU8(255);
-      runLength -= 255;
-    }
-    zos.writeU8(runLength - 1);
+
+    buffer += stride;
   }
+
+  writePaletteRun(palette.lookup(prevColour), runLength);
 }
@@ -19,6 +19,8 @@
 #ifndef __RFB_ZRLEENCODER_H__
 #define __RFB_ZRLEENCODER_H__
 
+#include <core/Rect.h>
+
 #include <rdr/MemOutStream.h>
 #include <rdr/ZlibOutStream.h>
 #include <rfb/Encoder.h>
@@ -40,6 +42,9 @@ namespace rfb {
                         const uint8_t* colour) override;
 
   protected:
+    // For variants that only differ in how the data is compressed
+    ZRLEEncoder(SConnection* conn, int encoding, rdr::OutStream* zos);
+
     void writePaletteTile(const core::Rect& tile,
                           const PixelBuffer* pb,
                           const Palette& palette);
@@ -49,6 +54,7 @@ namespace rfb {
     void writeRawTile(const core::Rect& tile, const PixelBuffer* pb);
 
     void writePalette(const PixelFormat& pf, const Palette& palette);
+    void writePaletteRun(uint8_t index, int runLength);
 
     void writePixels(const uint8_t* buffer, const PixelFormat& pf,
                      unsigned int count);
@@ -65,8 +71,11 @@ namespace rfb {
                              const PixelFormat& pf, const Palette& palette);
 
   protected:
-    rdr::ZlibOutStream zos;
+    rdr::OutStream* zos;
     rdr::MemOutStream mos;
+
+  private:
+    rdr::ZlibOutStream* zlibStream;
   };
 }
 #endif
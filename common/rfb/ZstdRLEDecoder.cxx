@@ -0,0 +1,45 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <rfb/ZstdRLEDecoder.h>
+
+using namespace rfb;
+
+ZstdRLEDecoder::ZstdRLEDecoder()
+{
+}
+
+ZstdRLEDecoder::~ZstdRLEDecoder()
+{
+}
+
+rdr::InStream* ZstdRLEDecoder::beginData(rdr::InStream* is, size_t length)
+{
+  zstdStream.setUnderlying(is, length);
+  return &zstdStream;
+}
+
+void ZstdRLEDecoder::endData()
+{
+  zstdStream.flushUnderlying();
+  zstdStream.setUnderlying(nullptr, 0);
+}
@@ -0,0 +1,53 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <rfb/encodings.h>
+#include <rfb/ZstdRLEEncoder.h>
+
+using namespace rfb;
+
+// zstd levels to use for each compression level, chosen to be about
+// as fast as zlib at the same level
+static const int zstdLevels[10] = { -5, -1, 1, 2, 3, 4, 5, 6, 9, 12 };
+
+// Same as the zstd default
+static const int defaultLevel = 3;
+
+ZstdRLEEncoder::ZstdRLEEncoder(SConnection* conn_)
+  : ZRLEEncoder(conn_, encodingZstdRLE, &zstdStream),
+    zstdStream(nullptr, defaultLevel)
+{
+  zstdStream.setUnderlying(&mos);
+}
+
+ZstdRLEEncoder::~ZstdRLEEncoder()
+{
+  zstdStream.setUnderlying(nullptr);
+}
+
+void ZstdRLEEncoder::setCompressLevel(int level)
+{
+  if ((level < 0) || (level > 9))
+    zstdStream.setCompressionLevel(defaultLevel);
+  else
+    zstdStream.setCompressionLevel(zstdLevels[level]);
+}
@@ -0,0 +1,43 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+#ifndef __RFB_ZSTDRLEENCODER_H__
+#define __RFB_ZSTDRLEENCODER_H__
+
+#ifndef HAVE_ZSTD
+#error "This header should not be included without HAVE_ZSTD defined"
+#endif
+
+#include <rdr/ZstdOutStream.h>
+#include <rfb/ZRLEEncoder.h>
+
+namespace rfb {
+
+  // Same tiles as ZRLE, but compressed using Zstandard instead of zlib
+
+  class ZstdRLEEncoder : public ZRLEEncoder {
+  public:
+    ZstdRLEEncoder(SConnection* conn);
+    virtual ~ZstdRLEEncoder();
+
+    void setCompressLevel(int level) override;
+
+  protected:
+    rdr::ZstdOutStream zstdStream;
+  };
+}
+#endif
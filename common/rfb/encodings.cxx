@@ -37,6 +37,7 @@ int rfb::encodingNum(const char* name)
   if (strcasecmp(name, "Tight") == 0)    return encodingTight;
   if (strcasecmp(name, "JPEG") == 0)     return encodingJPEG;
   if (strcasecmp(name, "H.264") == 0)    return encodingH264;
+  if (strcasecmp(name, "ZstdRLE") == 0)  return encodingZstdRLE;
   return -1;
 }
 
@@ -52,6 +53,8 @@ const char* rfb::encodingName(int num)
   case encodingTight:    return "Tight";
   case encodingJPEG:     return "JPEG";
   case encodingH264:     return "H.264";
+  case pseudoEncodingTileCache: return "TileCache";
+  case encodingZstdRLE:  return "ZstdRLE";
   default:               return _("[unknown]");
   }
 }
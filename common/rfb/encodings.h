@@ -31,6 +31,10 @@ namespace rfb {
   const int encodingJPEG = 21;
   const int encodingH264 = 50;
 
+  // TigerVNC-specific, taken from our pseudo-encoding range as we
+  // have no real encoding numbers of our own
+  const int encodingZstdRLE = -319;
+
   const int encodingMax = 255;
 
   const int pseudoEncodingXCursor = -240;
@@ -43,6 +47,8 @@ namespace rfb {
   const int pseudoEncodingFence = -312;
   const int pseudoEncodingContinuousUpdates = -313;
   const int pseudoEncodingCursorWithAlpha = -314;
+  const int pseudoEncodingTileCache = -317;
+  const int pseudoEncodingLargeRA2Messages = -318;
   const int pseudoEncodingQEMUKeyEvent = -258;
   const int pseudoEncodingQEMUAudio = -259;
 
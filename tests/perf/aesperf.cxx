@@ -0,0 +1,219 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+
+/*
+ * This program measures the performance of the AES-EAX streams used
+ * by the RSA-AES security types. Data is written both in smaller
+ * pieces and as large blocks, the same way an update is, and flushed
+ * after each chunk.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef WIN32
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
+
+#include <stdexcept>
+#include <thread>
+
+#include <rdr/AESInStream.h>
+#include <rdr/AESOutStream.h>
+#include <rdr/FdOutStream.h>
+#include <rdr/MemInStream.h>
+#include <rdr/MemOutStream.h>
+
+#include "util.h"
+
+static const size_t dataSize = 64 * 1024 * 1024;
+
+static const int runs = 4;
+
+static const size_t chunkSizes[] = { 1024, 16 * 1024, 1024 * 1024 };
+
+static const int keySizes[] = { 128, 256 };
+
+// The default, and what peers can ask for
+static const size_t messageSizes[] = { 8192,
+                                       rdr::AESOutStream::MaxMessageSize };
+
+static void writeData(rdr::OutStream* os, const uint8_t* data,
+                      size_t chunkSize)
+{
+  for (size_t pos = 0;pos < dataSize;pos += chunkSize) {
+    // Encoders send large blocks directly
+    if (chunkSize >= 64 * 1024)
+      os->writeBytesDirect(data + pos, chunkSize);
+    else
+      os->writeBytes(data + pos, chunkSize);
+    os->flush();
+  }
+}
+
+static void doMemTest(const uint8_t* data, int keySize, size_t chunkSize,
+                      size_t maxMessageSize)
+{
+  uint8_t key[32];
+  rdr::MemOutStream mos(dataSize + dataSize / 64);
+  uint8_t* buffer;
+  float etime, dtime;
+
+  memset(key, 0x5a, sizeof(key));
+
+  startCpuCounter();
+
+  for (int i = 0;i < runs;i++) {
+    rdr::AESOutStream aos(&mos, key, keySize);
+
+    aos.setMaxMessageSize(maxMessageSize);
+
+    mos.clear();
+    writeData(&aos, data, chunkSize);
+  }
+
+  endCpuCounter();
+  etime = getCpuCounter();
+
+  buffer = new uint8_t[chunkSize];
+
+  startCpuCounter();
+
+  for (int i = 0;i < runs;i++) {
+    rdr::MemInStream mis(mos.data(), mos.length());
+    rdr::AESInStream ais(&mis, key, keySize);
+
+    for (size_t pos = 0;pos < dataSize;pos += chunkSize) {
+      if (!ais.hasData(chunkSize))
+        throw std::runtime_error("Encrypted data ended early");
+      ais.readBytes(buffer, chunkSize);
+    }
+  }
+
+  endCpuCounter();
+  dtime = getCpuCounter();
+
+  delete [] buffer;
+
+  printf("%g,%g,%g",
+         (double)dataSize * runs / (1000.0*1000.0) / etime,
+         (double)dataSize * runs / (1000.0*1000.0) / dtime,
+         (double)(mos.length() - dataSize) * 100.0 / dataSize);
+}
+
+#ifndef WIN32
+static void doSocketTest(const uint8_t* data, int keySize,
+                         size_t chunkSize, size_t maxMessageSize)
+{
+  uint8_t key[32];
+  int fds[2];
+  std::thread* reader;
+  float etime;
+
+  memset(key, 0x5a, sizeof(key));
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    throw std::runtime_error("Failed to create socket pair");
+
+  reader = new std::thread([](int fd) {
+    uint8_t buf[65536];
+    while (read(fd, buf, sizeof(buf)) > 0)
+      ;
+  }, fds[1]);
+
+  startCpuCounter();
+
+  for (int i = 0;i < runs;i++) {
+    rdr::FdOutStream fos(fds[0]);
+    rdr::AESOutStream aos(&fos, key, keySize);
+
+    aos.setMaxMessageSize(maxMessageSize);
+
+    writeData(&aos, data, chunkSize);
+
+    while (fos.hasBufferedData())
+      fos.flush();
+  }
+
+  endCpuCounter();
+  etime = getCpuCounter();
+
+  close(fds[0]);
+  reader->join();
+  delete reader;
+  close(fds[1]);
+
+  printf("%g", (double)dataSize * runs / (1000.0*1000.0) / etime);
+}
+#endif
+
+int main(int /*argc*/, char** /*argv*/)
+{
+  time_t t;
+  char datebuffer[256];
+
+  uint8_t* data;
+
+  time(&t);
+  strftime(datebuffer, sizeof(datebuffer), "%Y-%m-%d %H:%M UTC", gmtime(&t));
+
+  printf("# AES-EAX Performance Test %s\n", datebuffer);
+  printf("#\n");
+  printf("# Data: %d MiB\n", (int)(dataSize / 1024 / 1024));
+  printf("#\n");
+  printf("# Note: Results are MB/sec of unencrypted data, and the overhead\n");
+  printf("#       is the size of the framing in percent. The socket test\n");
+  printf("#       includes the CPU time of the reading thread.\n");
+  printf("#\n");
+
+  printf("Key,Message,Chunk,Encrypt,Decrypt,Overhead");
+#ifndef WIN32
+  printf(",Socket");
+#endif
+  printf("\n");
+
+  data = new uint8_t[dataSize];
+  for (size_t i = 0;i < dataSize;i++)
+    data[i] = rand();
+
+  for (int keySize : keySizes) {
+    for (size_t messageSize : messageSizes) {
+      for (size_t chunkSize : chunkSizes) {
+        printf("%d,%d,%d,", keySize, (int)messageSize, (int)chunkSize);
+        doMemTest(data, keySize, chunkSize, messageSize);
+#ifndef WIN32
+        printf(",");
+        doSocketTest(data, keySize, chunkSize, messageSize);
+#endif
+        printf("\n");
+      }
+    }
+  }
+
+  delete [] data;
+
+  return 0;
+}
@@ -0,0 +1,275 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+/*
+ * This program measures the performance of the framebuffer comparison
+ * done by ComparingUpdateTracker, for each of the available
+ * implementations of the comparison kernel, as well as when using
+ * tile hashes. Both methods are also tested when split in to bands
+ * that are compared on multiple threads.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <rfb/BlockCompare.h>
+#include <rfb/ComparingUpdateTracker.h>
+#include <rfb/PixelBuffer.h>
+
+#include "util.h"
+
+static const int fbwidth = 1920;
+static const int fbheight = 1080;
+
+static const int runs = 100;
+
+static const int threads = 4;
+
+static const char *defaultImpl;
+
+static const char *impls[] = {
+  "generic", "sse2", "avx2", "neon",
+};
+
+// Flips between two sets of contents, so that we can present changes
+// to the tracker without spending any time modifying the data
+class FlipPixelBuffer : public rfb::FullFramePixelBuffer {
+public:
+  FlipPixelBuffer(const rfb::PixelFormat& pf, int width, int height)
+    : FullFramePixelBuffer(pf, 0, 0, nullptr, 0), current(0)
+  {
+    for (int i = 0;i < 2;i++)
+      data[i] = new uint8_t[width * height * (pf.bpp/8)];
+    setBuffer(width, height, data[0], width);
+  }
+  ~FlipPixelBuffer()
+  {
+    for (int i = 0;i < 2;i++)
+      delete [] data[i];
+  }
+
+  void flip()
+  {
+    current = !current;
+    setBuffer(width(), height(), data[current], width());
+  }
+
+  uint8_t *data[2];
+
+private:
+  int current;
+};
+
+typedef void (*setupfn) (const rfb::PixelFormat&, uint8_t*, uint8_t*);
+
+struct TestEntry {
+  const char *label;
+  setupfn fn;
+};
+
+static void setupUnchanged(const rfb::PixelFormat& pf,
+                           uint8_t* a, uint8_t* b)
+{
+  size_t i, size;
+
+  size = fbwidth * fbheight * (pf.bpp/8);
+  for (i = 0;i < size;i++)
+    a[i] = rand();
+  memcpy(b, a, size);
+}
+
+// A few pixels in every fourth block, like a blinking cursor or a
+// ticking clock would give
+static void setupSparse(const rfb::PixelFormat& pf,
+                        uint8_t* a, uint8_t* b)
+{
+  int bpp;
+
+  setupUnchanged(pf, a, b);
+
+  bpp = pf.bpp/8;
+  for (int y = 0;y < fbheight;y += 64) {
+    for (int x = (y / 64) % 4 * 64;x < fbwidth;x += 256) {
+      size_t offset;
+      offset = ((y + rand() % 64) * fbwidth + x + rand() % 64) * bpp;
+      if (offset >= (size_t)(fbwidth * fbheight * bpp))
+        continue;
+      b[offset] ^= 0xff;
+    }
+  }
+}
+
+static void setupChanged(const rfb::PixelFormat& pf,
+                         uint8_t* a, uint8_t* b)
+{
+  size_t i, size;
+
+  size = fbwidth * fbheight * (pf.bpp/8);
+  for (i = 0;i < size;i++) {
+    a[i] = rand();
+    b[i] = ~a[i];
+  }
+}
+
+static struct TestEntry tests[] = {
+  {"Unchanged", setupUnchanged},
+  {"Sparse", setupSparse},
+  {"Changed", setupChanged},
+};
+
+static void doTest(const rfb::PixelFormat& pf, setupfn fn,
+                   rfb::ComparingUpdateTracker::CompareMethod method,
+                   int threadCount)
+{
+  FlipPixelBuffer pb(pf, fbwidth, fbheight);
+  rfb::ComparingUpdateTracker tracker(&pb);
+
+  tracker.setMethod(method);
+  tracker.setThreads(threadCount);
+
+  fn(pf, pb.data[0], pb.data[1]);
+
+  // The first round just records the initial contents
+  tracker.compare();
+  tracker.clear();
+
+  // CPU time would include all threads, so we need the wall clock
+  // to see any gain from threading
+  if (threadCount > 1)
+    startTimeCounter();
+  else
+    startCpuCounter();
+
+  for (int i = 0;i < runs;i++) {
+    pb.flip();
+    tracker.add_changed(pb.getRect());
+    tracker.compare();
+    tracker.clear();
+  }
+
+  float data, time;
+
+  if (threadCount > 1) {
+    endTimeCounter();
+    time = getTimeCounter();
+  } else {
+    endCpuCounter();
+    time = getCpuCounter();
+  }
+
+  data = (double)fbwidth * fbheight * runs;
+
+  printf("%g", data / (1000.0*1000.0) / time);
+}
+
+static void doTests(const rfb::PixelFormat& pf)
+{
+  size_t i;
+  char pfb[256];
+
+  pf.print(pfb, sizeof(pfb));
+
+  for (const char* impl : impls) {
+    if (!rfb::setCompareBlockImpl(impl))
+      continue;
+
+    printf("%s,%s", pfb, impl);
+
+    for (i = 0;i < sizeof(tests)/sizeof(tests[0]);i++) {
+      printf(",");
+      doTest(pf, tests[i].fn, rfb::ComparingUpdateTracker::CompareCopy, 1);
+    }
+
+    printf("\n");
+  }
+
+  // The remaining tests use whatever would normally be used
+  rfb::setCompareBlockImpl(defaultImpl);
+
+  printf("%s,hash", pfb);
+
+  for (i = 0;i < sizeof(tests)/sizeof(tests[0]);i++) {
+    printf(",");
+    doTest(pf, tests[i].fn, rfb::ComparingUpdateTracker::CompareHash, 1);
+  }
+
+  printf("\n");
+
+  printf("%s,copy x%d", pfb, threads);
+
+  for (i = 0;i < sizeof(tests)/sizeof(tests[0]);i++) {
+    printf(",");
+    doTest(pf, tests[i].fn, rfb::ComparingUpdateTracker::CompareCopy,
+           threads);
+  }
+
+  printf("\n");
+
+  printf("%s,hash x%d", pfb, threads);
+
+  for (i = 0;i < sizeof(tests)/sizeof(tests[0]);i++) {
+    printf(",");
+    doTest(pf, tests[i].fn, rfb::ComparingUpdateTracker::CompareHash,
+           threads);
+  }
+
+  printf("\n");
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+  time_t t;
+  char datebuffer[256];
+
+  size_t i;
+
+  time(&t);
+  strftime(datebuffer, sizeof(datebuffer), "%Y-%m-%d %H:%M UTC", gmtime(&t));
+
+  printf("# Framebuffer Comparison Performance Test %s\n", datebuffer);
+  printf("#\n");
+  printf("# Frame buffer: %dx%d pixels\n", fbwidth, fbheight);
+  defaultImpl = rfb::compareBlockImpl();
+
+  printf("# Default implementation: %s\n", defaultImpl);
+  printf("#\n");
+  printf("# Note: Results are Mpixels/sec, and wall clock based for the\n");
+  printf("#       threaded tests\n");
+  printf("#\n");
+
+  printf("Format,Implementation");
+  for (i = 0;i < sizeof(tests)/sizeof(tests[0]);i++)
+    printf(",%s", tests[i].label);
+  printf("\n");
+
+  rfb::PixelFormat pf;
+
+  pf.parse("rgb888");
+  doTests(pf);
+
+  pf.parse("rgb565");
+  doTests(pf);
+
+  return 0;
+}
@@ -22,6 +22,9 @@
  * from the server side from the ServerInit message and forward.
  * It is assumed that the client is using a bgr888 (LE) pixel
  * format.
+ *
+ * It can also measure the functions used to undo the Tight filters,
+ * for each of the available implementations.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -30,6 +33,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <sys/time.h>
 
@@ -41,6 +45,7 @@
 #include <rfb/CMsgWriter.h>
 #include <rfb/PixelBuffer.h>
 #include <rfb/PixelFormat.h>
+#include <rfb/TightFilter.h>
 
 #include "util.h"
 
@@ -245,6 +250,99 @@ static void sort(double *array, int count)
 
 static const int runCount = 9;
 
+static const int filterWidth = 2048;
+static const int filterRows = 20000;
+
+static const char *filterImpls[] = {
+  "generic", "sse4.1", "avx2", "neon",
+};
+
+static void testGradient(const uint8_t* in)
+{
+  uint8_t rows[2][filterWidth * 3];
+
+  memset(rows[0], 0, sizeof(rows[0]));
+
+  for (int i = 0;i < filterRows;i++)
+    rfb::decodeGradientRow(in, rows[i % 2], rows[(i + 1) % 2],
+                           filterWidth);
+}
+
+static void testMono(const uint8_t* in)
+{
+  uint32_t palette[2] = { 0x000000, 0xffffff };
+  uint32_t out[filterWidth];
+
+  for (int i = 0;i < filterRows;i++)
+    rfb::expandMonoRow(in, palette, out, filterWidth);
+}
+
+static void testPalette(const uint8_t* in)
+{
+  uint32_t palette[256];
+  uint32_t out[filterWidth];
+
+  for (int i = 0;i < 256;i++)
+    palette[i] = i * 0x010101;
+
+  for (int i = 0;i < filterRows;i++)
+    rfb::expandPaletteRow(in, palette, out, filterWidth);
+}
+
+static const struct {
+  const char *label;
+  void (*fn)(const uint8_t*);
+} filterTests[] = {
+  {"Gradient", testGradient},
+  {"Mono", testMono},
+  {"Palette", testPalette},
+};
+
+static void runFilterTests()
+{
+  uint8_t in[filterWidth * 3];
+  const char *defaultImpl;
+  size_t i;
+
+  for (i = 0;i < sizeof(in);i++)
+    in[i] = rand();
+
+  defaultImpl = rfb::tightFilterImpl();
+
+  printf("# Tight Filter Performance Test\n");
+  printf("#\n");
+  printf("# Row width: %d pixels (32 bpp output)\n", filterWidth);
+  printf("# Default implementation: %s\n", defaultImpl);
+  printf("#\n");
+  printf("# Note: Results are Mpixels/sec\n");
+  printf("#\n");
+
+  printf("Implementation");
+  for (i = 0;i < sizeof(filterTests)/sizeof(filterTests[0]);i++)
+    printf(",%s", filterTests[i].label);
+  printf("\n");
+
+  for (const char* impl : filterImpls) {
+    if (!rfb::setTightFilterImpl(impl))
+      continue;
+
+    printf("%s", impl);
+
+    for (i = 0;i < sizeof(filterTests)/sizeof(filterTests[0]);i++) {
+      startCpuCounter();
+      filterTests[i].fn(in);
+      endCpuCounter();
+
+      printf(",%g", (double)filterWidth * filterRows /
+                    (1000.0*1000.0) / getCpuCounter());
+    }
+
+    printf("\n");
+  }
+
+  rfb::setTightFilterImpl(defaultImpl);
+}
+
 int main(int argc, char **argv)
 {
   int i;
@@ -254,9 +352,15 @@ int main(int argc, char **argv)
 
   if (argc != 2) {
     printf("Syntax: %s <rfb file>\n", argv[0]);
+    printf("        %s -filters\n", argv[0]);
     return 1;
   }
 
+  if (strcmp(argv[1], "-filters") == 0) {
+    runFilterTests();
+    return 0;
+  }
+
   // Warmup
   runTest(argv[1]);
 
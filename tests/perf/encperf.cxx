@@ -37,6 +37,8 @@
 #include <math.h>
 #include <sys/time.h>
 
+#include <vector>
+
 #include <core/Configuration.h>
 
 #include <rdr/OutStream.h>
@@ -49,6 +51,7 @@
 #include <rfb/CMsgWriter.h>
 #include <rfb/UpdateTracker.h>
 #include <rfb/EncodeManager.h>
+#include <rfb/PixelScan.h>
 #include <rfb/SConnection.h>
 #include <rfb/SMsgWriter.h>
 
@@ -64,10 +67,18 @@ static core::BoolParameter translate("translate",
                                      "Translate 8-bit and 16-bit datasets into 24-bit",
                                      true);
 
+static core::StringParameter useEncoding("encoding",
+                                         "Encoding to use (e.g. zrle)",
+                                         "tight");
+
+static core::StringParameter scanImpl("scanimpl",
+                                      "Pixel scan implementation (e.g. generic)",
+                                      "");
+
 // The frame buffer (and output) is always this format
 static const rfb::PixelFormat fbPF(32, 24, false, true, 255, 255, 255, 0, 8, 16);
 
-// Encodings to use
+// Encodings to use, after the one given as a parameter
 static const int32_t encodings[] = {
   rfb::encodingTight, rfb::encodingCopyRect, rfb::encodingRRE,
   rfb::encodingHextile, rfb::encodingZRLE, rfb::pseudoEncodingLastRect,
@@ -200,7 +211,11 @@ CConn::CConn(const char *filename)
 
   sc = new SConn();
   sc->client.setPF((bool)translate ? fbPF : pf);
-  ((rfb::SMsgHandler*)sc)->setEncodings(sizeof(encodings) / sizeof(*encodings), encodings);
+  std::vector<int32_t> encs;
+  encs.push_back(rfb::encodingNum(useEncoding));
+  encs.insert(encs.end(), encodings,
+              encodings + sizeof(encodings) / sizeof(*encodings));
+  ((rfb::SMsgHandler*)sc)->setEncodings(encs.size(), encs.data());
 }
 
 CConn::~CConn()
@@ -501,6 +516,16 @@ int main(int argc, char **argv)
     usage(argv[0]);
   }
 
+  if (rfb::encodingNum(useEncoding) == -1) {
+    fprintf(stderr, "Unknown encoding!\n\n");
+    usage(argv[0]);
+  }
+
+  if ((strcmp(scanImpl, "") != 0) && !rfb::setPixelScanImpl(scanImpl)) {
+    fprintf(stderr, "Pixel scan implementation not supported!\n\n");
+    usage(argv[0]);
+  }
+
   // Warmup
   runTest(fn);
 
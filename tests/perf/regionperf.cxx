@@ -0,0 +1,128 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+/*
+ * This program measures the cost of the core::Region operations used
+ * when tracking damage. Lots of small, scattered rects are used, the
+ * same way text rendering or spinners fragment the changed region,
+ * on a framebuffer wider than what fits in 16-bit coordinates.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include <core/Region.h>
+
+#include "util.h"
+
+static const int width = 40960;
+static const int height = 2160;
+
+static const int runs = 10;
+
+static const size_t rectCounts[] = { 10, 100, 1000, 10000 };
+
+static core::Rect randomRect()
+{
+  int x, y;
+
+  // Roughly the size of a glyph
+  x = rand() % (width - 16);
+  y = rand() % (height - 16);
+
+  return {x, y, x + 4 + rand() % 12, y + 8 + rand() % 8};
+}
+
+static void doTest(size_t count)
+{
+  std::vector<core::Rect> added, removed, rects;
+  core::Region damage;
+  double utime, stime, gtime;
+  size_t total;
+
+  for (size_t i = 0;i < count;i++) {
+    added.push_back(randomRect());
+    removed.push_back(randomRect());
+  }
+
+  utime = stime = gtime = 0;
+  total = 0;
+
+  for (int run = 0;run < runs;run++) {
+    core::Region region;
+
+    startCpuCounter();
+    for (const core::Rect& r : added)
+      region.assign_union(r);
+    endCpuCounter();
+    utime += getCpuCounter();
+
+    damage = region;
+
+    startCpuCounter();
+    for (const core::Rect& r : removed)
+      region.assign_subtract(r);
+    endCpuCounter();
+    stime += getCpuCounter();
+
+    startCpuCounter();
+    damage.get_rects(&rects);
+    endCpuCounter();
+    gtime += getCpuCounter();
+
+    total += rects.size();
+  }
+
+  printf("%d,%d,%g,%g,%g\n", (int)count, (int)(total / runs),
+         utime * 1e9 / runs / count, stime * 1e9 / runs / count,
+         gtime * 1e9 / runs / (total / runs));
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+  time_t t;
+  char datebuffer[256];
+
+  time(&t);
+  strftime(datebuffer, sizeof(datebuffer), "%Y-%m-%d %H:%M UTC", gmtime(&t));
+
+  printf("# Region Performance Test %s\n", datebuffer);
+  printf("#\n");
+  printf("# Framebuffer: %dx%d\n", width, height);
+  printf("# Runs: %d\n", runs);
+  printf("#\n");
+  printf("# Note: Results are nanoseconds per rect. Boxes is the number\n");
+  printf("#       of rects the damage was split into.\n");
+  printf("#\n");
+
+  printf("Rects,Boxes,Union,Subtract,Get\n");
+
+  srand(0);
+
+  for (size_t count : rectCounts)
+    doTest(count);
+
+  return 0;
+}
@@ -0,0 +1,126 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+
+/*
+ * This program measures the cost of managing core::Timer objects when
+ * many of them are running, as happens with many connected clients.
+ * Random timers are restarted with random timeouts, the same way the
+ * per-connection timers are re-armed on every update.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <vector>
+
+#include <core/Timer.h>
+
+#include "util.h"
+
+static const int operations = 1000000;
+
+static const size_t timerCounts[] = { 10, 100, 1000, 10000 };
+
+class DummyTimer : public core::Timer, public core::Timer::Callback {
+public:
+  DummyTimer() : core::Timer(this) {}
+  void handleTimeout(core::Timer*) override {}
+};
+
+static void doTest(size_t count)
+{
+  std::vector<DummyTimer*> timers;
+  std::vector<int> picks, timeouts;
+  double stime, ptime, ntime;
+  int next;
+
+  // Long timeouts so that nothing fires during the test
+  for (size_t i = 0;i < count;i++) {
+    timers.push_back(new DummyTimer());
+    timers.back()->start(60000 + rand() % 60000);
+  }
+
+  for (int i = 0;i < operations;i++) {
+    picks.push_back(rand() % count);
+    timeouts.push_back(60000 + rand() % 60000);
+  }
+
+  startCpuCounter();
+  for (int i = 0;i < operations;i++)
+    timers[picks[i]]->start(timeouts[i]);
+  endCpuCounter();
+  stime = getCpuCounter();
+
+  startCpuCounter();
+  for (int i = 0;i < operations;i++) {
+    timers[picks[i]]->stop();
+    timers[picks[i]]->start(timeouts[i]);
+  }
+  endCpuCounter();
+  ptime = getCpuCounter() - stime;
+
+  next = 0;
+  startCpuCounter();
+  for (int i = 0;i < operations;i++)
+    next += core::Timer::getNextTimeout();
+  endCpuCounter();
+  ntime = getCpuCounter();
+
+  printf("%d,%g,%g,%g\n", (int)count,
+         stime * 1e9 / operations, ptime * 1e9 / operations,
+         ntime * 1e9 / operations);
+
+  // Keeps the compiler from dropping the loop
+  if (next == -1)
+    printf("#\n");
+
+  for (DummyTimer* timer : timers)
+    delete timer;
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+  time_t t;
+  char datebuffer[256];
+
+  time(&t);
+  strftime(datebuffer, sizeof(datebuffer), "%Y-%m-%d %H:%M UTC", gmtime(&t));
+
+  printf("# Timer Performance Test %s\n", datebuffer);
+  printf("#\n");
+  printf("# Operations: %d\n", operations);
+  printf("#\n");
+  printf("# Note: Results are nanoseconds per operation. Stop is the cost\n");
+  printf("#       of stopping a timer before restarting it.\n");
+  printf("#\n");
+
+  printf("Timers,Start,Stop,Next\n");
+
+  srand(0);
+
+  for (size_t count : timerCounts)
+    doTest(count);
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+/*
+ * This program measures the performance of the zlib streams, for each
+ * of the available zlib implementations and compression levels. The
+ * data is flushed regularly, the same way the encoders do after each
+ * rect.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <stdexcept>
+
+#include <rdr/MemInStream.h>
+#include <rdr/MemOutStream.h>
+#include <rdr/ZlibBackend.h>
+#include <rdr/ZlibInStream.h>
+#include <rdr/ZlibOutStream.h>
+
+#include "util.h"
+
+static const size_t dataSize = 16 * 1024 * 1024;
+static const size_t chunkSize = 64 * 1024;
+
+static const int runs = 4;
+
+static const char *impls[] = {
+  "zlib-ng", "zlib",
+};
+
+// Roughly what a desktop looks like to the encoders: flat areas,
+// repeated glyph-like patterns and some gradients
+static void fillData(uint8_t* data, size_t size)
+{
+  uint8_t glyphs[16][64];
+
+  for (int i = 0;i < 16;i++) {
+    for (int j = 0;j < 64;j++)
+      glyphs[i][j] = (rand() % 4 == 0) ? 0x20 : 0xf0;
+  }
+
+  for (size_t pos = 0;pos < size;) {
+    size_t len;
+
+    len = 256 + rand() % 4096;
+    if (len > size - pos)
+      len = size - pos;
+
+    switch (rand() % 3) {
+    case 0:
+      memset(data + pos, rand(), len);
+      break;
+    case 1:
+      for (size_t i = 0;i < len;i++)
+        data[pos + i] = glyphs[(i / 64) % 16][i % 64];
+      break;
+    case 2:
+      for (size_t i = 0;i < len;i++)
+        data[pos + i] = i / 16;
+      break;
+    }
+
+    pos += len;
+  }
+}
+
+static void doTest(const uint8_t* data, int level)
+{
+  rdr::MemOutStream mos(dataSize);
+  uint8_t* buffer;
+  float ctime, dtime;
+
+  startCpuCounter();
+
+  for (int i = 0;i < runs;i++) {
+    rdr::ZlibOutStream zos(&mos, level);
+
+    mos.clear();
+
+    for (size_t pos = 0;pos < dataSize;pos += chunkSize) {
+      zos.writeBytes(data + pos, chunkSize);
+      zos.flush();
+    }
+  }
+
+  endCpuCounter();
+  ctime = getCpuCounter();
+
+  buffer = new uint8_t[chunkSize];
+
+  startCpuCounter();
+
+  for (int i = 0;i < runs;i++) {
+    rdr::MemInStream mis(mos.data(), mos.length());
+    rdr::ZlibInStream zis;
+
+    zis.setUnderlying(&mis, mos.length());
+
+    for (size_t pos = 0;pos < dataSize;pos += chunkSize) {
+      if (!zis.hasData(chunkSize))
+        throw std::runtime_error("Compressed data ended early");
+      zis.readBytes(buffer, chunkSize);
+    }
+
+    zis.flushUnderlying();
+  }
+
+  endCpuCounter();
+  dtime = getCpuCounter();
+
+  delete [] buffer;
+
+  printf("%g,%g,%g",
+         (double)dataSize * runs / (1000.0*1000.0) / ctime,
+         (double)dataSize * runs / (1000.0*1000.0) / dtime,
+         (double)dataSize / mos.length());
+}
+
+int main(int /*argc*/, char** /*argv*/)
+{
+  time_t t;
+  char datebuffer[256];
+
+  uint8_t* data;
+
+  time(&t);
+  strftime(datebuffer, sizeof(datebuffer), "%Y-%m-%d %H:%M UTC", gmtime(&t));
+
+  printf("# Zlib Performance Test %s\n", datebuffer);
+  printf("#\n");
+  printf("# Data: %d MiB in %d KiB chunks\n",
+         (int)(dataSize / 1024 / 1024), (int)(chunkSize / 1024));
+  printf("# Default implementation: %s\n", rdr::zlibImpl());
+  printf("#\n");
+  printf("# Note: Results are MB/sec of uncompressed data\n");
+  printf("#\n");
+
+  printf("Implementation,Level,Compress,Decompress,Ratio\n");
+
+  data = new uint8_t[dataSize];
+  fillData(data, dataSize);
+
+  for (const char* impl : impls) {
+    if (!rdr::setZlibImpl(impl))
+      continue;
+
+    for (int level = 0;level <= 9;level++) {
+      printf("%s,%d,", impl, level);
+      doTest(data, level);
+      printf("\n");
+    }
+  }
+
+  delete [] data;
+
+  return 0;
+}
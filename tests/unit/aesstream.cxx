@@ -0,0 +1,111 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rdr/AESInStream.h>
+#include <rdr/AESOutStream.h>
+#include <rdr/MemInStream.h>
+#include <rdr/MemOutStream.h>
+
+static const uint8_t key[32] = { 0x5a };
+
+// Returns the length of every message in the encrypted stream
+static std::vector<size_t> messageSizes(rdr::MemOutStream* mos)
+{
+  std::vector<size_t> sizes;
+  const uint8_t* data;
+  size_t pos;
+
+  data = (const uint8_t*)mos->data();
+  pos = 0;
+  while (pos < mos->length()) {
+    size_t length;
+
+    length = data[pos] << 8 | data[pos + 1];
+    sizes.push_back(length);
+    pos += 2 + length + 16;
+  }
+
+  EXPECT_EQ(pos, mos->length());
+
+  return sizes;
+}
+
+static void roundTrip(size_t maxMessageSize, size_t expectedSize)
+{
+  std::vector<uint8_t> data(200000), result(200000);
+  rdr::MemOutStream mos;
+  std::vector<size_t> sizes;
+
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = i * 7 + i / 251;
+
+  rdr::AESOutStream aos(&mos, key, 128);
+  if (maxMessageSize != 0)
+    aos.setMaxMessageSize(maxMessageSize);
+
+  // Both small writes and large blocks
+  aos.writeBytes(data.data(), 1000);
+  aos.writeBytesDirect(data.data() + 1000, data.size() - 1000);
+  aos.flush();
+
+  sizes = messageSizes(&mos);
+  ASSERT_FALSE(sizes.empty());
+  for (size_t size : sizes)
+    EXPECT_LE(size, expectedSize);
+  EXPECT_EQ(*std::max_element(sizes.begin(), sizes.end()), expectedSize);
+
+  rdr::MemInStream mis(mos.data(), mos.length());
+  rdr::AESInStream ais(&mis, key, 128);
+
+  ASSERT_TRUE(ais.hasData(result.size()));
+  ais.readBytes(result.data(), result.size());
+  EXPECT_EQ(memcmp(data.data(), result.data(), data.size()), 0);
+}
+
+TEST(AESStream, defaultMessageSize)
+{
+  roundTrip(0, 8192);
+}
+
+TEST(AESStream, largeMessageSize)
+{
+  roundTrip(rdr::AESOutStream::MaxMessageSize,
+            rdr::AESOutStream::MaxMessageSize);
+}
+
+TEST(AESStream, invalidMessageSize)
+{
+  rdr::MemOutStream mos;
+  rdr::AESOutStream aos(&mos, key, 128);
+
+  EXPECT_THROW(aos.setMaxMessageSize(0), std::out_of_range);
+  EXPECT_THROW(aos.setMaxMessageSize(65536), std::out_of_range);
+}
@@ -0,0 +1,128 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rfb/BlockCompare.h>
+
+static const int stride = 1100;
+static const int height = 64;
+
+static const char* impls[] = { "generic", "sse2", "avx2", "neon" };
+
+static void randomData(std::vector<uint8_t>* oldData,
+                       std::vector<uint8_t>* newData)
+{
+  oldData->resize(stride * height);
+  for (size_t i = 0; i < oldData->size(); i++)
+    (*oldData)[i] = rand();
+  *newData = *oldData;
+}
+
+TEST(BlockCompare, unchanged)
+{
+  std::vector<uint8_t> oldData, newData;
+  core::Rect changed;
+
+  randomData(&oldData, &newData);
+
+  for (const char* impl : impls) {
+    if (!rfb::setCompareBlockImpl(impl))
+      continue;
+
+    for (int width = 1; width <= rfb::BlockCompareMaxWidth; width++) {
+      EXPECT_FALSE(rfb::compareBlock(oldData.data(), stride,
+                                     newData.data(), stride,
+                                     width, height, &changed))
+        << impl << " with width " << width;
+    }
+  }
+}
+
+TEST(BlockCompare, bounds)
+{
+  const int G = rfb::BlockCompareGranularity;
+
+  std::vector<uint8_t> oldData, newData;
+
+  randomData(&oldData, &newData);
+
+  for (const char* impl : impls) {
+    if (!rfb::setCompareBlockImpl(impl))
+      continue;
+
+    for (int i = 0; i < 2000; i++) {
+      int width, x1, y1, x2, y2;
+      core::Rect changed;
+
+      width = 1 + rand() % rfb::BlockCompareMaxWidth;
+
+      x1 = rand() % width;
+      y1 = rand() % height;
+      x2 = x1 + rand() % (width - x1);
+      y2 = y1 + rand() % (height - y1);
+
+      newData[y1 * stride + x1] ^= 0x01;
+      newData[y2 * stride + x2] ^= 0x80;
+
+      ASSERT_TRUE(rfb::compareBlock(oldData.data(), stride,
+                                    newData.data(), stride,
+                                    width, height, &changed))
+        << impl;
+
+      EXPECT_EQ(changed.tl.x, x1 / G * G) << impl;
+      EXPECT_EQ(changed.tl.y, y1) << impl;
+      EXPECT_EQ(changed.br.x, std::min(width, (x2 / G + 1) * G)) << impl;
+      EXPECT_EQ(changed.br.y, y2 + 1) << impl;
+
+      // Changes should have been copied over
+      EXPECT_EQ(oldData, newData) << impl;
+    }
+  }
+}
+
+TEST(BlockCompare, outside)
+{
+  std::vector<uint8_t> oldData, newData;
+  core::Rect changed;
+
+  randomData(&oldData, &newData);
+
+  // Only the given width should be considered
+  newData[100] ^= 0xff;
+
+  for (const char* impl : impls) {
+    if (!rfb::setCompareBlockImpl(impl))
+      continue;
+
+    EXPECT_FALSE(rfb::compareBlock(oldData.data(), stride,
+                                   newData.data(), stride,
+                                   100, height, &changed))
+      << impl;
+    EXPECT_NE(oldData[100], newData[100]) << impl;
+  }
+}
@@ -0,0 +1,287 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+
+#include <gtest/gtest.h>
+
+#include <rfb/ComparingUpdateTracker.h>
+
+static const rfb::PixelFormat fbPF(32, 24, false, true,
+                                   255, 255, 255, 16, 8, 0);
+
+static const rfb::ComparingUpdateTracker::CompareMethod methods[] = {
+  rfb::ComparingUpdateTracker::CompareCopy,
+  rfb::ComparingUpdateTracker::CompareHash,
+};
+
+static void fillRandom(rfb::ManagedPixelBuffer* pb)
+{
+  uint32_t* data;
+  int stride;
+
+  data = (uint32_t*)pb->getBufferRW(pb->getRect(), &stride);
+  for (int y = 0; y < pb->height(); y++) {
+    for (int x = 0; x < pb->width(); x++)
+      data[y * stride + x] = rand();
+  }
+  pb->commitBufferRW(pb->getRect());
+}
+
+static void fillRandom(rfb::ManagedPixelBuffer* pb, const core::Rect& r)
+{
+  uint32_t* data;
+  int stride;
+
+  data = (uint32_t*)pb->getBufferRW(r, &stride);
+  for (int y = 0; y < r.height(); y++) {
+    for (int x = 0; x < r.width(); x++)
+      data[y * stride + x] = rand();
+  }
+  pb->commitBufferRW(r);
+}
+
+static void setPixel(rfb::ManagedPixelBuffer* pb, int x, int y,
+                     uint32_t value)
+{
+  uint32_t* data;
+  int stride;
+
+  data = (uint32_t*)pb->getBufferRW({x, y, x + 1, y + 1}, &stride);
+  *data = value;
+  pb->commitBufferRW({x, y, x + 1, y + 1});
+}
+
+static uint32_t getPixel(rfb::ManagedPixelBuffer* pb, int x, int y)
+{
+  const uint32_t* data;
+  int stride;
+
+  data = (const uint32_t*)pb->getBuffer({x, y, x + 1, y + 1}, &stride);
+  return *data;
+}
+
+static core::Region compare(rfb::ComparingUpdateTracker* tracker,
+                            const core::Region& changed)
+{
+  rfb::UpdateInfo ui;
+
+  tracker->add_changed(changed);
+  tracker->compare();
+  tracker->getUpdateInfo(&ui, {{0, 0, 1000, 1000}});
+  tracker->clear();
+
+  return ui.changed;
+}
+
+TEST(ComparingUpdateTracker, unchanged)
+{
+  for (auto method : methods) {
+    rfb::ManagedPixelBuffer pb(fbPF, 300, 200);
+    rfb::ComparingUpdateTracker tracker(&pb);
+
+    fillRandom(&pb);
+
+    tracker.setMethod(method);
+    compare(&tracker, pb.getRect());
+
+    EXPECT_TRUE(compare(&tracker, pb.getRect()).is_empty());
+  }
+}
+
+TEST(ComparingUpdateTracker, changed)
+{
+  for (auto method : methods) {
+    rfb::ManagedPixelBuffer pb(fbPF, 300, 200);
+    rfb::ComparingUpdateTracker tracker(&pb);
+    core::Region changed;
+
+    fillRandom(&pb);
+
+    tracker.setMethod(method);
+    compare(&tracker, pb.getRect());
+
+    // Changes are found, and kept to the block they are in
+    for (int i = 0; i < 10; i++) {
+      int x, y;
+
+      x = rand() % pb.width();
+      y = rand() % pb.height();
+
+      setPixel(&pb, x, y, ~getPixel(&pb, x, y));
+
+      changed = compare(&tracker, pb.getRect());
+      EXPECT_FALSE(changed.intersect({{x, y, x + 1, y + 1}}).is_empty());
+      EXPECT_LE(changed.get_bounding_rect().width(), 64);
+      EXPECT_LE(changed.get_bounding_rect().height(), 64);
+    }
+
+    // Only the given region is considered
+    setPixel(&pb, 10, 10, ~getPixel(&pb, 10, 10));
+    setPixel(&pb, 20, 20, ~getPixel(&pb, 20, 20));
+    changed = compare(&tracker, {{0, 0, 15, 15}});
+    EXPECT_TRUE(changed.intersect({{20, 20, 21, 21}}).is_empty());
+    EXPECT_FALSE(changed.intersect({{10, 10, 11, 11}}).is_empty());
+  }
+}
+
+TEST(ComparingUpdateTracker, copied)
+{
+  for (auto method : methods) {
+    rfb::ManagedPixelBuffer pb(fbPF, 300, 200);
+    rfb::ManagedPixelBuffer saved(fbPF, 100, 100);
+    rfb::ComparingUpdateTracker tracker(&pb);
+    const core::Rect dest(100, 100, 200, 200);
+    const uint8_t* data;
+    int stride;
+
+    fillRandom(&pb);
+
+    tracker.setMethod(method);
+    compare(&tracker, pb.getRect());
+
+    data = pb.getBuffer(dest, &stride);
+    saved.imageRect(saved.getRect(), data, stride);
+
+    // Move some content around, which the tracker doesn't check...
+    pb.copyRect(dest, {100, 100});
+    tracker.add_copied(dest, {100, 100});
+    tracker.compare();
+    tracker.clear();
+
+    // ...and then restore what was there before, which means that
+    // the client has something else
+    data = saved.getBuffer(saved.getRect(), &stride);
+    pb.imageRect(dest, data, stride);
+
+    EXPECT_EQ(compare(&tracker, dest), core::Region(dest));
+  }
+}
+
+TEST(ComparingUpdateTracker, bands)
+{
+  for (auto method : methods) {
+    rfb::ManagedPixelBuffer pb(fbPF, 640, 480);
+    rfb::ComparingUpdateTracker serial(&pb);
+    rfb::ComparingUpdateTracker banded(&pb);
+
+    fillRandom(&pb);
+
+    serial.setMethod(method);
+    banded.setMethod(method);
+    banded.setThreads(4);
+
+    compare(&serial, pb.getRect());
+    compare(&banded, pb.getRect());
+
+    // Changes in every band are found, no matter which thread
+    // compared them
+    for (int i = 0; i < 10; i++) {
+      core::Region changed;
+
+      for (int j = 0; j < 20; j++) {
+        int x, y;
+
+        x = rand() % pb.width();
+        y = rand() % pb.height();
+
+        setPixel(&pb, x, y, ~getPixel(&pb, x, y));
+      }
+
+      changed = compare(&serial, pb.getRect());
+      EXPECT_FALSE(changed.is_empty());
+      EXPECT_EQ(compare(&banded, pb.getRect()), changed);
+    }
+  }
+}
+
+TEST(ComparingUpdateTracker, scroll)
+{
+  rfb::ManagedPixelBuffer pb(fbPF, 300, 200);
+  rfb::ComparingUpdateTracker tracker(&pb);
+  rfb::UpdateInfo ui;
+
+  fillRandom(&pb);
+
+  tracker.setScrollDetection(true);
+  compare(&tracker, pb.getRect());
+
+  // Vertical, with new content in the uncovered area
+  pb.copyRect({0, 0, 300, 180}, {0, -20});
+  fillRandom(&pb, {0, 180, 300, 200});
+
+  tracker.add_changed(pb.getRect());
+  EXPECT_TRUE(tracker.compare());
+  tracker.getUpdateInfo(&ui, pb.getRect());
+  tracker.clear();
+
+  EXPECT_EQ(ui.copied, core::Region({0, 0, 300, 180}));
+  EXPECT_EQ(ui.copy_delta, core::Point(0, -20));
+  EXPECT_EQ(ui.changed, core::Region({0, 180, 300, 200}));
+
+  // Horizontal
+  pb.copyRect({12, 0, 300, 200}, {12, 0});
+  fillRandom(&pb, {0, 0, 12, 200});
+
+  tracker.add_changed(pb.getRect());
+  EXPECT_TRUE(tracker.compare());
+  tracker.getUpdateInfo(&ui, pb.getRect());
+  tracker.clear();
+
+  EXPECT_EQ(ui.copied, core::Region({12, 0, 300, 200}));
+  EXPECT_EQ(ui.copy_delta, core::Point(12, 0));
+  EXPECT_EQ(ui.changed, core::Region({0, 0, 12, 200}));
+}
+
+TEST(ComparingUpdateTracker, noScroll)
+{
+  rfb::ManagedPixelBuffer pb(fbPF, 300, 200);
+  rfb::ComparingUpdateTracker tracker(&pb);
+  rfb::UpdateInfo ui;
+
+  fillRandom(&pb);
+
+  tracker.setScrollDetection(true);
+  compare(&tracker, pb.getRect());
+
+  // Entirely new content has nothing in common with the old
+  fillRandom(&pb);
+
+  tracker.add_changed(pb.getRect());
+  tracker.compare();
+  tracker.getUpdateInfo(&ui, pb.getRect());
+  tracker.clear();
+
+  EXPECT_TRUE(ui.copied.is_empty());
+  EXPECT_EQ(ui.changed, core::Region(pb.getRect()));
+
+  // Existing copies are left alone
+  pb.copyRect({100, 100, 200, 180}, {0, -20});
+
+  tracker.add_copied({{100, 100, 200, 180}}, {0, -20});
+  tracker.add_changed(pb.getRect());
+  tracker.compare();
+  tracker.getUpdateInfo(&ui, pb.getRect());
+  tracker.clear();
+
+  EXPECT_EQ(ui.copied, core::Region({100, 100, 200, 180}));
+}
@@ -0,0 +1,92 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include <core/Region.h>
+
+#include <rfb/EncodeCache.h>
+
+static const uint8_t data[] = { 1, 2, 3, 4 };
+
+TEST(EncodeCache, lookup)
+{
+  rfb::EncodeCache cache;
+  const std::vector<uint8_t>* result;
+  int type;
+
+  EXPECT_EQ(cache.lookup({0, 0, 10, 10}, {1, 2}, &type), nullptr);
+
+  cache.insert({0, 0, 10, 10}, {1, 2}, 3, data, sizeof(data));
+
+  result = cache.lookup({0, 0, 10, 10}, {1, 2}, &type);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(type, 3);
+  EXPECT_EQ(*result, std::vector<uint8_t>(data, data + sizeof(data)));
+
+  EXPECT_FALSE(cache.contains({0, 0, 10, 11}, {1, 2}));
+  EXPECT_FALSE(cache.contains({0, 0, 10, 10}, {1, 3}));
+  EXPECT_TRUE(cache.contains({0, 0, 10, 10}, {1, 2}));
+}
+
+TEST(EncodeCache, invalidate)
+{
+  rfb::EncodeCache cache;
+  core::Region changed;
+
+  cache.insert({0, 0, 10, 10}, {1}, 0, data, sizeof(data));
+  cache.insert({20, 0, 30, 10}, {1}, 0, data, sizeof(data));
+  cache.insert({40, 0, 50, 10}, {1}, 0, data, sizeof(data));
+
+  changed.assign_union({{5, 5, 6, 6}});
+  changed.assign_union({{45, 9, 60, 20}});
+  cache.invalidate(changed);
+
+  EXPECT_FALSE(cache.contains({0, 0, 10, 10}, {1}));
+  EXPECT_TRUE(cache.contains({20, 0, 30, 10}, {1}));
+  EXPECT_FALSE(cache.contains({40, 0, 50, 10}, {1}));
+
+  cache.clear();
+
+  EXPECT_FALSE(cache.contains({20, 0, 30, 10}, {1}));
+}
+
+TEST(EncodeCache, shared)
+{
+  rfb::EncodeCache cache;
+  int a, b, c;
+
+  cache.setParams((rfb::EncodeManager*)&a, {1});
+  cache.setParams((rfb::EncodeManager*)&b, {2});
+  EXPECT_FALSE(cache.isShared({1}));
+
+  cache.setParams((rfb::EncodeManager*)&c, {1});
+  EXPECT_TRUE(cache.isShared({1}));
+  EXPECT_FALSE(cache.isShared({2}));
+
+  cache.setParams((rfb::EncodeManager*)&a, {2});
+  EXPECT_FALSE(cache.isShared({1}));
+  EXPECT_TRUE(cache.isShared({2}));
+
+  cache.removeUser((rfb::EncodeManager*)&b);
+  EXPECT_FALSE(cache.isShared({2}));
+}
@@ -0,0 +1,366 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <core/ThreadPool.h>
+
+#include <rdr/BufferedInStream.h>
+#include <rdr/MemOutStream.h>
+
+#include <rfb/CConnection.h>
+#include <rfb/CMsgReader.h>
+#include <rfb/CMsgWriter.h>
+#include <rfb/EncodeManager.h>
+#include <rfb/encodings.h>
+#include <rfb/msgTypes.h>
+#include <rfb/PixelBuffer.h>
+#include <rfb/SConnection.h>
+#include <rfb/SMsgWriter.h>
+#include <rfb/ServerCore.h>
+#include <rfb/UpdateTracker.h>
+
+static const rfb::PixelFormat fbPF(32, 24, false, true,
+                                   255, 255, 255, 16, 8, 0);
+
+class TestConnection : public rfb::SConnection,
+                       public rfb::EncodeManager::UpdateCallback {
+public:
+  TestConnection(core::ThreadPool* pool=nullptr)
+    : rfb::SConnection(rfb::AccessDefault), manager(this, nullptr, pool)
+  {
+    if (pipe(notifyFds) < 0)
+      notifyFds[0] = notifyFds[1] = -1;
+
+    setStreams(nullptr, &out);
+    setWriter(new rfb::SMsgWriter(&client, &out));
+
+    client.setDimensions(100, 100);
+    client.setPF(fbPF);
+  }
+
+  ~TestConnection()
+  {
+    ::close(notifyFds[0]);
+    ::close(notifyFds[1]);
+  }
+
+  // Does the same as VNCServerST::notifyUpdateFinished()
+  void updateFinished(rfb::EncodeManager*) override
+  {
+    char c = 0;
+    EXPECT_EQ(write(notifyFds[1], &c, 1), 1);
+  }
+
+  // Does the same as VNCSConnectionST::finishUpdateOrClose()
+  bool finishUpdate()
+  {
+    if (!manager.isUpdating() || !manager.isUpdateDone())
+      return false;
+
+    manager.finishUpdate();
+
+    return true;
+  }
+
+  void setAccessRights(rfb::AccessRights) override {}
+  void setDesktopSize(int, int, const rfb::ScreenSet&) override {}
+  void keyEvent(uint32_t, uint32_t, bool) override {}
+  void pointerEvent(const core::Point&, uint16_t) override {}
+
+  rdr::MemOutStream out;
+  rfb::EncodeManager manager;
+  int notifyFds[2];
+};
+
+// Hands over whatever the server has written so far
+class LoopbackInStream : public rdr::BufferedInStream {
+public:
+  LoopbackInStream(rdr::MemOutStream* source_)
+    : source(source_), offset(0) {}
+
+private:
+  bool fillBuffer() override
+  {
+    size_t len;
+
+    len = source->length() - offset;
+    if (len == 0)
+      return false;
+    if (len > availSpace())
+      len = availSpace();
+
+    memcpy((uint8_t*)end, (const uint8_t*)source->data() + offset, len);
+    offset += len;
+    end += len;
+
+    return true;
+  }
+
+  rdr::MemOutStream* source;
+  size_t offset;
+};
+
+class TestViewer : public rfb::CConnection {
+public:
+  TestViewer(rdr::MemOutStream* source, int width, int height)
+    : in(source)
+  {
+    setStreams(&in, &out);
+
+    // Skip the handshake
+    setState(RFBSTATE_NORMAL);
+    setReader(new rfb::CMsgReader(this, &in));
+    setWriter(new rfb::CMsgWriter(&server, &out));
+
+    server.setPF(fbPF);
+    setDesktopSize(width, height);
+  }
+
+  void resizeFramebuffer() override
+  {
+    setFramebuffer(new rfb::ManagedPixelBuffer(fbPF, server.width(),
+                                               server.height()));
+  }
+
+  void initDone() override {}
+  void getUserPasswd(bool, std::string*, std::string*) override {}
+  bool verifyCertificate(unsigned int, const uint8_t*, size_t) override
+  {
+    return false;
+  }
+  bool verifyHostKey(const uint8_t*, size_t, const char*) override
+  {
+    return false;
+  }
+  void setColourMapEntries(int, int, uint16_t*) override {}
+  void bell() override {}
+  void serverCutText(const char*) override {}
+
+  const rfb::PixelBuffer* framebuffer() { return getFramebuffer(); }
+
+  LoopbackInStream in;
+  rdr::MemOutStream out;
+};
+
+class VideoEncodeManager : public rfb::EncodeManager {
+public:
+  VideoEncodeManager(rfb::SConnection* conn) : rfb::EncodeManager(conn) {}
+
+  // Fills the classifier's history as if the region had been replaced
+  // at 10 fps for the last couple of seconds
+  void fakeVideo(const core::Region& region, int width, int height)
+  {
+    struct timeval now;
+
+    gettimeofday(&now, nullptr);
+
+    classifier.setSize(width, height);
+    for (int i = 20; i > 0; i--) {
+      struct timeval then;
+      int64_t usec;
+
+      usec = (int64_t)now.tv_sec * 1000000 + now.tv_usec - i * 100000;
+      then.tv_sec = usec / 1000000;
+      then.tv_usec = usec % 1000000;
+
+      classifier.update(region, {}, &then);
+    }
+  }
+};
+
+TEST(EncodeManager, backgroundUpdate)
+{
+  // Our own pool, so that there is a worker even on a single core
+  core::ThreadPool pool(1);
+  rfb::ManagedPixelBuffer pb(fbPF, 100, 100);
+  TestConnection conn(&pool);
+  rfb::UpdateInfo ui;
+
+  ASSERT_NE(conn.notifyFds[0], -1);
+
+  ui.changed = core::Region({0, 0, 100, 100});
+
+  for (int i = 0; i < 100; i++) {
+    char c;
+
+    conn.out.clear();
+
+    conn.manager.startUpdate(ui, &pb, nullptr, &conn);
+    EXPECT_TRUE(conn.manager.isUpdating());
+
+    // A wake up must always be enough to finish the update
+    ASSERT_EQ(read(conn.notifyFds[0], &c, 1), 1);
+    EXPECT_TRUE(conn.finishUpdate());
+    EXPECT_FALSE(conn.manager.isUpdating());
+
+    EXPECT_GT(conn.out.length(), 0U);
+  }
+}
+
+TEST(EncodeManager, backgroundUpdateWithoutWorkers)
+{
+  core::ThreadPool pool(0);
+  rfb::ManagedPixelBuffer pb(fbPF, 100, 100);
+  TestConnection conn(&pool);
+  rfb::UpdateInfo ui;
+  char c;
+
+  ASSERT_NE(conn.notifyFds[0], -1);
+
+  ui.changed = core::Region({0, 0, 100, 100});
+
+  conn.manager.startUpdate(ui, &pb, nullptr, &conn);
+  EXPECT_TRUE(conn.manager.isUpdating());
+
+  // Nothing will pick it up, so it is done by whoever waits for it
+  EXPECT_FALSE(conn.manager.isUpdateDone());
+  conn.manager.finishUpdate();
+  EXPECT_FALSE(conn.manager.isUpdating());
+
+  EXPECT_GT(conn.out.length(), 0U);
+
+  // The callback still has to be called
+  ASSERT_EQ(read(conn.notifyFds[0], &c, 1), 1);
+}
+
+TEST(EncodeManager, threadedEncoding)
+{
+  const int32_t encodings[] = { rfb::encodingTight };
+  const int width = 512, height = 512;
+
+  core::ThreadPool pool(3);
+  rfb::ManagedPixelBuffer pb(fbPF, width, height);
+  rfb::UpdateInfo ui;
+  uint32_t* data;
+  int stride;
+
+  data = (uint32_t*)pb.getBufferRW(pb.getRect(), &stride);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint32_t pixel;
+
+      // Some patterns that compress, and some that don't
+      if ((x / 64 + y / 64) % 2)
+        pixel = (x * 2654435761U) ^ (y * 40503U);
+      else
+        pixel = (x / 4) * 0x010203 + (y / 8) * 0x030201;
+      data[y * stride + x] = pixel & 0xffffff;
+    }
+  }
+  pb.commitBufferRW(pb.getRect());
+
+  // Several rects that are large enough to get a job of their own
+  ui.changed.assign_union(core::Rect(0, 0, 200, 200));
+  ui.changed.assign_union(core::Rect(300, 0, 512, 200));
+  ui.changed.assign_union(core::Rect(0, 300, 200, 512));
+  ui.changed.assign_union(core::Rect(300, 300, 512, 512));
+
+  for (int threads : { 1, 4 }) {
+    SCOPED_TRACE(threads);
+
+    TestConnection conn(&pool);
+    TestViewer viewer(&conn.out, width, height);
+
+    std::vector<core::Rect> rects;
+    const uint8_t* expected;
+    const uint8_t* actual;
+    int expectedStride, actualStride;
+
+    rfb::Server::encodeThreads.setParam(threads);
+
+    conn.client.setDimensions(width, height);
+    conn.client.setEncodings(sizeof(encodings) / sizeof(*encodings),
+                             encodings);
+
+    conn.manager.writeUpdate(ui, &pb, nullptr);
+
+    rfb::Server::encodeThreads.setParam(1);
+
+    while (viewer.processMsg())
+      ;
+
+    // Tight is lossless without a quality level, so each stream has
+    // to decode on its own to exactly what was sent
+    ui.changed.get_rects(&rects);
+    for (const core::Rect& r : rects) {
+      expected = pb.getBuffer(r, &expectedStride);
+      actual = viewer.framebuffer()->getBuffer(r, &actualStride);
+      for (int y = 0; y < r.height(); y++) {
+        ASSERT_EQ(memcmp(expected + y * expectedStride * 4,
+                         actual + y * actualStride * 4,
+                         r.width() * 4), 0)
+          << "Differs on line " << r.tl.y + y;
+      }
+    }
+  }
+}
+
+TEST(EncodeManager, videoWithoutLastRect)
+{
+  const int32_t encodings[] = { rfb::encodingTight,
+                                rfb::pseudoEncodingQualityLevel0 + 8 };
+
+  rfb::ManagedPixelBuffer pb(fbPF, 512, 512);
+  TestConnection conn;
+  VideoEncodeManager manager(&conn);
+  rfb::UpdateInfo ui;
+  uint8_t* buffer;
+  int stride;
+  const uint8_t* data;
+
+  // Something that is neither solid nor a few colours, so that it
+  // ends up with the lossy encoder
+  buffer = pb.getBufferRW(pb.getRect(), &stride);
+  for (int y = 0; y < 512; y++) {
+    for (int x = 0; x < 512; x++) {
+      uint8_t* pixel = buffer + (y * stride + x) * 4;
+      pixel[0] = x;
+      pixel[1] = y;
+      pixel[2] = x ^ y;
+      pixel[3] = 0;
+    }
+  }
+  pb.commitBufferRW(pb.getRect());
+
+  conn.client.setDimensions(512, 512);
+  conn.client.setEncodings(sizeof(encodings) / sizeof(*encodings),
+                           encodings);
+
+  ui.changed = core::Region(pb.getRect());
+
+  manager.fakeVideo(ui.changed, 512, 512);
+
+  // The writer checks that the header matches what was sent
+  ASSERT_NO_THROW(manager.writeUpdate(ui, &pb, nullptr));
+
+  ASSERT_GE(conn.out.length(), 4U);
+  data = conn.out.data();
+  EXPECT_EQ(data[0], rfb::msgTypeFramebufferUpdate);
+  EXPECT_EQ((data[2] << 8) | data[3], 4);
+}
@@ -0,0 +1,174 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include <core/Timer.h>
+#include <core/time.h>
+
+#include <network/EventLoop.h>
+
+class EventLoopTest : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    ASSERT_EQ(pipe(fds), 0);
+  }
+
+  void TearDown() override
+  {
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  int fds[2];
+};
+
+TEST_F(EventLoopTest, read)
+{
+  network::EventLoop loop;
+  char c;
+
+  loop.setFd(fds[0], network::EventRead);
+
+  EXPECT_TRUE(loop.wait(0));
+  EXPECT_EQ(loop.getEvents(fds[0]), 0);
+
+  ASSERT_EQ(write(fds[1], "x", 1), 1);
+
+  EXPECT_TRUE(loop.wait(1000));
+  EXPECT_EQ(loop.getEvents(fds[0]), network::EventRead);
+
+  // Level triggered, so it should be reported until it is read
+  EXPECT_TRUE(loop.wait(1000));
+  EXPECT_EQ(loop.getEvents(fds[0]), network::EventRead);
+
+  ASSERT_EQ(read(fds[0], &c, 1), 1);
+
+  EXPECT_TRUE(loop.wait(0));
+  EXPECT_EQ(loop.getEvents(fds[0]), 0);
+}
+
+TEST_F(EventLoopTest, write)
+{
+  network::EventLoop loop;
+
+  // Writable, but not asked for
+  loop.setFd(fds[1], 0);
+  EXPECT_TRUE(loop.wait(0));
+  EXPECT_EQ(loop.getEvents(fds[1]), 0);
+
+  loop.setFd(fds[1], network::EventWrite);
+  EXPECT_TRUE(loop.wait(1000));
+  EXPECT_EQ(loop.getEvents(fds[1]), network::EventWrite);
+
+  loop.setFd(fds[1], 0);
+  EXPECT_TRUE(loop.wait(0));
+  EXPECT_EQ(loop.getEvents(fds[1]), 0);
+}
+
+TEST_F(EventLoopTest, hangUp)
+{
+  network::EventLoop loop;
+
+  loop.setFd(fds[0], network::EventRead);
+
+  close(fds[1]);
+  fds[1] = open("/dev/null", O_WRONLY);
+
+  // Must be reported so that the end of stream gets noticed
+  EXPECT_TRUE(loop.wait(1000));
+  EXPECT_EQ(loop.getEvents(fds[0]), network::EventRead);
+}
+
+TEST_F(EventLoopTest, remove)
+{
+  network::EventLoop loop;
+
+  loop.setFd(fds[0], network::EventRead);
+  ASSERT_EQ(write(fds[1], "x", 1), 1);
+
+  loop.removeFd(fds[0]);
+  EXPECT_TRUE(loop.wait(0));
+  EXPECT_EQ(loop.getEvents(fds[0]), 0);
+
+  // Should be possible to add it again, e.g. if the number is reused
+  loop.setFd(fds[0], network::EventRead);
+  EXPECT_TRUE(loop.wait(1000));
+  EXPECT_EQ(loop.getEvents(fds[0]), network::EventRead);
+}
+
+TEST_F(EventLoopTest, manyFds)
+{
+  network::EventLoop loop;
+  int high;
+  char c;
+
+  // Numbers above FD_SETSIZE must work
+  high = fcntl(fds[0], F_DUPFD, 2000);
+  if (high < 0)
+    GTEST_SKIP() << "Can't create high file descriptors";
+
+  loop.setFd(high, network::EventRead);
+  ASSERT_EQ(write(fds[1], "x", 1), 1);
+
+  EXPECT_TRUE(loop.wait(1000));
+  EXPECT_EQ(loop.getEvents(high), network::EventRead);
+
+  ASSERT_EQ(read(high, &c, 1), 1);
+
+  loop.removeFd(high);
+  close(high);
+}
+
+class TestTimer : public core::Timer, public core::Timer::Callback {
+public:
+  TestTimer() : core::Timer(this), fired(false) {}
+  void handleTimeout(core::Timer*) override { fired = true; }
+  bool fired;
+};
+
+TEST_F(EventLoopTest, timer)
+{
+  network::EventLoop loop;
+  TestTimer timer;
+  struct timeval start;
+
+  loop.setFd(fds[0], network::EventRead);
+
+  timer.start(50);
+
+  // Should not wait longer than the timer
+  gettimeofday(&start, nullptr);
+  EXPECT_TRUE(loop.wait(-1));
+  EXPECT_LT(core::msSince(&start), 1000);
+  EXPECT_FALSE(timer.fired);
+
+  // The timer is dispatched on the next wait
+  EXPECT_TRUE(loop.wait(0));
+  EXPECT_TRUE(timer.fired);
+}
@@ -0,0 +1,269 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rdr/FdInStream.h>
+#include <rdr/FdOutStream.h>
+
+class FdOutStreamTest : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+  }
+
+  void TearDown() override
+  {
+    close(fds[0]);
+    close(fds[1]);
+  }
+
+  // Reads everything currently waiting on the other end
+  void drain(std::vector<uint8_t>* data)
+  {
+    uint8_t buf[65536];
+    ssize_t n;
+
+    while ((n = recv(fds[1], buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+      data->insert(data->end(), buf, buf + n);
+
+    ASSERT_TRUE((n == 0) || (errno == EAGAIN) || (errno == EWOULDBLOCK));
+  }
+
+  int fds[2];
+};
+
+// Zero copy sending needs a real network socket
+class FdOutStreamTcpTest : public FdOutStreamTest {
+protected:
+  void SetUp() override
+  {
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    int listener;
+
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listener, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addrlen = sizeof(addr);
+    ASSERT_EQ(bind(listener, (struct sockaddr*)&addr, addrlen), 0);
+    ASSERT_EQ(listen(listener, 1), 0);
+    ASSERT_EQ(getsockname(listener, (struct sockaddr*)&addr, &addrlen), 0);
+
+    fds[0] = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(fds[0], 0);
+    ASSERT_EQ(connect(fds[0], (struct sockaddr*)&addr, addrlen), 0);
+    fds[1] = accept(listener, nullptr, nullptr);
+    ASSERT_GE(fds[1], 0);
+
+    close(listener);
+  }
+};
+
+static std::vector<uint8_t> randomData(size_t size)
+{
+  std::vector<uint8_t> data(size);
+
+  for (uint8_t& b : data)
+    b = rand();
+
+  return data;
+}
+
+TEST_F(FdOutStreamTest, small)
+{
+  rdr::FdOutStream out(fds[0]);
+  std::vector<uint8_t> data, received;
+
+  data = randomData(1000);
+
+  // Not worth sending directly, so should end up in the buffer
+  out.writeBytesDirect(data.data(), data.size());
+  EXPECT_TRUE(out.hasBufferedData());
+  EXPECT_EQ(out.length(), data.size());
+
+  out.flush();
+  EXPECT_FALSE(out.hasBufferedData());
+
+  drain(&received);
+  EXPECT_EQ(received, data);
+}
+
+TEST_F(FdOutStreamTest, direct)
+{
+  rdr::FdOutStream out(fds[0]);
+  std::vector<uint8_t> data, expected, received;
+  int size;
+
+  size = 1024 * 1024;
+  ASSERT_EQ(setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF,
+                       &size, sizeof(size)), 0);
+
+  data = randomData(100000);
+
+  // The buffered header should go out first, and together with the
+  // data so nothing is left behind
+  out.writeU32(0x12345678);
+  out.writeBytesDirect(data.data(), data.size());
+  EXPECT_FALSE(out.hasBufferedData());
+  EXPECT_EQ(out.length(), data.size() + 4);
+
+  expected = { 0x12, 0x34, 0x56, 0x78 };
+  expected.insert(expected.end(), data.begin(), data.end());
+
+  drain(&received);
+  EXPECT_EQ(received, expected);
+}
+
+TEST_F(FdOutStreamTest, congested)
+{
+  rdr::FdOutStream out(fds[0]);
+  std::vector<uint8_t> data, expected, received;
+
+  data = randomData(4 * 1024 * 1024);
+
+  expected.push_back(0xaa);
+  expected.insert(expected.end(), data.begin(), data.end());
+  expected.push_back(0x55);
+
+  // Much more than the socket can take, so the rest has to be
+  // buffered and sent later
+  out.writeU8(0xaa);
+  out.writeBytesDirect(data.data(), data.size());
+  out.writeU8(0x55);
+  EXPECT_TRUE(out.hasBufferedData());
+  EXPECT_EQ(out.length(), expected.size());
+
+  // Make sure the stream doesn't hang on to our buffer
+  data.assign(data.size(), 0);
+
+  while (out.hasBufferedData()) {
+    drain(&received);
+    out.flush();
+  }
+  drain(&received);
+
+  EXPECT_EQ(received, expected);
+}
+
+TEST_F(FdOutStreamTest, highFds)
+{
+  std::vector<uint8_t> data, received;
+  int high[2];
+
+  // Numbers above FD_SETSIZE must work
+  high[0] = fcntl(fds[0], F_DUPFD, 2000);
+  high[1] = fcntl(fds[1], F_DUPFD, 2000);
+  if ((high[0] < 0) || (high[1] < 0))
+    GTEST_SKIP() << "Can't create high file descriptors";
+
+  {
+    rdr::FdOutStream out(high[0]);
+    rdr::FdInStream in(high[1]);
+
+    data = randomData(4 * 1024 * 1024);
+
+    // More than the socket can take, so both ends have to wait for
+    // the other one
+    out.writeBytesDirect(data.data(), data.size());
+    EXPECT_TRUE(out.hasBufferedData());
+
+    while (received.size() < data.size()) {
+      size_t avail;
+
+      out.flush();
+
+      if (!in.hasData(1))
+        continue;
+
+      avail = in.avail();
+      received.resize(received.size() + avail);
+      in.readBytes(received.data() + received.size() - avail, avail);
+    }
+
+    EXPECT_FALSE(out.hasBufferedData());
+    EXPECT_FALSE(in.hasData(1));
+  }
+
+  EXPECT_EQ(received, data);
+
+  close(high[0]);
+  close(high[1]);
+}
+
+TEST_F(FdOutStreamTcpTest, zeroCopy)
+{
+  rdr::FdOutStream out(fds[0]);
+  std::shared_ptr<const std::vector<uint8_t>> data;
+  std::weak_ptr<const std::vector<uint8_t>> weak;
+  std::vector<uint8_t> expected, received;
+  int size;
+
+  if (!out.setZeroCopy(true))
+    GTEST_SKIP() << "Zero copy sending not supported";
+
+  size = 1024 * 1024;
+  ASSERT_EQ(setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF,
+                       &size, sizeof(size)), 0);
+
+  data = std::make_shared<const std::vector<uint8_t>>(randomData(200000));
+  weak = data;
+
+  expected = { 0x12, 0x34, 0x56, 0x78 };
+  expected.insert(expected.end(), data->begin(), data->end());
+
+  out.writeU32(0x12345678);
+  out.writeBuffer(data);
+  EXPECT_EQ(out.length(), expected.size());
+
+  // The kernel might still need the data
+  data.reset();
+  EXPECT_FALSE(weak.expired());
+
+  for (int i = 0; i < 1000; i++) {
+    drain(&received);
+    out.flush();
+    if (!out.hasBufferedData() && weak.expired())
+      break;
+    usleep(1000);
+  }
+  drain(&received);
+
+  EXPECT_TRUE(weak.expired());
+  EXPECT_EQ(received, expected);
+}
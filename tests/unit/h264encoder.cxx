@@ -0,0 +1,190 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rdr/MemInStream.h>
+#include <rdr/MemOutStream.h>
+
+#include <rfb/H264Encoder.h>
+#include <rfb/H264EncoderContext.h>
+#include <rfb/Palette.h>
+#include <rfb/PixelBuffer.h>
+#include <rfb/ServerCore.h>
+
+static const rfb::PixelFormat fbPF(32, 24, false, true,
+                                   255, 255, 255, 16, 8, 0);
+
+// Writes where it is and how many frames it has seen, instead of
+// actual H.264 data
+class StubContext : public rfb::H264EncoderContext {
+public:
+  StubContext(const core::Rect& r, const Settings& s,
+              std::vector<core::Rect>* deleted_)
+    : rfb::H264EncoderContext(r, s), deleted(deleted_), frames(0) {}
+  ~StubContext() { deleted->push_back(rect); }
+
+  void encode(const rfb::PixelBuffer*, rdr::OutStream* os) override
+  {
+    os->writeU16(rect.tl.x);
+    os->writeU16(rect.tl.y);
+    os->writeU32(frames++);
+  }
+
+  std::vector<core::Rect>* deleted;
+  unsigned frames;
+};
+
+class TestEncoder : public rfb::H264Encoder {
+public:
+  TestEncoder() : rfb::H264Encoder(nullptr) { setOutStream(&out); }
+  ~TestEncoder() { resetContexts(); }
+
+  rfb::H264EncoderContext* createContext(
+    const core::Rect& r,
+    const rfb::H264EncoderContext::Settings& settings) override
+  {
+    created.push_back(r);
+    lastSettings = settings;
+    return new StubContext(r, settings, &deleted);
+  }
+
+  rdr::MemOutStream out;
+  std::vector<core::Rect> created, deleted;
+  rfb::H264EncoderContext::Settings lastSettings;
+};
+
+struct WireRect {
+  uint32_t length;
+  uint32_t flags;
+  int x, y;
+  unsigned frame;
+};
+
+static WireRect encodeRect(TestEncoder* encoder, const core::Rect& r)
+{
+  rfb::ManagedPixelBuffer pb(fbPF, r.width(), r.height());
+  rfb::Palette palette;
+  WireRect result;
+
+  encoder->out.clear();
+  encoder->setPosition(r.tl);
+  encoder->writeRect(&pb, palette);
+
+  rdr::MemInStream is(encoder->out.data(), encoder->out.length());
+
+  EXPECT_TRUE(is.hasData(8 + 8));
+  result.length = is.readU32();
+  result.flags = is.readU32();
+  result.x = is.readU16();
+  result.y = is.readU16();
+  result.frame = is.readU32();
+
+  // Nothing else may follow the data
+  EXPECT_EQ(result.length, 8U);
+  EXPECT_EQ(is.pos(), encoder->out.length());
+
+  return result;
+}
+
+TEST(H264Encoder, wireLayout)
+{
+  TestEncoder encoder;
+  WireRect rect;
+
+  rect = encodeRect(&encoder, {16, 32, 80, 96});
+  EXPECT_EQ(rect.flags, 0U);
+  EXPECT_EQ(rect.x, 16);
+  EXPECT_EQ(rect.y, 32);
+  EXPECT_EQ(rect.frame, 0U);
+
+  // Same area continues the same stream
+  rect = encodeRect(&encoder, {16, 32, 80, 96});
+  EXPECT_EQ(rect.flags, 0U);
+  EXPECT_EQ(rect.frame, 1U);
+  EXPECT_EQ(encoder.created.size(), 1U);
+
+  // The viewer must drop all its streams as well
+  encoder.resetState();
+  rect = encodeRect(&encoder, {16, 32, 80, 96});
+  EXPECT_EQ(rect.flags, 0x2U);
+  EXPECT_EQ(rect.frame, 0U);
+  EXPECT_EQ(encoder.created.size(), 2U);
+  EXPECT_EQ(encoder.deleted.size(), 1U);
+
+  rect = encodeRect(&encoder, {16, 32, 80, 96});
+  EXPECT_EQ(rect.flags, 0U);
+
+  // Streams can't be reconfigured, so new settings also start over
+  encoder.setQualityLevel(3);
+  rect = encodeRect(&encoder, {16, 32, 80, 96});
+  EXPECT_EQ(rect.flags, 0x2U);
+  EXPECT_EQ(rect.frame, 0U);
+}
+
+TEST(H264Encoder, contextLimit)
+{
+  TestEncoder encoder;
+  WireRect rect;
+
+  for (int i = 0; i < 64; i++) {
+    rect = encodeRect(&encoder, {i * 16, 0, i * 16 + 16, 16});
+    EXPECT_EQ(rect.frame, 0U);
+  }
+  EXPECT_EQ(encoder.created.size(), 64U);
+  EXPECT_TRUE(encoder.deleted.empty());
+
+  // Reusing a stream doesn't change which one is the oldest, as the
+  // viewer only goes by the order they were created in
+  rect = encodeRect(&encoder, {0, 0, 16, 16});
+  EXPECT_EQ(rect.frame, 1U);
+  EXPECT_EQ(encoder.created.size(), 64U);
+
+  rect = encodeRect(&encoder, {0, 16, 16, 32});
+  EXPECT_EQ(rect.flags, 0U);
+  EXPECT_EQ(rect.frame, 0U);
+  ASSERT_EQ(encoder.deleted.size(), 1U);
+  EXPECT_EQ(encoder.deleted[0], core::Rect(0, 0, 16, 16));
+
+  // So the first one now has to start from scratch
+  rect = encodeRect(&encoder, {0, 0, 16, 16});
+  EXPECT_EQ(rect.frame, 0U);
+  EXPECT_EQ(encoder.created.size(), 66U);
+  ASSERT_EQ(encoder.deleted.size(), 2U);
+  EXPECT_EQ(encoder.deleted[1], core::Rect(16, 0, 32, 16));
+}
+
+TEST(H264Encoder, unlimitedFrameRate)
+{
+  TestEncoder encoder;
+
+  // Zero means no limit, which the codec can't use as a time base
+  rfb::Server::frameRate.setParam(0);
+  encodeRect(&encoder, {0, 0, 16, 16});
+  rfb::Server::frameRate.setParam(60);
+
+  ASSERT_EQ(encoder.created.size(), 1U);
+  EXPECT_GE(encoder.lastSettings.frameRate, 1);
+}
@@ -0,0 +1,76 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include <core/ImplSelector.h>
+#include <core/LogWriter.h>
+
+static core::LogWriter vlog("ImplSelectorTest");
+
+struct TestImpl {
+  const char* name;
+  int value;
+  bool (*supported)();
+};
+
+static bool yes() { return true; }
+static bool no() { return false; }
+
+static const TestImpl impls[] = {
+  { "best", 1, no },
+  { "good", 2, yes },
+  { "generic", 3, nullptr },
+};
+
+TEST(ImplSelector, best)
+{
+  core::ImplSelector<TestImpl> selector(impls, &vlog);
+
+  EXPECT_EQ(selector.get()->value, 2);
+  EXPECT_STREQ(selector.name(), "good");
+}
+
+TEST(ImplSelector, set)
+{
+  core::ImplSelector<TestImpl> selector(impls, &vlog);
+
+  EXPECT_TRUE(selector.set("generic"));
+  EXPECT_EQ(selector.get()->value, 3);
+
+  EXPECT_FALSE(selector.set("best"));
+  EXPECT_FALSE(selector.set("unknown"));
+  EXPECT_STREQ(selector.name(), "generic");
+
+  EXPECT_TRUE(selector.set("good"));
+  EXPECT_STREQ(selector.name(), "good");
+}
+
+TEST(ImplSelector, unset)
+{
+  core::ImplSelector<TestImpl> selector(impls, &vlog);
+
+  EXPECT_TRUE(selector.set("generic"));
+  EXPECT_TRUE(selector.set(nullptr));
+  EXPECT_STREQ(selector.name(), "good");
+}
@@ -0,0 +1,128 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rfb/IndexPack.h>
+
+static const char* impls[] = { "generic", "ssse3", "avx2", "neon" };
+
+static std::vector<uint8_t> randomIndices(size_t size, int bits)
+{
+  std::vector<uint8_t> data(size);
+
+  for (uint8_t& b : data)
+    b = rand() & ((1 << bits) - 1);
+
+  return data;
+}
+
+// Straight from the specification, to compare with
+static std::vector<uint8_t> referencePack(const std::vector<uint8_t>& in,
+                                          int width, int bits)
+{
+  std::vector<uint8_t> out;
+  uint8_t byte, nbits;
+
+  byte = nbits = 0;
+  for (int x = 0; x < width; x++) {
+    byte = (byte << bits) | in[x];
+    nbits += bits;
+    if (nbits == 8) {
+      out.push_back(byte);
+      byte = nbits = 0;
+    }
+  }
+  if (nbits > 0)
+    out.push_back(byte << (8 - nbits));
+
+  return out;
+}
+
+TEST(IndexPack, pack)
+{
+  srand(1);
+
+  for (const char* impl : impls) {
+    if (!rfb::setIndexPackImpl(impl))
+      continue;
+
+    for (int bits = 1; bits <= 4; bits *= 2) {
+      std::vector<uint8_t> in, expected;
+
+      in = randomIndices(200, bits);
+
+      for (int width = 1; width <= 200; width++) {
+        size_t bytes;
+
+        expected = referencePack(in, width, bits);
+        bytes = expected.size();
+
+        // Extra space to catch anything written past the end
+        std::vector<uint8_t> out(bytes + 32, 0xaa);
+
+        rfb::packIndexRow(in.data(), out.data(), width, bits);
+
+        EXPECT_EQ(std::vector<uint8_t>(out.begin(), out.begin() + bytes),
+                  expected)
+          << impl << " with " << bits << " bits and width " << width;
+        EXPECT_EQ(out[bytes], 0xaa)
+          << impl << " with " << bits << " bits and width " << width;
+      }
+    }
+  }
+}
+
+TEST(IndexPack, unpack)
+{
+  srand(2);
+
+  for (const char* impl : impls) {
+    if (!rfb::setIndexPackImpl(impl))
+      continue;
+
+    for (int bits = 1; bits <= 4; bits *= 2) {
+      std::vector<uint8_t> in, packed;
+
+      in = randomIndices(200, bits);
+
+      for (int width = 1; width <= 200; width++) {
+        std::vector<uint8_t> out(width + 32, 0xaa);
+
+        packed = referencePack(in, width, bits);
+
+        rfb::unpackIndexRow(packed.data(), out.data(), width, bits);
+
+        EXPECT_EQ(std::vector<uint8_t>(out.begin(), out.begin() + width),
+                  std::vector<uint8_t>(in.begin(), in.begin() + width))
+          << impl << " with " << bits << " bits and width " << width;
+        EXPECT_EQ(out[width], 0xaa)
+          << impl << " with " << bits << " bits and width " << width;
+      }
+    }
+  }
+}
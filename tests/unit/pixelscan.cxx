@@ -0,0 +1,135 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rfb/PixelScan.h>
+
+static const char* impls[] = { "generic", "sse2", "avx2", "neon" };
+
+template<class T>
+static void testSolid(const char* impl)
+{
+  std::vector<T> buffer(200);
+
+  for (int width = 0; width <= (int)buffer.size(); width++) {
+    std::fill(buffer.begin(), buffer.end(), (T)0x12345678);
+    EXPECT_EQ(rfb::countPixels(buffer.data(), width, (T)0x12345678),
+              width) << impl << " with width " << width;
+  }
+}
+
+template<class T>
+static void testRun(const char* impl)
+{
+  std::vector<T> buffer(200);
+
+  for (int width = 1; width <= (int)buffer.size(); width++) {
+    for (int x = 0; x < width; x++) {
+      std::fill(buffer.begin(), buffer.end(), (T)0x12345678);
+
+      // Only a single byte differs, and it must not matter which
+      buffer[x] ^= (T)1 << (x % sizeof(T) * 8);
+
+      // Anything after it should not matter
+      if (x + 1 < width)
+        buffer[x + 1] ^= 0xff;
+
+      EXPECT_EQ(rfb::countPixels(buffer.data(), width, (T)0x12345678),
+                x) << impl << " with width " << width;
+    }
+  }
+}
+
+TEST(PixelScan, solid8)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setPixelScanImpl(impl))
+      continue;
+    testSolid<uint8_t>(impl);
+  }
+}
+
+TEST(PixelScan, solid16)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setPixelScanImpl(impl))
+      continue;
+    testSolid<uint16_t>(impl);
+  }
+}
+
+TEST(PixelScan, solid32)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setPixelScanImpl(impl))
+      continue;
+    testSolid<uint32_t>(impl);
+  }
+}
+
+TEST(PixelScan, run8)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setPixelScanImpl(impl))
+      continue;
+    testRun<uint8_t>(impl);
+  }
+}
+
+TEST(PixelScan, run16)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setPixelScanImpl(impl))
+      continue;
+    testRun<uint16_t>(impl);
+  }
+}
+
+TEST(PixelScan, run32)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setPixelScanImpl(impl))
+      continue;
+    testRun<uint32_t>(impl);
+  }
+}
+
+TEST(PixelScan, outside)
+{
+  std::vector<uint32_t> buffer(100, 0xff00ff);
+
+  // Only the given width should be considered
+  buffer[50] = 0;
+
+  for (const char* impl : impls) {
+    if (!rfb::setPixelScanImpl(impl))
+      continue;
+    EXPECT_EQ(rfb::countPixels(buffer.data(), 50, 0xff00ffu), 50)
+      << impl;
+  }
+}
@@ -0,0 +1,180 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sys/time.h>
+
+#include <gtest/gtest.h>
+
+#include <core/time.h>
+
+#include <rfb/ClientParams.h>
+#include <rfb/QualityController.h>
+
+static const struct timeval start = { 1000, 0 };
+
+// Feeds one second worth of updates at 10 fps
+static void runPeriod(rfb::QualityController* controller,
+                      struct timeval* now,
+                      size_t bytes, unsigned encodeTime)
+{
+  for (int i = 0; i < 11; i++) {
+    controller->update(bytes, encodeTime, 100, now);
+    *now = core::addMillis(*now, 100);
+  }
+}
+
+TEST(QualityController, unchanged)
+{
+  rfb::QualityController controller;
+
+  controller.setClientSettings(2, 8, -1, rfb::subsampleNone);
+
+  EXPECT_EQ(controller.getCompressLevel(), 2);
+  EXPECT_EQ(controller.getQualityLevel(), 8);
+  EXPECT_EQ(controller.getFineQualityLevel(), -1);
+  EXPECT_EQ(controller.getSubsampling(), rfb::subsampleNone);
+  EXPECT_FALSE(controller.isAdjusted());
+}
+
+TEST(QualityController, slowLink)
+{
+  rfb::QualityController controller;
+  struct timeval now;
+
+  controller.setClientSettings(2, 8, -1, rfb::subsampleNone);
+  controller.setNetwork(100000, 50);
+
+  // 50 kB per update takes 500 ms to send, with lots of time to spare
+  // for encoding, so compression goes up first
+  now = start;
+  runPeriod(&controller, &now, 50000, 1000);
+  EXPECT_EQ(controller.getCompressLevel(), 3);
+  EXPECT_EQ(controller.getQualityLevel(), 8);
+  EXPECT_TRUE(controller.isAdjusted());
+
+  runPeriod(&controller, &now, 50000, 1000);
+  EXPECT_EQ(controller.getCompressLevel(), 4);
+
+  // Then quality
+  for (int i = 0; i < 3; i++)
+    runPeriod(&controller, &now, 50000, 1000);
+  EXPECT_EQ(controller.getCompressLevel(), 4);
+  EXPECT_EQ(controller.getQualityLevel(), 5);
+  EXPECT_EQ(controller.getSubsampling(), rfb::subsampleNone);
+
+  // And finally subsampling
+  runPeriod(&controller, &now, 50000, 1000);
+  EXPECT_EQ(controller.getSubsampling(), rfb::subsample2X);
+
+  // But no further than that
+  for (int i = 0; i < 5; i++)
+    runPeriod(&controller, &now, 50000, 1000);
+  EXPECT_EQ(controller.getCompressLevel(), 4);
+  EXPECT_EQ(controller.getQualityLevel(), 5);
+  EXPECT_EQ(controller.getSubsampling(), rfb::subsample2X);
+}
+
+TEST(QualityController, busyEncoder)
+{
+  rfb::QualityController controller;
+  struct timeval now;
+
+  controller.setClientSettings(6, 8, -1, rfb::subsampleNone);
+  controller.setNetwork(100000000, 1);
+
+  // 80 ms of encoding for each 100 ms frame
+  now = start;
+  for (int i = 0; i < 5; i++)
+    runPeriod(&controller, &now, 50000, 80000);
+
+  EXPECT_EQ(controller.getCompressLevel(), 4);
+  EXPECT_EQ(controller.getQualityLevel(), 8);
+  EXPECT_EQ(controller.getSubsampling(), rfb::subsampleNone);
+}
+
+TEST(QualityController, recover)
+{
+  rfb::QualityController controller;
+  struct timeval now;
+
+  controller.setClientSettings(2, 8, -1, rfb::subsampleNone);
+  controller.setNetwork(100000, 50);
+
+  now = start;
+  for (int i = 0; i < 6; i++)
+    runPeriod(&controller, &now, 50000, 1000);
+  EXPECT_EQ(controller.getQualityLevel(), 5);
+  EXPECT_EQ(controller.getSubsampling(), rfb::subsample2X);
+
+  // Small updates leave lots of headroom
+  for (int i = 0; i < 4; i++)
+    runPeriod(&controller, &now, 1000, 1000);
+
+  EXPECT_EQ(controller.getCompressLevel(), 4);
+  EXPECT_EQ(controller.getQualityLevel(), 8);
+  EXPECT_EQ(controller.getSubsampling(), rfb::subsampleNone);
+
+  EXPECT_TRUE(controller.isAdjusted());
+
+  for (int i = 0; i < 2; i++)
+    runPeriod(&controller, &now, 1000, 1000);
+  EXPECT_EQ(controller.getCompressLevel(), 2);
+  EXPECT_FALSE(controller.isAdjusted());
+}
+
+TEST(QualityController, fineQuality)
+{
+  rfb::QualityController controller;
+  struct timeval now;
+
+  controller.setClientSettings(9, -1, 80, rfb::subsample4X);
+  controller.setNetwork(100000, 50);
+
+  now = start;
+  for (int i = 0; i < 10; i++)
+    runPeriod(&controller, &now, 50000, 1000);
+
+  // Compression and subsampling are already at the limit
+  EXPECT_EQ(controller.getCompressLevel(), 9);
+  EXPECT_EQ(controller.getQualityLevel(), -1);
+  EXPECT_EQ(controller.getFineQualityLevel(), 50);
+  EXPECT_EQ(controller.getSubsampling(), rfb::subsample4X);
+}
+
+TEST(QualityController, clientChange)
+{
+  rfb::QualityController controller;
+  struct timeval now;
+
+  controller.setClientSettings(2, 8, -1, rfb::subsampleNone);
+  controller.setNetwork(100000, 50);
+
+  now = start;
+  for (int i = 0; i < 4; i++)
+    runPeriod(&controller, &now, 50000, 1000);
+  EXPECT_EQ(controller.getQualityLevel(), 6);
+
+  // New settings from the client start over
+  controller.setClientSettings(2, 6, -1, rfb::subsampleNone);
+  EXPECT_EQ(controller.getCompressLevel(), 2);
+  EXPECT_EQ(controller.getQualityLevel(), 6);
+}
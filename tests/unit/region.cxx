@@ -0,0 +1,65 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <core/Region.h>
+
+TEST(Region, largeCoordinates)
+{
+  core::Region region;
+  std::vector<core::Rect> rects;
+
+  region.assign_union({{40000, 10, 70000, 20}});
+  region.assign_union({{10, 50000, 20, 60000}});
+
+  EXPECT_EQ(region.numRects(), 2);
+  EXPECT_EQ(region.get_bounding_rect(), core::Rect(10, 10, 70000, 60000));
+
+  region.get_rects(&rects);
+  ASSERT_EQ(rects.size(), 2U);
+  EXPECT_EQ(rects[0], core::Rect(40000, 10, 70000, 20));
+  EXPECT_EQ(rects[1], core::Rect(10, 50000, 20, 60000));
+}
+
+TEST(Region, largeSubtract)
+{
+  core::Region region({0, 0, 65536, 100});
+
+  region.assign_subtract({{32000, 0, 34000, 100}});
+
+  EXPECT_EQ(region.numRects(), 2);
+  EXPECT_EQ(region.intersect({{33000, 0, 33001, 1}}).numRects(), 0);
+  EXPECT_EQ(region.intersect({{34000, 0, 34001, 1}}).numRects(), 1);
+}
+
+TEST(Region, largeTranslate)
+{
+  core::Region region({0, 0, 100, 100});
+
+  region.translate({40000, 40000});
+
+  EXPECT_EQ(region.get_bounding_rect(),
+            core::Rect(40000, 40000, 40100, 40100));
+}
@@ -0,0 +1,150 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sys/time.h>
+
+#include <gtest/gtest.h>
+
+#include <core/Region.h>
+#include <core/time.h>
+
+#include <rfb/RegionClassifier.h>
+
+static const struct timeval start = { 1000, 0 };
+
+TEST(RegionClassifier, initial)
+{
+  rfb::RegionClassifier classifier;
+
+  classifier.setSize(300, 200);
+
+  EXPECT_EQ(classifier.getRegion(rfb::contentStatic, &start),
+            core::Region({0, 0, 300, 200}));
+  EXPECT_TRUE(classifier.getRegion(rfb::contentVideo, &start).is_empty());
+}
+
+TEST(RegionClassifier, active)
+{
+  rfb::RegionClassifier classifier;
+  struct timeval now;
+
+  classifier.setSize(300, 200);
+
+  now = start;
+  classifier.update({{10, 10, 20, 20}}, {}, &now);
+
+  // A single change doesn't tell us much
+  EXPECT_EQ(classifier.getRegion(rfb::contentStatic, &now),
+            core::Region({0, 0, 300, 200}));
+
+  now = core::addMillis(now, 500);
+  classifier.update({{10, 10, 20, 20}}, {}, &now);
+
+  EXPECT_EQ(classifier.getRegion(rfb::contentActive, &now),
+            core::Region({0, 0, 64, 64}));
+
+  // Eventually it settles down again
+  now = core::addMillis(now, 5000);
+  EXPECT_EQ(classifier.getRegion(rfb::contentStatic, &now),
+            core::Region({0, 0, 300, 200}));
+}
+
+TEST(RegionClassifier, video)
+{
+  rfb::RegionClassifier classifier;
+  struct timeval now;
+
+  classifier.setSize(300, 200);
+
+  now = start;
+  for (int i = 0; i < 50; i++) {
+    classifier.update({{100, 50, 260, 150}}, {}, &now);
+    now = core::addMillis(now, 40);
+  }
+
+  // Only tiles that are mostly covered count
+  EXPECT_EQ(classifier.getRegion(rfb::contentVideo, &now),
+            core::Region({128, 64, 256, 128}));
+
+  // Nothing lasts forever
+  now = core::addMillis(now, 2000);
+  EXPECT_TRUE(classifier.getRegion(rfb::contentVideo, &now).is_empty());
+}
+
+TEST(RegionClassifier, typing)
+{
+  rfb::RegionClassifier classifier;
+  struct timeval now;
+
+  classifier.setSize(300, 200);
+
+  now = start;
+  for (int i = 0; i < 50; i++) {
+    classifier.update({{i * 4, 10, i * 4 + 8, 26}}, {}, &now);
+    now = core::addMillis(now, 40);
+  }
+
+  EXPECT_TRUE(classifier.getRegion(rfb::contentVideo, &now).is_empty());
+  EXPECT_FALSE(classifier.getRegion(rfb::contentActive, &now).is_empty());
+}
+
+TEST(RegionClassifier, scrolling)
+{
+  rfb::RegionClassifier classifier;
+  struct timeval now;
+
+  classifier.setSize(300, 200);
+
+  now = start;
+  for (int i = 0; i < 50; i++) {
+    classifier.update({{0, 176, 128, 200}}, {{0, 0, 128, 176}}, &now);
+    now = core::addMillis(now, 40);
+  }
+
+  // The uncovered area is also scrolling, not video
+  EXPECT_EQ(classifier.getRegion(rfb::contentScrolling, &now),
+            core::Region({0, 0, 192, 200}));
+  EXPECT_TRUE(classifier.getRegion(rfb::contentVideo, &now).is_empty());
+}
+
+TEST(RegionClassifier, resize)
+{
+  rfb::RegionClassifier classifier;
+  struct timeval now;
+
+  classifier.setSize(300, 200);
+
+  now = start;
+  for (int i = 0; i < 50; i++) {
+    classifier.update({{0, 0, 300, 200}}, {}, &now);
+    now = core::addMillis(now, 40);
+  }
+
+  // Same size keeps the history
+  classifier.setSize(300, 200);
+  EXPECT_EQ(classifier.getRegion(rfb::contentVideo, &now),
+            core::Region({0, 0, 300, 200}));
+
+  classifier.setSize(200, 300);
+  EXPECT_EQ(classifier.getRegion(rfb::contentStatic, &now),
+            core::Region({0, 0, 200, 300}));
+}
@@ -0,0 +1,161 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <unistd.h>
+
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <core/ThreadPool.h>
+
+class CountJob : public core::ThreadPool::Job {
+public:
+  CountJob() : count(0) {}
+  void run() override { count++; }
+  int count;
+};
+
+class FailJob : public core::ThreadPool::Job {
+public:
+  void run() override { throw std::runtime_error("failed"); }
+};
+
+TEST(ThreadPool, noThreads)
+{
+  core::ThreadPool pool(0);
+  CountJob job;
+
+  EXPECT_EQ(pool.size(), 0);
+
+  pool.submit(&job);
+  pool.wait(&job);
+  EXPECT_EQ(job.count, 1);
+}
+
+TEST(ThreadPool, manyJobs)
+{
+  core::ThreadPool pool(3);
+  std::vector<CountJob> jobs(100);
+
+  EXPECT_EQ(pool.size(), 3);
+
+  for (CountJob& job : jobs)
+    pool.submit(&job);
+  for (CountJob& job : jobs)
+    pool.wait(&job);
+
+  for (CountJob& job : jobs)
+    EXPECT_EQ(job.count, 1);
+}
+
+TEST(ThreadPool, reuse)
+{
+  core::ThreadPool pool(2);
+  CountJob job;
+
+  for (int i = 0; i < 10; i++) {
+    pool.submit(&job);
+    pool.wait(&job);
+  }
+
+  EXPECT_EQ(job.count, 10);
+}
+
+TEST(ThreadPool, exception)
+{
+  core::ThreadPool pool(2);
+  FailJob failJob;
+  CountJob job;
+
+  pool.submit(&failJob);
+  pool.submit(&job);
+
+  EXPECT_THROW(pool.wait(&failJob), std::runtime_error);
+  pool.wait(&job);
+  EXPECT_EQ(job.count, 1);
+
+  // Exceptions should not linger
+  pool.submit(&job);
+  EXPECT_NO_THROW(pool.wait(&job));
+}
+
+TEST(ThreadPool, isFinished)
+{
+  core::ThreadPool noThreads(0), pool(1);
+  CountJob job;
+
+  // Nobody will pick it up until we wait for it
+  noThreads.submit(&job);
+  EXPECT_FALSE(noThreads.isFinished(&job));
+  noThreads.wait(&job);
+
+  pool.submit(&job);
+  while (!pool.isFinished(&job))
+    std::this_thread::yield();
+  EXPECT_EQ(job.count, 2);
+  pool.wait(&job);
+}
+
+class NotifyJob : public core::ThreadPool::Job {
+public:
+  NotifyJob(int fd_) : fd(fd_) {}
+  void run() override { usleep(1000); }
+  void finished() override { char c = 0; EXPECT_EQ(write(fd, &c, 1), 1); }
+  int fd;
+};
+
+TEST(ThreadPool, finished)
+{
+  core::ThreadPool pool(1);
+  int fds[2];
+  char c;
+
+  ASSERT_EQ(pipe(fds), 0);
+
+  NotifyJob job(fds[1]);
+
+  // Whoever gets told about the job must be able to collect it
+  for (int i = 0; i < 10; i++) {
+    pool.submit(&job);
+    ASSERT_EQ(read(fds[0], &c, 1), 1);
+    EXPECT_TRUE(pool.isFinished(&job));
+    pool.wait(&job);
+  }
+
+  // Also when it's run by the thread waiting for it
+  core::ThreadPool noThreads(0);
+  noThreads.submit(&job);
+  noThreads.wait(&job);
+  EXPECT_EQ(read(fds[0], &c, 1), 1);
+
+  close(fds[0]);
+  close(fds[1]);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
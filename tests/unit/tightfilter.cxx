@@ -0,0 +1,194 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rfb/TightFilter.h>
+
+static const char* impls[] = { "generic", "sse4.1", "avx2", "neon" };
+
+static std::vector<uint8_t> randomData(size_t size)
+{
+  std::vector<uint8_t> data(size);
+
+  for (uint8_t& b : data)
+    b = rand();
+
+  return data;
+}
+
+// Straight from the specification, to compare with
+static void referenceGradient(const uint8_t* in, const uint8_t* prevRow,
+                              uint8_t* out, int width)
+{
+  for (int x = 0; x < width; x++) {
+    for (int c = 0; c < 3; c++) {
+      int left, upperLeft, est;
+
+      left = x > 0 ? out[(x-1)*3+c] : 0;
+      upperLeft = x > 0 ? prevRow[(x-1)*3+c] : 0;
+
+      est = prevRow[x*3+c] + left - upperLeft;
+      if (est > 255)
+        est = 255;
+      if (est < 0)
+        est = 0;
+
+      out[x*3+c] = in[x*3+c] + est;
+    }
+  }
+}
+
+TEST(TightFilter, gradient)
+{
+  std::vector<uint8_t> in, prevRow, expected;
+
+  srand(1);
+
+  in = randomData(100 * 3);
+  prevRow = randomData(100 * 3);
+
+  for (const char* impl : impls) {
+    if (!rfb::setTightFilterImpl(impl))
+      continue;
+
+    for (int width = 1; width <= 100; width++) {
+      // Extra space to catch anything written past the end
+      std::vector<uint8_t> out(width * 3 + 16, 0xaa);
+
+      expected.assign(width * 3, 0);
+      referenceGradient(in.data(), prevRow.data(), expected.data(), width);
+
+      rfb::decodeGradientRow(in.data(), prevRow.data(), out.data(), width);
+
+      EXPECT_EQ(std::vector<uint8_t>(out.begin(), out.begin() + width * 3),
+                expected) << impl << " with width " << width;
+      EXPECT_EQ(out[width * 3], 0xaa) << impl << " with width " << width;
+    }
+  }
+}
+
+template<class T>
+static void testMono(const char* impl)
+{
+  std::vector<uint8_t> in;
+  T palette[2] = { (T)0x12345678, (T)0x9abcdef0 };
+
+  in = randomData(20);
+
+  for (int width = 1; width <= 150; width++) {
+    std::vector<T> out(width + 16, (T)0xaaaaaaaa);
+
+    rfb::expandMonoRow(in.data(), palette, out.data(), width);
+
+    for (int x = 0; x < width; x++) {
+      EXPECT_EQ(out[x], palette[in[x / 8] >> (7 - x % 8) & 1])
+        << impl << " with width " << width << " at " << x;
+    }
+    EXPECT_EQ(out[width], (T)0xaaaaaaaa)
+      << impl << " with width " << width;
+  }
+}
+
+template<class T>
+static void testPalette(const char* impl)
+{
+  std::vector<uint8_t> in;
+  T palette[256];
+
+  for (int i = 0; i < 256; i++)
+    palette[i] = (T)(i * 0x01010101u + 0x10203);
+
+  in = randomData(150);
+
+  for (int width = 1; width <= 150; width++) {
+    std::vector<T> out(width + 16, (T)0xaaaaaaaa);
+
+    rfb::expandPaletteRow(in.data(), palette, out.data(), width);
+
+    for (int x = 0; x < width; x++) {
+      EXPECT_EQ(out[x], palette[in[x]])
+        << impl << " with width " << width << " at " << x;
+    }
+    EXPECT_EQ(out[width], (T)0xaaaaaaaa)
+      << impl << " with width " << width;
+  }
+}
+
+TEST(TightFilter, mono8)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setTightFilterImpl(impl))
+      continue;
+    testMono<uint8_t>(impl);
+  }
+}
+
+TEST(TightFilter, mono16)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setTightFilterImpl(impl))
+      continue;
+    testMono<uint16_t>(impl);
+  }
+}
+
+TEST(TightFilter, mono32)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setTightFilterImpl(impl))
+      continue;
+    testMono<uint32_t>(impl);
+  }
+}
+
+TEST(TightFilter, palette8)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setTightFilterImpl(impl))
+      continue;
+    testPalette<uint8_t>(impl);
+  }
+}
+
+TEST(TightFilter, palette16)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setTightFilterImpl(impl))
+      continue;
+    testPalette<uint16_t>(impl);
+  }
+}
+
+TEST(TightFilter, palette32)
+{
+  for (const char* impl : impls) {
+    if (!rfb::setTightFilterImpl(impl))
+      continue;
+    testPalette<uint32_t>(impl);
+  }
+}
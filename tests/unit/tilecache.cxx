@@ -0,0 +1,306 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rdr/BufferedInStream.h>
+#include <rdr/MemOutStream.h>
+
+#include <rfb/CConnection.h>
+#include <rfb/CMsgReader.h>
+#include <rfb/CMsgWriter.h>
+#include <rfb/EncodeManager.h>
+#include <rfb/PixelBuffer.h>
+#include <rfb/SConnection.h>
+#include <rfb/SMsgWriter.h>
+#include <rfb/TileCache.h>
+#include <rfb/UpdateTracker.h>
+#include <rfb/encodings.h>
+
+TEST(TileCache, insert)
+{
+  rfb::TileCache cache;
+  rfb::TileCache::Tile* tile;
+
+  EXPECT_EQ(cache.lookup(1), nullptr);
+
+  tile = cache.insert(1);
+  ASSERT_NE(tile, nullptr);
+  tile->width = 64;
+  tile->height = 32;
+
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.lookup(1), tile);
+  EXPECT_EQ(cache.lookup(1)->width, 64);
+  EXPECT_EQ(cache.lookup(1)->height, 32);
+
+  // Inserting again gives back the same tile
+  EXPECT_EQ(cache.insert(1), tile);
+  EXPECT_EQ(cache.size(), 1);
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.lookup(1), nullptr);
+}
+
+TEST(TileCache, evictOldest)
+{
+  rfb::TileCache cache;
+
+  for (uint64_t hash = 0; hash < rfb::TileCache::MaxTiles; hash++)
+    cache.insert(hash);
+  EXPECT_EQ(cache.size(), rfb::TileCache::MaxTiles);
+
+  cache.insert(rfb::TileCache::MaxTiles);
+  EXPECT_EQ(cache.size(), rfb::TileCache::MaxTiles);
+
+  EXPECT_EQ(cache.lookup(0), nullptr);
+  EXPECT_NE(cache.lookup(1), nullptr);
+  EXPECT_NE(cache.lookup(rfb::TileCache::MaxTiles), nullptr);
+}
+
+TEST(TileCache, lookupKeeps)
+{
+  rfb::TileCache cache;
+
+  for (uint64_t hash = 0; hash < rfb::TileCache::MaxTiles; hash++)
+    cache.insert(hash);
+
+  // Using the oldest tile should make the next one go instead
+  EXPECT_NE(cache.lookup(0), nullptr);
+  cache.insert(rfb::TileCache::MaxTiles);
+
+  EXPECT_NE(cache.lookup(0), nullptr);
+  EXPECT_EQ(cache.lookup(1), nullptr);
+  EXPECT_NE(cache.lookup(2), nullptr);
+}
+
+TEST(TileCache, insertKeeps)
+{
+  rfb::TileCache cache;
+
+  for (uint64_t hash = 0; hash < rfb::TileCache::MaxTiles; hash++)
+    cache.insert(hash);
+
+  // Storing an existing tile again also counts as using it
+  cache.insert(0);
+  cache.insert(rfb::TileCache::MaxTiles);
+
+  EXPECT_NE(cache.lookup(0), nullptr);
+  EXPECT_EQ(cache.lookup(1), nullptr);
+}
+
+static const rfb::PixelFormat fbPF(32, 24, false, true,
+                                   255, 255, 255, 16, 8, 0);
+
+// Hands over whatever the server has written so far
+class LoopbackInStream : public rdr::BufferedInStream {
+public:
+  LoopbackInStream(rdr::MemOutStream* source_)
+    : source(source_), offset(0) {}
+
+private:
+  bool fillBuffer() override
+  {
+    size_t len;
+
+    len = source->length() - offset;
+    if (len == 0)
+      return false;
+    if (len > availSpace())
+      len = availSpace();
+
+    memcpy((uint8_t*)end, (const uint8_t*)source->data() + offset, len);
+    offset += len;
+    end += len;
+
+    return true;
+  }
+
+  rdr::MemOutStream* source;
+  size_t offset;
+};
+
+class TestServer : public rfb::SConnection {
+public:
+  TestServer() : rfb::SConnection(rfb::AccessDefault), manager(this)
+  {
+    const int32_t encodings[] = { rfb::encodingRaw,
+                                  rfb::pseudoEncodingLastRect,
+                                  rfb::pseudoEncodingTileCache };
+
+    setStreams(nullptr, &out);
+    setWriter(new rfb::SMsgWriter(&client, &out));
+
+    client.setPF(fbPF);
+    ((rfb::SMsgHandler*)this)->setEncodings(3, encodings);
+  }
+
+  void setAccessRights(rfb::AccessRights) override {}
+  void setDesktopSize(int, int, const rfb::ScreenSet&) override {}
+  void keyEvent(uint32_t, uint32_t, bool) override {}
+  void pointerEvent(const core::Point&, uint16_t) override {}
+
+  rdr::MemOutStream out;
+  rfb::EncodeManager manager;
+};
+
+class TestViewer : public rfb::CConnection {
+public:
+  TestViewer(rdr::MemOutStream* source, int width, int height)
+    : in(source), tileRects(0)
+  {
+    setStreams(&in, &out);
+
+    // Skip the handshake
+    setState(RFBSTATE_NORMAL);
+    setReader(new rfb::CMsgReader(this, &in));
+    setWriter(new rfb::CMsgWriter(&server, &out));
+
+    server.setPF(fbPF);
+    setDesktopSize(width, height);
+  }
+
+  void resizeFramebuffer() override
+  {
+    setFramebuffer(new rfb::ManagedPixelBuffer(fbPF, server.width(),
+                                               server.height()));
+  }
+
+  bool dataRect(const core::Rect& r, int encoding) override
+  {
+    if (!CConnection::dataRect(r, encoding))
+      return false;
+    if (encoding == rfb::pseudoEncodingTileCache)
+      tileRects++;
+    return true;
+  }
+
+  void initDone() override {}
+  void getUserPasswd(bool, std::string*, std::string*) override {}
+  bool verifyCertificate(unsigned int, const uint8_t*, size_t) override
+  {
+    return false;
+  }
+  bool verifyHostKey(const uint8_t*, size_t, const char*) override
+  {
+    return false;
+  }
+  void setColourMapEntries(int, int, uint16_t*) override {}
+  void bell() override {}
+  void serverCutText(const char*) override {}
+
+  const rfb::PixelBuffer* framebuffer() { return getFramebuffer(); }
+
+  LoopbackInStream in;
+  rdr::MemOutStream out;
+  int tileRects;
+};
+
+// Every screen has its own content in every tile
+static void drawScreen(rfb::ManagedPixelBuffer* pb, const core::Rect& r,
+                       int screen)
+{
+  uint32_t* data;
+  int stride;
+
+  data = (uint32_t*)pb->getBufferRW(r, &stride);
+  for (int y = 0; y < r.height(); y++) {
+    for (int x = 0; x < r.width(); x++) {
+      uint32_t pixel;
+
+      pixel = (r.tl.x + x) * 2654435761U ^ (r.tl.y + y) * 40503U;
+      pixel ^= screen * 0x9E3779B9U;
+      data[y * stride + x] = pixel & 0xffffff;
+    }
+  }
+  pb->commitBufferRW(r);
+}
+
+TEST(TileCache, roundTrip)
+{
+  const int width = 512, height = 512, screens = 48;
+
+  rfb::ManagedPixelBuffer pb(fbPF, width, height);
+  TestServer server;
+  TestViewer viewer(&server.out, width, height);
+
+  // More tiles in total than fit in the cache, so that tiles are
+  // evicted on both sides and some lookups miss
+  ASSERT_GT((width / 64) * (height / 64) * screens,
+            (int)rfb::TileCache::MaxTiles);
+
+  srand(0);
+
+  for (int i = 0; i < 300; i++) {
+    rfb::UpdateInfo ui;
+    core::Rect r;
+    int screen;
+
+    // Recent screens are more likely to come back
+    if (i < screens)
+      screen = i;
+    else if (rand() % 2)
+      screen = rand() % 8;
+    else
+      screen = rand() % screens;
+
+    // Some updates don't line up with the tiles
+    if (rand() % 4 == 0) {
+      r.tl.x = rand() % width;
+      r.tl.y = rand() % height;
+      r.br.x = r.tl.x + 1 + rand() % (width - r.tl.x);
+      r.br.y = r.tl.y + 1 + rand() % (height - r.tl.y);
+    } else {
+      r = pb.getRect();
+    }
+
+    drawScreen(&pb, r, screen);
+
+    ui.changed = r;
+    server.manager.writeUpdate(ui, &pb, nullptr);
+
+    // An unknown tile will make the viewer throw
+    while (viewer.processMsg())
+      ;
+
+    const uint8_t* expected;
+    const uint8_t* actual;
+    int expectedStride, actualStride;
+
+    expected = pb.getBuffer(pb.getRect(), &expectedStride);
+    actual = viewer.framebuffer()->getBuffer(pb.getRect(),
+                                             &actualStride);
+    for (int y = 0; y < height; y++) {
+      ASSERT_EQ(memcmp(expected + y * expectedStride * 4,
+                       actual + y * actualStride * 4, width * 4), 0)
+        << "Update " << i << " differs on line " << y;
+    }
+  }
+
+  EXPECT_GT(viewer.tileRects, 0);
+}
@@ -0,0 +1,164 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <unistd.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <core/Timer.h>
+
+class TestTimer : public core::Timer, public core::Timer::Callback {
+public:
+  TestTimer(std::vector<int>* fired_, int id_)
+    : core::Timer(this), fired(fired_), id(id_) {}
+  void handleTimeout(core::Timer*) override { fired->push_back(id); }
+
+  std::vector<int>* fired;
+  int id;
+};
+
+static void waitForTimers(int timeout)
+{
+  usleep(timeout * 1000 + 1000);
+  core::Timer::checkTimeouts();
+}
+
+TEST(Timer, order)
+{
+  std::vector<int> fired;
+  std::vector<TestTimer*> timers;
+  const int delays[] = { 40, 10, 30, 20, 50, 0 };
+
+  for (int i = 0; i < 6; i++) {
+    timers.push_back(new TestTimer(&fired, i));
+    timers.back()->start(delays[i]);
+  }
+
+  EXPECT_LE(core::Timer::getNextTimeout(), 0);
+
+  waitForTimers(50);
+
+  EXPECT_EQ(fired, std::vector<int>({ 5, 1, 3, 2, 0, 4 }));
+  EXPECT_EQ(core::Timer::getNextTimeout(), -1);
+
+  for (TestTimer* timer : timers)
+    delete timer;
+}
+
+TEST(Timer, stop)
+{
+  std::vector<int> fired;
+  std::vector<TestTimer*> timers;
+
+  for (int i = 0; i < 20; i++) {
+    timers.push_back(new TestTimer(&fired, i));
+    timers.back()->start(i % 5 * 10);
+  }
+
+  // Stop every third one, from all over the queue
+  for (int i = 0; i < 20; i += 3) {
+    EXPECT_TRUE(timers[i]->isStarted());
+    timers[i]->stop();
+    EXPECT_FALSE(timers[i]->isStarted());
+  }
+
+  // Stopping again should be harmless
+  timers[0]->stop();
+
+  waitForTimers(40);
+
+  EXPECT_EQ(fired, std::vector<int>({ 5, 10, 1, 11, 16, 2, 7, 17,
+                                      8, 13, 4, 14, 19 }));
+
+  for (TestTimer* timer : timers)
+    delete timer;
+}
+
+TEST(Timer, restart)
+{
+  std::vector<int> fired;
+  TestTimer a(&fired, 1), b(&fired, 2);
+
+  a.start(0);
+  b.start(10);
+
+  // Moves it after the other one
+  a.start(20);
+  EXPECT_TRUE(a.isStarted());
+
+  waitForTimers(20);
+
+  EXPECT_EQ(fired, std::vector<int>({ 2, 1 }));
+  EXPECT_FALSE(a.isStarted());
+  EXPECT_FALSE(b.isStarted());
+}
+
+// Restarts itself as if the clock had stepped back in the handler
+class BackwardsTimer : public core::Timer, public core::Timer::Callback {
+public:
+  BackwardsTimer() : core::Timer(this), count(0) {}
+  void handleTimeout(core::Timer*) override
+  {
+    count++;
+    if (count >= 100)
+      return;
+    start(0);
+    dueTime.tv_sec -= 10;
+  }
+
+  int count;
+};
+
+TEST(Timer, clockBackwards)
+{
+  BackwardsTimer a;
+
+  a.start(0);
+
+  waitForTimers(0);
+  EXPECT_EQ(a.count, 1);
+  EXPECT_LE(core::Timer::getNextTimeout(), 0);
+
+  core::Timer::checkTimeouts();
+  EXPECT_EQ(a.count, 2);
+
+  a.stop();
+}
+
+TEST(Timer, destroy)
+{
+  std::vector<int> fired;
+  TestTimer* a;
+  TestTimer b(&fired, 2);
+
+  a = new TestTimer(&fired, 1);
+  a->start(0);
+  b.start(0);
+  delete a;
+
+  waitForTimers(0);
+
+  EXPECT_EQ(fired, std::vector<int>({ 2 }));
+}
@@ -0,0 +1,115 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rfb/UpdateTracker.h>
+
+// A line of text, one rect per glyph
+static core::Region glyphs(int count)
+{
+  core::Region region;
+
+  for (int i = 0; i < count; i++)
+    region.assign_union({{i * 10, 100, i * 10 + 8, 116}});
+
+  return region;
+}
+
+static core::Region getChanged(rfb::SimpleUpdateTracker* tracker)
+{
+  rfb::UpdateInfo ui;
+
+  tracker->getUpdateInfo(&ui, {{0, 0, 100000, 100000}});
+
+  return ui.changed;
+}
+
+TEST(SimpleUpdateTracker, noCoalescing)
+{
+  rfb::SimpleUpdateTracker tracker;
+
+  tracker.add_changed(glyphs(300));
+
+  EXPECT_EQ(getChanged(&tracker).numRects(), 300);
+}
+
+TEST(SimpleUpdateTracker, coalesceNearby)
+{
+  rfb::SimpleUpdateTracker tracker;
+  core::Region changed;
+
+  tracker.setCoalescing(100, 65536);
+  tracker.add_changed(glyphs(300));
+
+  changed = getChanged(&tracker);
+  EXPECT_EQ(changed.numRects(), 1);
+  EXPECT_TRUE(glyphs(300).subtract(changed).is_empty());
+}
+
+TEST(SimpleUpdateTracker, belowLimit)
+{
+  rfb::SimpleUpdateTracker tracker;
+
+  tracker.setCoalescing(100, 65536);
+  tracker.add_changed(glyphs(50));
+
+  EXPECT_EQ(getChanged(&tracker).numRects(), 50);
+}
+
+TEST(SimpleUpdateTracker, keepDistant)
+{
+  rfb::SimpleUpdateTracker tracker;
+  core::Region region;
+  core::Region changed;
+
+  for (int y = 0; y < 20; y++) {
+    for (int x = 0; x < 20; x++)
+      region.assign_union({{x * 100, y * 100, x * 100 + 4, y * 100 + 4}});
+  }
+
+  tracker.setCoalescing(100, 65536);
+  tracker.add_changed(region);
+
+  changed = getChanged(&tracker);
+  EXPECT_EQ(changed, region);
+}
+
+TEST(SimpleUpdateTracker, areaLimit)
+{
+  rfb::SimpleUpdateTracker tracker;
+  std::vector<core::Rect> rects;
+  core::Region changed;
+
+  tracker.setCoalescing(100, 800);
+  tracker.add_changed(glyphs(300));
+
+  changed = getChanged(&tracker);
+  EXPECT_LT(changed.numRects(), 300);
+  EXPECT_TRUE(glyphs(300).subtract(changed).is_empty());
+
+  changed.get_rects(&rects);
+  for (const core::Rect& r : rects)
+    EXPECT_LE(r.area(), 800);
+}
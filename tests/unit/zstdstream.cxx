@@ -0,0 +1,139 @@
+/* Copyright 2026 TigerVNC Team
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307,
+ * USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <rdr/MemInStream.h>
+#include <rdr/MemOutStream.h>
+#include <rdr/ZstdInStream.h>
+#include <rdr/ZstdOutStream.h>
+
+// Every rect is flushed and sent with its compressed length, the same
+// way ZstdRLE does it
+static void writeRect(rdr::ZstdOutStream* zos, rdr::MemOutStream* mem,
+                      rdr::MemOutStream* out,
+                      const std::vector<uint8_t>& data)
+{
+  zos->writeBytes(data.data(), data.size());
+  zos->flush();
+
+  out->writeU32(mem->length());
+  out->writeBytes(mem->data(), mem->length());
+  mem->clear();
+}
+
+static void readRect(rdr::ZstdInStream* zis, rdr::InStream* in,
+                     std::vector<uint8_t>* data)
+{
+  size_t length;
+
+  ASSERT_TRUE(in->hasData(4));
+  length = in->readU32();
+  ASSERT_TRUE(in->hasData(length));
+
+  zis->setUnderlying(in, length);
+  ASSERT_TRUE(zis->hasData(data->size()));
+  zis->readBytes(data->data(), data->size());
+  zis->flushUnderlying();
+  zis->setUnderlying(nullptr, 0);
+}
+
+static std::vector<uint8_t> makeRect(int i)
+{
+  std::vector<uint8_t> data(1000 + i * 137);
+
+  // Partly repeating content, so that later rects can refer back to
+  // earlier ones
+  for (size_t j = 0; j < data.size(); j++) {
+    if (j % 512 < 256)
+      data[j] = j % 64 + i % 3;
+    else
+      data[j] = rand();
+  }
+
+  return data;
+}
+
+TEST(ZstdStream, roundTrip)
+{
+  const int levels[] = { 0, 1, 1, 19, 19, 3, -5, 0 };
+
+  rdr::MemOutStream mem, out;
+  rdr::ZstdOutStream zos(&mem);
+  rdr::ZstdInStream zis;
+
+  srand(0);
+
+  for (int i = 0; i < 40; i++) {
+    std::vector<uint8_t> data, result;
+
+    // The level changes in the middle of the stream, without losing
+    // what has been sent so far
+    zos.setCompressionLevel(levels[i % 8]);
+
+    data = makeRect(i);
+    writeRect(&zos, &mem, &out, data);
+
+    // Each rect must be complete on its own
+    rdr::MemInStream in(out.data(), out.length());
+    result.resize(data.size());
+    readRect(&zis, &in, &result);
+
+    EXPECT_EQ(in.pos(), out.length());
+    EXPECT_EQ(memcmp(data.data(), result.data(), data.size()), 0)
+      << "Rect " << i << " differs";
+
+    out.clear();
+  }
+}
+
+TEST(ZstdStream, reset)
+{
+  rdr::MemOutStream mem, out;
+  rdr::ZstdOutStream zos(&mem);
+  rdr::ZstdInStream zis;
+  std::vector<uint8_t> data, result;
+
+  srand(0);
+
+  data = makeRect(0);
+  writeRect(&zos, &mem, &out, data);
+  zos.reset();
+  writeRect(&zos, &mem, &out, data);
+
+  rdr::MemInStream in(out.data(), out.length());
+  result.resize(data.size());
+
+  readRect(&zis, &in, &result);
+  EXPECT_EQ(memcmp(data.data(), result.data(), data.size()), 0);
+
+  // The second copy is a new stream that decodes on its own
+  zis.reset();
+  readRect(&zis, &in, &result);
+  EXPECT_EQ(memcmp(data.data(), result.data(), data.size()), 0);
+}
@@ -121,6 +121,9 @@ int main(int argc, char** argv)
 
   core::Configuration::removeParam("AcceptSetDesktopSize");
 
+  // We only see the result of a scroll, never the copy itself
+  rfb::Server::detectScroll.setParam(true);
+
   for (int i = 1; i < argc;) {
     int ret;
 
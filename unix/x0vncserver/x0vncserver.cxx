@@ -40,11 +40,13 @@
 #include <rdr/FdInStream.h>
 #include <rdr/FdOutStream.h>
 
+#include <rfb/ServerCore.h>
 #ifdef HAVE_PAM
 #include <rfb/UnixPasswordValidator.h>
 #endif
 #include <rfb/VNCServerST.h>
 
+#include <network/EventLoop.h>
 #include <network/TcpSocket.h>
 #include <network/UnixSocket.h>
 
@@ -316,6 +318,9 @@ int main(int argc, char** argv)
   if (hasSystemdListeners())
     rfbport.setParam(-1);
 
+  // We only see the result of a scroll, never the copy itself
+  rfb::Server::detectScroll.setParam(true);
+
   for (int i = 1; i < argc;) {
     int ret;
 
@@ -430,35 +435,35 @@ int main(int argc, char** argv)
 
     PollingScheduler sched((int)pollingCycle, (int)maxProcessorUsage);
 
+    network::EventLoop loop;
+
+    loop.setFd(ConnectionNumber(dpy), network::EventRead);
+    for (network::SocketListener* listener : listeners)
+      loop.setFd(listener->getFd(), network::EventRead);
+
     while (!caughtSignal) {
-      int wait_ms, nextTimeout;
-      struct timeval tv;
-      fd_set rfds, wfds;
+      int wait_ms;
       std::list<network::Socket*> sockets;
       std::list<network::Socket*>::iterator i;
 
       // Process any incoming X events
       TXWindow::handleXEvents(dpy);
 
-      FD_ZERO(&rfds);
-      FD_ZERO(&wfds);
-
-      FD_SET(ConnectionNumber(dpy), &rfds);
-      for (network::SocketListener* listener : listeners)
-        FD_SET(listener->getFd(), &rfds);
-
       server.getSockets(&sockets);
       int clients_connected = 0;
       for (i = sockets.begin(); i != sockets.end(); i++) {
         if ((*i)->isShutdownRead()) {
+          loop.removeFd((*i)->getFd());
           server.removeSocket(*i);
           delete (*i);
           continue;
         }
 
-        FD_SET((*i)->getFd(), &rfds);
+        // Only wake up for writing if there is something to write
         if ((*i)->outStream().hasBufferedData())
-          FD_SET((*i)->getFd(), &wfds);
+          loop.setFd((*i)->getFd(), network::EventRead | network::EventWrite);
+        else
+          loop.setFd((*i)->getFd(), network::EventRead);
 
         clients_connected++;
       }
@@ -475,32 +480,19 @@ int main(int argc, char** argv)
         }
       }
 
-      // Trigger timers and check when the next will expire
-      nextTimeout = core::Timer::checkTimeouts();
-      if (nextTimeout >= 0 && (wait_ms == -1 || nextTimeout < wait_ms))
-        wait_ms = nextTimeout;
-
-      tv.tv_sec = wait_ms / 1000;
-      tv.tv_usec = (wait_ms % 1000) * 1000;
-
       // Do the wait...
       sched.sleepStarted();
-      int n = select(FD_SETSIZE, &rfds, &wfds, nullptr,
-                     wait_ms >= 0 ? &tv : nullptr);
+      bool interrupted = !loop.wait(wait_ms);
       sched.sleepFinished();
 
-      if (n < 0) {
-        if (errno == EINTR) {
-          vlog.debug("Interrupted select() system call");
-          continue;
-        } else {
-          throw core::socket_error("select", errno);
-        }
+      if (interrupted) {
+        vlog.debug("Interrupted wait for events");
+        continue;
       }
 
       // Accept new VNC connections
       for (network::SocketListener* listener : listeners) {
-        if (FD_ISSET(listener->getFd(), &rfds)) {
+        if (loop.getEvents(listener->getFd()) & network::EventRead) {
           network::Socket* sock = listener->accept();
           if (sock) {
             if (!server.addSocket(sock))
@@ -522,9 +514,10 @@ int main(int argc, char** argv)
 
       // Process events on existing VNC connections
       for (i = sockets.begin(); i != sockets.end(); i++) {
-        if (FD_ISSET((*i)->getFd(), &rfds))
+        int events = loop.getEvents((*i)->getFd());
+        if (events & network::EventRead)
           server.processSocketReadEvent(*i);
-        if (FD_ISSET((*i)->getFd(), &wfds))
+        if (events & network::EventWrite)
           server.processSocketWriteEvent(*i);
       }
 
@@ -73,6 +73,11 @@ core::IntParameter
                         "connection' dialog before rejecting the "
                         "connection"),
                       10, 0, INT_MAX);
+core::BoolParameter
+  backgroundEncoding("BackgroundEncoding",
+                     _("Encode and send updates on background threads "
+                       "rather than the main X server thread"),
+                     false);
 
 
 XserverDesktop::XserverDesktop(int screenIndex_,
@@ -82,7 +87,7 @@ XserverDesktop::XserverDesktop(int screenIndex_,
                                void* fbptr, int stride_)
   : screenIndex(screenIndex_),
     server(0), listeners(listeners_),
-    shadowFramebuffer(nullptr),
+    shadowFramebuffer(nullptr), notifyFd(-1),
     queryConnectId(0), queryConnectTimer(this)
 {
   format = pf;
@@ -92,6 +97,12 @@ XserverDesktop::XserverDesktop(int screenIndex_,
 
   for (network::SocketListener* listener : listeners)
     vncSetNotifyFd(listener->getFd(), screenIndex, true, false);
+
+  if (backgroundEncoding) {
+    notifyFd = server->enableBackgroundUpdates();
+    if (notifyFd != -1)
+      vncSetNotifyFd(notifyFd, screenIndex, true, false);
+  }
 }
 
 XserverDesktop::~XserverDesktop()
@@ -101,6 +112,8 @@ XserverDesktop::~XserverDesktop()
     delete listeners.back();
     listeners.pop_back();
   }
+  if (notifyFd != -1)
+    vncRemoveNotifyFd(notifyFd);
   if (shadowFramebuffer)
     delete [] shadowFramebuffer;
   delete server;
@@ -311,6 +324,11 @@ void XserverDesktop::add_copied(const core::Region& dest,
 void XserverDesktop::handleSocketEvent(int fd, bool read, bool write)
 {
   try {
+    if (read && (fd == notifyFd)) {
+      server->processBackgroundUpdates();
+      return;
+    }
+
     if (read) {
       if (handleListenerEvent(fd))
         return;
@@ -395,6 +413,13 @@ void XserverDesktop::blockHandler(int* timeout)
         continue;
       }
 
+      /* Leave it be until the background update is done, as we'd
+         just have to wait for it anyway */
+      if (server->isSocketBusy(*i)) {
+        vncSetNotifyFd(fd, screenIndex, false, false);
+        continue;
+      }
+
       /* Update existing NotifyFD to listen for write (or not) */
       vncSetNotifyFd(fd, screenIndex, true, (*i)->outStream().hasBufferedData());
     }
@@ -27,6 +27,7 @@
 #include <dix-config.h>
 #endif
 
+#include <list>
 #include <map>
 
 #include <stdint.h>
@@ -122,6 +123,7 @@ private:
   rfb::VNCServer* server;
   std::list<network::SocketListener*> listeners;
   uint8_t* shadowFramebuffer;
+  int notifyFd;
 
   uint32_t queryConnectId;
   network::Socket* queryConnectSocket;
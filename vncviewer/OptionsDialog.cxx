@@ -180,6 +180,10 @@ void OptionsDialog::loadOptions(void)
     jpegButton->setonly();
   else if (preferredEncoding == "ZRLE")
     zrleButton->setonly();
+#ifdef HAVE_ZSTD
+  else if (preferredEncoding == "ZstdRLE")
+    zstdrleButton->setonly();
+#endif
   else if (preferredEncoding == "Hextile")
     hextileButton->setonly();
 #ifdef HAVE_H264
@@ -386,6 +390,10 @@ void OptionsDialog::storeOptions(void)
     preferredEncoding.setParam(rfb::encodingName(rfb::encodingJPEG));
   else if (zrleButton->value())
     preferredEncoding.setParam(rfb::encodingName(rfb::encodingZRLE));
+#ifdef HAVE_ZSTD
+  else if (zstdrleButton->value())
+    preferredEncoding.setParam(rfb::encodingName(rfb::encodingZstdRLE));
+#endif
   else if (hextileButton->value())
     preferredEncoding.setParam(rfb::encodingName(rfb::encodingHextile));
 #ifdef HAVE_H264
@@ -603,6 +611,15 @@ void OptionsDialog::createCompressionPage(int tx, int ty, int tw, int th)
     zrleButton->type(FL_RADIO_BUTTON);
     ty += RADIO_HEIGHT + TIGHT_MARGIN;
 
+#ifdef HAVE_ZSTD
+    zstdrleButton = new Fl_Round_Button(LBLRIGHT(tx, ty,
+                                                 RADIO_MIN_WIDTH,
+                                                 RADIO_HEIGHT,
+                                                 "ZstdRLE"));
+    zstdrleButton->type(FL_RADIO_BUTTON);
+    ty += RADIO_HEIGHT + TIGHT_MARGIN;
+#endif
+
     hextileButton = new Fl_Round_Button(LBLRIGHT(tx, ty,
                                                  RADIO_MIN_WIDTH,
                                                  RADIO_HEIGHT,
@@ -89,6 +89,9 @@ protected:
   Fl_Round_Button *tightButton;
   Fl_Round_Button *jpegButton;
   Fl_Round_Button *zrleButton;
+#ifdef HAVE_ZSTD
+  Fl_Round_Button *zstdrleButton;
+#endif
   Fl_Round_Button *hextileButton;
 #ifdef HAVE_H264
   Fl_Round_Button *h264Button;
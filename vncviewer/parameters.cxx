@@ -118,12 +118,20 @@ core::EnumParameter
                     core::format(
                       "%s (%s)",
                       _("Preferred encoding to use"),
-                      "Tight, JPEG, ZRLE, Hextile, "
+                      "Tight, JPEG, ZRLE, "
+#ifdef HAVE_ZSTD
+                      "ZstdRLE, "
+#endif
+                      "Hextile, "
 #ifdef HAVE_H264
                       "H.264, "
 #endif
                       "Raw)").c_str(),
-                    {"Tight", "JPEG", "ZRLE", "Hextile",
+                    {"Tight", "JPEG", "ZRLE",
+#ifdef HAVE_ZSTD
+                     "ZstdRLE",
+#endif
+                     "Hextile",
 #ifdef HAVE_H264
                      "H.264",
 #endif